@@ -0,0 +1,320 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpu_compositor.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define COMPOSITOR_X86 1
+#else
+    #define COMPOSITOR_X86 0
+#endif
+
+#define COMPOSITOR_MAX_THREADS 8
+
+typedef void (*BlendRow)(Uint32 *dst, const Uint32 *src, int count);
+
+typedef struct {
+    CpuCompositor *owner;
+    SDL_Thread *thread;
+    SDL_sem *start;
+    int first_row;
+    int last_row;
+} CompositorWorker;
+
+struct CpuCompositor {
+    SDL_Texture *target;
+    int width;
+    int height;
+    BlendRow blend_row;
+    const char *kernel_name;
+
+    // Quadro em composição: escrito antes de acordar os workers, só lido por eles.
+    Uint32 *frame;
+    int frame_pitch;
+    const CompositorBlit *blits;
+    int blit_count;
+
+    CompositorWorker workers[COMPOSITOR_MAX_THREADS];
+    int worker_count;
+    SDL_sem *done;
+    SDL_atomic_t quit;
+};
+
+// KERNELS DE MISTURA (ORIGEM SOBRE DESTINO, ALFA PRÉ-MULTIPLICADO):
+static void blend_row_scalar(Uint32 *dst, const Uint32 *src, int count) {
+    for (int i = 0; i < count; i++) {
+        Uint32 s = src[i];
+        Uint32 alpha = s >> 24;
+
+        if (alpha == 255) {
+            dst[i] = s;
+            continue;
+        }
+        if (s == 0) continue;
+
+        // Dois canais por multiplicação; x / 255 arredondado como (x + 128 + ((x + 128) >> 8)) >> 8.
+        Uint32 inv = 255 - alpha;
+        Uint32 d = dst[i];
+        Uint32 rb = (d & 0x00FF00FFu) * inv + 0x00800080u;
+        Uint32 ag = ((d >> 8) & 0x00FF00FFu) * inv + 0x00800080u;
+        rb = ((rb + ((rb >> 8) & 0x00FF00FFu)) >> 8) & 0x00FF00FFu;
+        ag = (ag + ((ag >> 8) & 0x00FF00FFu)) & 0xFF00FF00u;
+
+        dst[i] = s + (rb | ag);
+    }
+}
+
+#if COMPOSITOR_X86
+__attribute__((target("sse2")))
+static void blend_row_sse2(Uint32 *dst, const Uint32 *src, int count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i opaque = _mm_set1_epi32(255);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(s, 24), opaque)) == 0xFFFF) {
+            _mm_storeu_si128((__m128i *)(dst + i), s);
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF) continue;
+
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+        __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+        __m128i inv_lo = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)));
+        __m128i inv_hi = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)));
+
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv_lo), round);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv_hi), round);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+        __m128i out = _mm_add_epi8(_mm_packus_epi16(lo, hi), s);
+        _mm_storeu_si128((__m128i *)(dst + i), out);
+    }
+
+    blend_row_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void blend_row_avx2(Uint32 *dst, const Uint32 *src, int count) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi16(255);
+    const __m256i round = _mm256_set1_epi16(128);
+    const __m256i opaque = _mm256_set1_epi32(255);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_srli_epi32(s, 24), opaque)) == -1) {
+            _mm256_storeu_si256((__m256i *)(dst + i), s);
+            continue;
+        }
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(s, zero)) == -1) continue;
+
+        // unpack/pack trabalham por metade de 128 bits, então a ordem dos pixels se preserva.
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i s_lo = _mm256_unpacklo_epi8(s, zero);
+        __m256i s_hi = _mm256_unpackhi_epi8(s, zero);
+        __m256i inv_lo = _mm256_sub_epi16(full, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)));
+        __m256i inv_hi = _mm256_sub_epi16(full, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)));
+
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inv_lo), round);
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inv_hi), round);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+        __m256i out = _mm256_add_epi8(_mm256_packus_epi16(lo, hi), s);
+        _mm256_storeu_si256((__m256i *)(dst + i), out);
+    }
+
+    blend_row_sse2(dst + i, src + i, count - i);
+}
+#endif
+
+// COMPOSIÇÃO POR FAIXA DE LINHAS:
+static void compose_band(CpuCompositor *compositor, int first_row, int last_row) {
+    for (int y = first_row; y < last_row; y++) {
+        Uint32 *row = compositor->frame + y * compositor->frame_pitch;
+        for (int x = 0; x < compositor->width; x++) {
+            row[x] = 0xFF000000u;
+        }
+    }
+
+    for (int i = 0; i < compositor->blit_count; i++) {
+        const CompositorBlit *blit = &compositor->blits[i];
+
+        int x0 = SDL_max(blit->dst_x, 0);
+        int x1 = SDL_min(blit->dst_x + blit->src.w, compositor->width);
+        int y0 = SDL_max(blit->dst_y, first_row);
+        int y1 = SDL_min(blit->dst_y + blit->src.h, last_row);
+        if (x0 >= x1 || y0 >= y1) continue;
+
+        for (int y = y0; y < y1; y++) {
+            const Uint32 *src = blit->pixels + (blit->src.y + y - blit->dst_y) * blit->pitch + blit->src.x + (x0 - blit->dst_x);
+            Uint32 *dst = compositor->frame + y * compositor->frame_pitch + x0;
+            compositor->blend_row(dst, src, x1 - x0);
+        }
+    }
+}
+
+static int compositor_worker(void *data) {
+    CompositorWorker *worker = data;
+    CpuCompositor *compositor = worker->owner;
+
+    for (;;) {
+        SDL_SemWait(worker->start);
+        if (SDL_AtomicGet(&compositor->quit)) break;
+
+        compose_band(compositor, worker->first_row, worker->last_row);
+        SDL_SemPost(compositor->done);
+    }
+
+    return 0;
+}
+
+CpuCompositor *cpu_compositor_create(SDL_Renderer *render, int width, int height) {
+    CpuCompositor *compositor = calloc(1, sizeof(*compositor));
+    if (!compositor) {
+        fprintf(stderr, "Out of memory creating the CPU compositor.\n");
+        return NULL;
+    }
+    compositor->width = width;
+    compositor->height = height;
+
+    compositor->target = SDL_CreateTexture(render, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (!compositor->target) {
+        fprintf(stderr, "Error creating compositor texture: %s\n", SDL_GetError());
+        free(compositor);
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(compositor->target, SDL_BLENDMODE_NONE);
+
+    compositor->blend_row = blend_row_scalar;
+    compositor->kernel_name = "scalar";
+#if COMPOSITOR_X86
+    if (SDL_HasAVX2()) {
+        compositor->blend_row = blend_row_avx2;
+        compositor->kernel_name = "AVX2";
+    }
+    else if (SDL_HasSSE2()) {
+        compositor->blend_row = blend_row_sse2;
+        compositor->kernel_name = "SSE2";
+    }
+#endif
+
+    // Um worker por núcleo extra; a thread principal fica com a última faixa.
+    int threads = SDL_clamp(SDL_GetCPUCount() - 1, 0, COMPOSITOR_MAX_THREADS);
+    compositor->done = threads > 0 ? SDL_CreateSemaphore(0) : NULL;
+    if (threads > 0 && !compositor->done) threads = 0;
+
+    int bands = threads + 1;
+    for (int i = 0; i < threads; i++) {
+        CompositorWorker *worker = &compositor->workers[i];
+        worker->owner = compositor;
+        worker->first_row = height * i / bands;
+        worker->last_row = height * (i + 1) / bands;
+        worker->start = SDL_CreateSemaphore(0);
+        worker->thread = worker->start ? SDL_CreateThread(compositor_worker, "compositor", worker) : NULL;
+        if (!worker->thread) {
+            if (worker->start) SDL_DestroySemaphore(worker->start);
+            worker->start = NULL;
+            break;
+        }
+        compositor->worker_count++;
+    }
+
+    // Se alguma thread falhou, as faixas são redistribuídas entre as que subiram.
+    bands = compositor->worker_count + 1;
+    for (int i = 0; i < compositor->worker_count; i++) {
+        compositor->workers[i].first_row = height * i / bands;
+        compositor->workers[i].last_row = height * (i + 1) / bands;
+    }
+
+    return compositor;
+}
+
+void cpu_compositor_destroy(CpuCompositor *compositor) {
+    if (!compositor) return;
+
+    SDL_AtomicSet(&compositor->quit, 1);
+    for (int i = 0; i < compositor->worker_count; i++) {
+        SDL_SemPost(compositor->workers[i].start);
+        SDL_WaitThread(compositor->workers[i].thread, NULL);
+        SDL_DestroySemaphore(compositor->workers[i].start);
+    }
+    if (compositor->done) SDL_DestroySemaphore(compositor->done);
+    if (compositor->target) SDL_DestroyTexture(compositor->target);
+
+    free(compositor);
+}
+
+SDL_Texture *cpu_compositor_render(CpuCompositor *compositor, const CompositorBlit *blits, int count) {
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(compositor->target, NULL, &pixels, &pitch) != 0) {
+        fprintf(stderr, "Error locking compositor texture: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    compositor->frame = pixels;
+    compositor->frame_pitch = pitch / (int)sizeof(Uint32);
+    compositor->blits = blits;
+    compositor->blit_count = count;
+
+    for (int i = 0; i < compositor->worker_count; i++) {
+        SDL_SemPost(compositor->workers[i].start);
+    }
+
+    int bands = compositor->worker_count + 1;
+    compose_band(compositor, compositor->height * compositor->worker_count / bands, compositor->height);
+
+    for (int i = 0; i < compositor->worker_count; i++) {
+        SDL_SemWait(compositor->done);
+    }
+
+    SDL_UnlockTexture(compositor->target);
+    return compositor->target;
+}
+
+const char *cpu_compositor_kernel_name(const CpuCompositor *compositor) {
+    return compositor->kernel_name;
+}
+
+SDL_Surface *cpu_compositor_load_image(const char *dir, Uint8 opacity) {
+    SDL_Surface *loaded = IMG_Load(dir);
+    if (!loaded) {
+        fprintf(stderr, "Error loading image '%s': %s\n", dir, IMG_GetError());
+        return NULL;
+    }
+
+    SDL_Surface *surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loaded);
+    if (!surface) {
+        fprintf(stderr, "Error converting image '%s': %s\n", dir, SDL_GetError());
+        return NULL;
+    }
+
+    // A opacidade da camada entra no alfa antes da pré-multiplicação.
+    for (int y = 0; y < surface->h; y++) {
+        Uint32 *row = (Uint32 *)((Uint8 *)surface->pixels + y * surface->pitch);
+        for (int x = 0; x < surface->w; x++) {
+            Uint32 p = row[x];
+            Uint32 a = ((p >> 24) * opacity + 127) / 255;
+            Uint32 r = (((p >> 16) & 0xFF) * a + 127) / 255;
+            Uint32 g = (((p >> 8) & 0xFF) * a + 127) / 255;
+            Uint32 b = ((p & 0xFF) * a + 127) / 255;
+            row[x] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+
+    return surface;
+}
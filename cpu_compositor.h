@@ -0,0 +1,24 @@
+#ifndef CPU_COMPOSITOR_H
+#define CPU_COMPOSITOR_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Uma cópia 1:1 de uma imagem ARGB8888 com alfa pré-multiplicado para a tela.
+typedef struct {
+    const Uint32 *pixels;
+    int pitch;
+    SDL_Rect src;
+    int dst_x;
+    int dst_y;
+} CompositorBlit;
+
+typedef struct CpuCompositor CpuCompositor;
+
+CpuCompositor *cpu_compositor_create(SDL_Renderer *render, int width, int height);
+void cpu_compositor_destroy(CpuCompositor *compositor);
+SDL_Texture *cpu_compositor_render(CpuCompositor *compositor, const CompositorBlit *blits, int count);
+const char *cpu_compositor_kernel_name(const CpuCompositor *compositor);
+SDL_Surface *cpu_compositor_load_image(const char *dir, Uint8 opacity);
+
+#endif
@@ -0,0 +1,270 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "frame_capture.h"
+
+#if defined(_WIN32)
+  #include <direct.h>
+  #define make_directory(path) _mkdir(path)
+#else
+  #include <sys/stat.h>
+  #define make_directory(path) mkdir(path, 0755)
+#endif
+
+#define CAPTURE_SLOTS 8
+#define CAPTURE_MAX_THREADS 4
+
+typedef struct {
+    Uint32 *pixels;
+    Uint64 frame;
+} CaptureSlot;
+
+struct FrameCapture {
+    int format;
+    int width;
+    int height;
+    char prefix[256];
+
+    // Y4M é um fluxo único: um só worker escreve, em ordem, e repete o último quadro nos buracos.
+    FILE *stream;
+    Uint8 *yuv;
+    Uint64 next_frame;
+
+    // Buffers alocados uma vez; o jogo só copia para um slot livre e nunca espera o disco.
+    CaptureSlot slots[CAPTURE_SLOTS];
+    int free_slots[CAPTURE_SLOTS];
+    int free_count;
+    int pending[CAPTURE_SLOTS];
+    int pending_head;
+    int pending_count;
+    SDL_mutex *lock;
+    SDL_cond *ready;
+    bool stopping;
+
+    SDL_Thread *workers[CAPTURE_MAX_THREADS];
+    int worker_count;
+
+    Uint64 frames;
+    Uint64 written;
+    Uint64 dropped;
+    Uint64 failed;
+};
+
+// CODIFICAÇÃO:
+static void convert_to_yuv420(const FrameCapture *capture, const Uint32 *pixels, Uint8 *yuv) {
+    int w = capture->width, h = capture->height;
+    Uint8 *plane_y = yuv;
+    Uint8 *plane_u = yuv + w * h;
+    Uint8 *plane_v = plane_u + (w / 2) * (h / 2);
+
+    // BT.601 em faixa limitada; o croma é a média de cada bloco 2x2.
+    for (int y = 0; y < h; y += 2) {
+        for (int x = 0; x < w; x += 2) {
+            int sum_r = 0, sum_g = 0, sum_b = 0;
+            for (int dy = 0; dy < 2; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    Uint32 p = pixels[(y + dy) * w + x + dx];
+                    int r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+                    plane_y[(y + dy) * w + x + dx] = (Uint8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                    sum_r += r;
+                    sum_g += g;
+                    sum_b += b;
+                }
+            }
+            int r = sum_r / 4, g = sum_g / 4, b = sum_b / 4;
+            plane_u[(y / 2) * (w / 2) + x / 2] = (Uint8)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            plane_v[(y / 2) * (w / 2) + x / 2] = (Uint8)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+static bool write_y4m_frame(FrameCapture *capture) {
+    size_t size = (size_t)capture->width * capture->height * 3 / 2;
+    return fputs("FRAME\n", capture->stream) >= 0 && fwrite(capture->yuv, 1, size, capture->stream) == size;
+}
+
+static bool encode_slot(FrameCapture *capture, const CaptureSlot *slot) {
+    if (capture->format == CAPTURE_Y4M) {
+        // Quadros descartados viram cópias do anterior para o vídeo manter a duração real.
+        bool ok = true;
+        while (capture->next_frame > 0 && capture->next_frame < slot->frame && ok) {
+            ok = write_y4m_frame(capture);
+            capture->next_frame++;
+        }
+        convert_to_yuv420(capture, slot->pixels, capture->yuv);
+        capture->next_frame = slot->frame + 1;
+        return ok && write_y4m_frame(capture);
+    }
+
+    char path[300];
+    snprintf(path, sizeof(path), "%s-%06llu.png", capture->prefix, (unsigned long long)slot->frame);
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom(slot->pixels, capture->width, capture->height, 32, capture->width * 4, SDL_PIXELFORMAT_ARGB8888);
+    if (!surface) return false;
+    bool ok = IMG_SavePNG(surface, path) == 0;
+    SDL_FreeSurface(surface);
+    return ok;
+}
+
+static int capture_worker(void *data) {
+    FrameCapture *capture = data;
+
+    for (;;) {
+        SDL_LockMutex(capture->lock);
+        while (capture->pending_count == 0 && !capture->stopping) {
+            SDL_CondWait(capture->ready, capture->lock);
+        }
+        // Ao parar, os workers ainda esvaziam a fila antes de sair.
+        if (capture->pending_count == 0) {
+            SDL_UnlockMutex(capture->lock);
+            break;
+        }
+        int index = capture->pending[capture->pending_head];
+        capture->pending_head = (capture->pending_head + 1) % CAPTURE_SLOTS;
+        capture->pending_count--;
+        SDL_UnlockMutex(capture->lock);
+
+        bool ok = encode_slot(capture, &capture->slots[index]);
+
+        SDL_LockMutex(capture->lock);
+        capture->free_slots[capture->free_count++] = index;
+        if (ok) capture->written++;
+        else capture->failed++;
+        SDL_UnlockMutex(capture->lock);
+    }
+
+    return 0;
+}
+
+// INTERFACE:
+FrameCapture *frame_capture_start(const char *dir, int width, int height, int format, int fps) {
+    if (width <= 0 || height <= 0 || (format == CAPTURE_Y4M && (width % 2 || height % 2))) {
+        fprintf(stderr, "Error starting capture: invalid frame size %dx%d\n", width, height);
+        return NULL;
+    }
+
+    FrameCapture *capture = calloc(1, sizeof(FrameCapture));
+    if (!capture) {
+        fprintf(stderr, "Error allocating frame capture.\n");
+        return NULL;
+    }
+    capture->format = format;
+    capture->width = width;
+    capture->height = height;
+
+    make_directory(dir);
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    snprintf(capture->prefix, sizeof(capture->prefix), "%s/%s", dir, stamp);
+
+    for (int i = 0; i < CAPTURE_SLOTS; i++) {
+        capture->slots[i].pixels = malloc((size_t)width * height * sizeof(Uint32));
+        if (!capture->slots[i].pixels) {
+            fprintf(stderr, "Error allocating capture buffers.\n");
+            frame_capture_stop(capture);
+            return NULL;
+        }
+        capture->free_slots[capture->free_count++] = i;
+    }
+
+    if (format == CAPTURE_Y4M) {
+        char path[300];
+        snprintf(path, sizeof(path), "%s.y4m", capture->prefix);
+        capture->stream = fopen(path, "wb");
+        capture->yuv = malloc((size_t)width * height * 3 / 2);
+        if (!capture->stream || !capture->yuv) {
+            fprintf(stderr, "Error opening capture file %s\n", path);
+            frame_capture_stop(capture);
+            return NULL;
+        }
+        fprintf(capture->stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps > 0 ? fps : 60);
+    }
+
+    capture->lock = SDL_CreateMutex();
+    capture->ready = SDL_CreateCond();
+    if (!capture->lock || !capture->ready) {
+        fprintf(stderr, "Error creating capture lock: %s\n", SDL_GetError());
+        frame_capture_stop(capture);
+        return NULL;
+    }
+
+    // PNGs são independentes e se dividem entre núcleos; deixa um livre para o jogo.
+    int threads = 1;
+    if (format == CAPTURE_PNG) threads = SDL_max(1, SDL_min(SDL_GetCPUCount() - 1, CAPTURE_MAX_THREADS));
+    for (int i = 0; i < threads; i++) {
+        capture->workers[capture->worker_count] = SDL_CreateThread(capture_worker, "capture", capture);
+        if (!capture->workers[capture->worker_count]) {
+            fprintf(stderr, "Error creating capture thread: %s\n", SDL_GetError());
+            break;
+        }
+        capture->worker_count++;
+    }
+    if (capture->worker_count == 0) {
+        frame_capture_stop(capture);
+        return NULL;
+    }
+
+    fprintf(stderr, "Capturing %s to %s%s\n", format == CAPTURE_Y4M ? "Y4M" : "PNG frames", capture->prefix, format == CAPTURE_Y4M ? ".y4m" : "-*.png");
+    return capture;
+}
+
+bool frame_capture_grab(FrameCapture *capture, SDL_Renderer *render) {
+    SDL_LockMutex(capture->lock);
+    Uint64 frame = capture->frames++;
+    if (capture->free_count == 0) {
+        // Disco atrasado: perde o quadro em vez de travar o loop do jogo.
+        capture->dropped++;
+        SDL_UnlockMutex(capture->lock);
+        return false;
+    }
+    int index = capture->free_slots[--capture->free_count];
+    SDL_UnlockMutex(capture->lock);
+
+    CaptureSlot *slot = &capture->slots[index];
+    SDL_Rect area = {0, 0, capture->width, capture->height};
+    bool ok = SDL_RenderReadPixels(render, &area, SDL_PIXELFORMAT_ARGB8888, slot->pixels, capture->width * 4) == 0;
+    slot->frame = frame;
+
+    SDL_LockMutex(capture->lock);
+    if (ok) {
+        capture->pending[(capture->pending_head + capture->pending_count) % CAPTURE_SLOTS] = index;
+        capture->pending_count++;
+        SDL_CondSignal(capture->ready);
+    }
+    else {
+        capture->free_slots[capture->free_count++] = index;
+        capture->failed++;
+    }
+    SDL_UnlockMutex(capture->lock);
+
+    return ok;
+}
+
+void frame_capture_stop(FrameCapture *capture) {
+    if (!capture) return;
+
+    if (capture->lock) {
+        SDL_LockMutex(capture->lock);
+        capture->stopping = true;
+        SDL_CondBroadcast(capture->ready);
+        SDL_UnlockMutex(capture->lock);
+    }
+    for (int i = 0; i < capture->worker_count; i++) {
+        SDL_WaitThread(capture->workers[i], NULL);
+    }
+
+    if (capture->worker_count > 0) {
+        fprintf(stderr, "Capture finished: %llu frames written, %llu dropped, %llu failed\n",
+                (unsigned long long)capture->written, (unsigned long long)capture->dropped, (unsigned long long)capture->failed);
+    }
+
+    if (capture->stream) fclose(capture->stream);
+    if (capture->ready) SDL_DestroyCond(capture->ready);
+    if (capture->lock) SDL_DestroyMutex(capture->lock);
+    for (int i = 0; i < CAPTURE_SLOTS; i++) free(capture->slots[i].pixels);
+    free(capture->yuv);
+    free(capture);
+}
@@ -0,0 +1,18 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+enum {
+    CAPTURE_PNG,
+    CAPTURE_Y4M
+};
+
+typedef struct FrameCapture FrameCapture;
+
+FrameCapture *frame_capture_start(const char *dir, int width, int height, int format, int fps);
+bool frame_capture_grab(FrameCapture *capture, SDL_Renderer *render);
+void frame_capture_stop(FrameCapture *capture);
+
+#endif
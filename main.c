@@ -8,12 +8,16 @@
 #include <stdbool.h>
 #include <math.h>
 #include <string.h>
+#include <limits.h>
 #include <time.h>
 #include <stdarg.h>
 #include <locale.h>
 #include <wchar.h>
 #include <wctype.h>
 #include "get_username.h"
+#include "cpu_compositor.h"
+#include "frame_capture.h"
+#include "render_stats.h"
 
 // TELA:
 #define SCREEN_WIDTH 640
@@ -21,20 +25,34 @@
 
 // RENDERIZAÇÃO:
 #define WINDOW_FLAGS (SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE)
-#define RENDERER_FLAGS (SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC)
+#define RENDERER_FLAGS (SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE)
 #define IMAGE_FLAGS (IMG_INIT_PNG)
 #define MIXER_FLAGS (MIX_INIT_MP3 | MIX_INIT_OGG)
 
 // QUANTIDADES:
 #define SURFACE_QUANTITY 13
-#define COLLISION_QUANTITY 13
+#define TERRAIN_QUANTITY 10
+#define COLLISION_QUANTITY 3
 #define DIRECTION_AMOUNT 4
-#define DIALOGUE_AMOUNT 27
+#define DIALOGUE_AMOUNT 15
+#define TYPEWRITER_AMOUNT 2
 #define ENEMY_AMOUNT 1
 #define NPC_AMOUNT 2
-#define SOUND_AMOUNT 14
+#define SOUND_AMOUNT 5
+#define SCENE_AMOUNT 6
 #define ENEMY_STATES 4
 #define ENEMY_PARTS 4
+#define BATTLE_BUTTONS 4
+#define MAX_ENEMY_COMPOSITES 32
+#define ENEMY_BOB_SAMPLES 64
+#define RIPPLE_TABLE_SIZE 64
+#define RIPPLE_AMPLITUDE 2
+#define RIPPLE_STRIP 2
+#define RIPPLE_ROW_STEP 5
+#define RIPPLE_SPEED 20.0
+#define PARTICLE_CAPACITY 512
+#define MAX_PARTICLE_POOLS 4
+#define MAX_EMITTERS 16
 #define FACE_AMOUNT 5
 #define INPUT_DELAY 0.2
 
@@ -44,12 +62,48 @@
 #define MAX_DIALOGUE_STR 20
 #define MAX_CUTSCENE_FRAMES 25
 #define MAX_INVENTORY_SIZE 10
+#define MAX_GLYPH_CACHES 4
+#define NUMBER_FONT_GLYPHS 11
+#define MAX_TEXT_OPS 8192
+#define MAX_TEXT_SCRIPTS 128
+#define MAX_RENDER_COMMANDS 1024
+#define BACKGROUND_CACHE_PIECES 256
+#define MAX_PARALLAX_LAYERS 16
+#define MAX_LAYER_RUNS 64
+#define OCCLUSION_CELL 16
+#define OCCLUSION_COLUMNS (SCREEN_WIDTH / OCCLUSION_CELL)
+#define OCCLUSION_ROWS (SCREEN_HEIGHT / OCCLUSION_CELL)
+#define MAX_DEPTH_ENTRIES 64
+#define TILE_SIZE 16
+#define CHUNK_TILES 16
+#define TILESET_COLUMNS 32
+#define GLYPH_CACHE_SIZE 384
+#define GLYPH_CACHE_EXTRA 32
+#define GLYPH_ATLAS_SIZE 512
 
 // GRANDEZAS:
 #define BASE_FONT_SIZE 24
 #define BUBBLE_FONT_SIZE 14
 #define SFX_VOLUME 45
 #define MUSIC_VOLUME 30
+#define DIALOGUE_PREPARE_BUDGET 6
+#define IDLE_MAX_WAIT 1.0
+#define DEFAULT_FPS_CAP 60.0
+#define PACER_SPIN_MARGIN 0.002
+#define PACER_REPORT_INTERVAL 5.0
+#define SIM_RATE 60.0
+#define SIM_MAX_STEPS 8
+#define RENDER_SCALE_MIN 0.5
+#define RENDER_SCALE_STEP 0.125
+#define RENDER_SCALE_DROP_TIME 0.25
+#define RENDER_SCALE_RAISE_TIME 2.0
+#define RENDER_SCALE_RAISE_MAX 16.0
+#define CALIBRATION_TIME 0.75
+#define CALIBRATION_SPRITES 96
+#define CALIBRATION_FILE "renderer.cfg"
+#define PREF_ORGANIZATION "danilocb21"
+#define PREF_APPLICATION "C-Tale"
+#define CAPTURE_DIR "captures"
 
 // CANAIS:
 #define DEFAULT_CHANNEL -1
@@ -60,10 +114,57 @@
 // TÍTULO:
 #define GAME_TITLE "C-Tale: Meneghetti Vs Python"
 
+// RITMO DE QUADROS:
+typedef struct {
+    int mode;
+    double target_fps;
+    Uint64 frequency;
+    Uint64 period;
+    Uint64 last_counter;
+    Uint64 next_deadline;
+    double frame_min;
+    double frame_max;
+    double frame_sum;
+    double frame_sum_sq;
+    int frame_samples;
+    double report_timer;
+} FramePacer;
+
+// RELÓGIO DA SIMULAÇÃO (PASSOS FIXOS DE 1 / SIM_RATE):
+typedef struct {
+    double accumulator;
+    int steps;
+    double alpha;
+} SimClock;
+
+// POSIÇÃO NOS DOIS ÚLTIMOS PASSOS, PARA DESENHAR ENTRE ELES:
+typedef struct {
+    float x;
+    float y;
+    float prev_x;
+    float prev_y;
+    bool placed;
+} Motion;
+
+// RESOLUÇÃO INTERNA E ESCALA DINÂMICA DO FUNDO:
+typedef struct {
+    SDL_Texture *scene;
+    SDL_Texture *background;
+    double scale;
+    double budget;
+    double over_budget;
+    double under_budget;
+    double raise_delay;
+} RenderPipeline;
+
 // BASE DO JOGO:
 typedef struct {
     SDL_Window *window;
     SDL_Renderer *renderer;
+    FramePacer pacer;
+    bool cpu_compositor;
+    bool calibrate;
+    int capture_format;
     int game_state;
     int last_game_state;
     bool debug_mode;
@@ -78,20 +179,258 @@ typedef struct {
     int count;
 } Animation;
 
-// PARÂMETROS DE DIÁLOGO:
+// COMANDO DE DESENHO ADIADO:
+typedef struct {
+    Uint8 type;
+    int layer;
+    int depth;
+    Uint32 sequence;
+    SDL_Texture *texture;
+    SDL_BlendMode blend;
+    SDL_Color color;
+    SDL_Rect src;
+    bool has_src;
+    SDL_FRect dst;
+    double angle;
+    SDL_RendererFlip flip;
+    const SDL_Vertex *vertices;
+    const int *indices;
+    int vertex_count;
+    int index_count;
+} RenderCommand;
+
+// CAMADA DE PARALLAX (CARREGADA DE ARQUIVO):
+typedef struct {
+    char name[32];
+    Animation animation;
+    double frame_time;
+    double factor_x;
+    double factor_y;
+    double velocity_x;
+    double velocity_y;
+    double scroll_x;
+    double scroll_y;
+    int wrap;
+    int w;
+    int h;
+    bool cached;
+    char pattern[256];
+    Uint8 opacity;
+    SDL_Surface **pixels;
+    Uint8 *opaque;
+    int opaque_w;
+    int opaque_h;
+} ParallaxLayer;
+
+typedef struct {
+    ParallaxLayer layers[MAX_PARALLAX_LAYERS];
+    int count;
+} LayerStack;
+
+// MAPA DE TILES EM CHUNKS:
+typedef struct {
+    SDL_Vertex *vertices;
+    int quad_count;
+} TileChunk;
+
+typedef struct {
+    SDL_Texture *tileset;
+    int width;
+    int height;
+    int chunks_w;
+    int chunks_h;
+    Uint16 *tiles;
+    Sint8 *materials; // Um por pixel do mapa (-1 = sem material), para os passos mudarem na borda exata.
+    Uint16 (*masks)[TILE_SIZE];
+    Uint8 *opaque;
+    TileChunk *chunks;
+    SDL_Vertex *scratch;
+    int *indices;
+    int scratch_quads;
+} Tilemap;
+
+// MÁSCARA DE OCLUSÃO DA TELA (CÉLULAS JÁ COBERTAS POR PIXELS OPACOS):
+typedef struct {
+    bool covered[OCCLUSION_ROWS][OCCLUSION_COLUMNS];
+} OcclusionGrid;
+
+// LISTA PERSISTENTE DE SPRITES ORDENADOS POR PROFUNDIDADE:
+typedef struct {
+    SDL_Texture **texture;
+    const SDL_Rect *rect;
+    int depth;
+    bool visible;
+} DepthEntry;
+
+typedef struct {
+    DepthEntry entries[MAX_DEPTH_ENTRIES];
+    int order[MAX_DEPTH_ENTRIES];
+    int count;
+} DepthList;
+
+// REFLEXO NA ÁGUA (SPRITE ESPELHADO EM RENDER TARGET, DESENHADO EM FAIXAS):
+typedef struct {
+    SDL_Texture *target;
+    SDL_Texture *source;
+    int w;
+    int h;
+    Uint8 alpha;
+    double timer;
+    int phase;
+    Sint8 ripple[RIPPLE_TABLE_SIZE];
+} WaterReflection;
+
+// EMISSOR DE PARTÍCULAS (CARREGADO DE ARQUIVO):
+typedef struct {
+    char name[32];
+    int pool;
+    int burst;
+    double rate;
+    double accumulator;
+    float life_min;
+    float life_max;
+    float speed_min;
+    float speed_max;
+    float direction;
+    float spread;
+    float gravity;
+    float size_start;
+    float size_end;
+    SDL_Color color_start;
+    SDL_Color color_end;
+} ParticleEmitter;
+
+// POOL DE PARTÍCULAS DE UMA TEXTURA (ESTRUTURA DE ARRAYS, CAPACIDADE FIXA):
+typedef struct {
+    char image[256];
+    SDL_Texture *texture;
+    bool owned;
+    int count;
+    float x[PARTICLE_CAPACITY];
+    float y[PARTICLE_CAPACITY];
+    float vx[PARTICLE_CAPACITY];
+    float vy[PARTICLE_CAPACITY];
+    float age[PARTICLE_CAPACITY];
+    float life[PARTICLE_CAPACITY];
+    Uint8 emitter[PARTICLE_CAPACITY];
+    SDL_Vertex vertices[PARTICLE_CAPACITY * 4];
+    int indices[PARTICLE_CAPACITY * 6];
+} ParticlePool;
+
+typedef struct {
+    ParticlePool pools[MAX_PARTICLE_POOLS];
+    int pool_count;
+    ParticleEmitter emitters[MAX_EMITTERS];
+    int emitter_count;
+} ParticleSystem;
+
+// CACHE DO FUNDO ESTÁTICO (RENDER TARGET):
+typedef struct {
+    SDL_Texture *target;
+    SDL_Texture *textures[BACKGROUND_CACHE_PIECES];
+    SDL_Rect srcs[BACKGROUND_CACHE_PIECES];
+    SDL_Rect rects[BACKGROUND_CACHE_PIECES];
+    int count;
+    bool valid;
+} BackgroundCache;
+
+// HUD DA BATALHA EM RENDER TARGET (REDESENHADO SÓ QUANDO MUDA):
+typedef struct {
+    SDL_Texture *target;
+    SDL_Rect box;
+    int health;
+    SDL_Texture *buttons[BATTLE_BUTTONS];
+    SDL_Rect bounds;
+    SDL_Texture *previous;
+    bool valid;
+} BattleHudCache;
+
+// FONTE DE NÚMEROS (DÍGITOS 0-9 E '/'):
+typedef struct {
+    SDL_Texture *glyphs[NUMBER_FONT_GLYPHS];
+    int widths[NUMBER_FONT_GLYPHS];
+    int height;
+    int spacing;
+} NumberFont;
+
+// GLIFO PRÉ-RENDERIZADO (REGIÃO NO ATLAS DA FONTE):
+typedef struct {
+    SDL_Rect src;
+    int w, h;
+    bool loaded;
+} Glyph;
+
+// CACHE DE GLIFOS (POR FONTE, GLIFOS BRANCOS COLORIDOS POR VÉRTICE):
+typedef struct {
+    TTF_Font *font;
+    SDL_Texture *atlas;
+    int pen_x, pen_y, row_h;
+    Glyph glyphs[GLYPH_CACHE_SIZE];
+    Uint32 extra_codepoints[GLYPH_CACHE_EXTRA];
+    Glyph extra_glyphs[GLYPH_CACHE_EXTRA];
+    int extra_count;
+} GlyphCache;
+
+// OPERAÇÃO DE TEXTO COMPILADA A PARTIR DA MARCAÇÃO:
+typedef struct {
+    Uint8 type;
+    char utf8[5];
+    Uint32 codepoint;
+    float value;
+    SDL_Color color;
+} TextOp;
+
+// FALA COMPILADA (SEQUÊNCIA DE OPERAÇÕES):
+typedef struct {
+    const TextOp *ops;
+    int count;
+} TextScript;
+
+// LINHA DE DIÁLOGO PREPARADA (GLIFOS + LAYOUT):
+typedef struct {
+    const Glyph *glyphs[MAX_DIALOGUE_CHAR];
+    Uint8 kinds[MAX_DIALOGUE_CHAR];
+    Uint8 effects[MAX_DIALOGUE_CHAR];
+    SDL_Color colors[MAX_DIALOGUE_CHAR];
+    Sint16 offset_x[MAX_DIALOGUE_CHAR];
+    Sint16 offset_y[MAX_DIALOGUE_CHAR];
+    int count;
+    int fit_count;
+    int source_str;
+    int cursor;
+    int wrap_w, wrap_h;
+    SDL_Color pen_color;
+    int pen_speaker;
+    bool ready;
+} DialogueLine;
+
+// PARÂMETROS DE DIÁLOGO (IMUTÁVEIS):
 typedef struct {
-    char *writings[MAX_DIALOGUE_STR];
-    int on_frame[MAX_DIALOGUE_STR];
+    const char **writings;
+    const int *on_frame;
     TTF_Font *text_font;
     SDL_Color text_color;
-    SDL_Texture *chars[MAX_DIALOGUE_CHAR];
-    char chars_string[MAX_DIALOGUE_CHAR][5];
+    const TextScript *scripts;
+} Dialogue;
+
+// ESTADO DO DIÁLOGO EM EXIBIÇÃO:
+typedef struct {
+    const Dialogue *dialogue;
+    DialogueLine lines[2];
+    int front_line;
     int char_count;
     SDL_Rect text_box;
-    int cur_str, cur_byte;
+    int cur_str;
+    int op_cursor;
+    int speaker;
+    double speed;
+    double pause_timer;
     double timer;
+    double sfx_timer;
+    double effect_timer;
+    bool prev_e_pressed;
     bool waiting_for_input;
-} Dialogue;
+} Typewriter;
 
 // OBJETO ESTÁTICO:
 typedef struct {
@@ -109,6 +448,7 @@ typedef struct {
     int health_additional;
     int cure_additional;
     int amount;
+    int shown_amount;
 } Item;
 
 // JOGADOR:
@@ -134,10 +474,22 @@ typedef struct {
 } Player;
 
 // INIMIGO:
+typedef struct {
+    int state;
+    int offsets[ENEMY_PARTS];
+    SDL_Texture *texture;
+    int w;
+    int h;
+    int part_h;
+} EnemyComposite;
+
 typedef struct {
     SDL_Texture ***textures;
     int animation_status;
     SDL_Rect collision[ENEMY_PARTS];
+    int bob[ENEMY_PARTS];
+    EnemyComposite composites[MAX_ENEMY_COMPOSITES];
+    int composite_count;
     int texture_amount;
     int base_health;
     int health;
@@ -185,12 +537,6 @@ typedef struct {
     bool has_played;
 } Sound;
 
-// PACOTE DE RENDERIZAÇÃO:
-typedef struct {
-    SDL_Texture* texture;
-    SDL_Rect *collisions;
-} RenderItem;
-
 // FRAME DE CUTSCENE_SCREEN:
 typedef struct {
     SDL_Texture* image;
@@ -230,6 +576,7 @@ typedef struct {
     bool random_attack_selected;
     bool player_attacked;
     bool enemy_dead;
+    int attack_damage;
 } BattleState;
 
 typedef struct {
@@ -242,6 +589,215 @@ typedef struct {
     double death_timer;
 } GameTimers;
 
+// DADOS DA CENA: CUTSCENE
+typedef struct {
+    Game *game;
+    FadeState *cutscene_fade;
+    Player *meneghetti;
+    Prop *title;
+    Sound *cutscene_music;
+    Sound *dialogue_voices;
+    Typewriter *dialogue_typewriter;
+    Cutscene *first_cutscene;
+    GameTimers *game_timers;
+} CutsceneScene;
+
+// DADOS DA CENA: TÍTULO
+typedef struct {
+    Game *game;
+    TTF_Font *title_text_font;
+    SDL_Color gray;
+    Player *meneghetti;
+    Prop *title;
+    // Só existem enquanto a tela de título está ativa:
+    SDL_Texture *title_text_frames[2];
+    Animation title_text_anim;
+    Prop title_text;
+    Sound title_sound;
+} TitleScene;
+
+// DADOS DA CENA: MUNDO ABERTO
+typedef struct {
+    Game *game;
+    FadeState *open_world_fade;
+    Animation *anim_pack;
+    Animation *anim_pack_reflex;
+    Animation *mr_python_animation;
+    Animation *chatgpt_animation;
+    Animation *dialogue_faces;
+    Player *meneghetti;
+    Player *meneghetti_reflection;
+    WaterReflection *lake_reflection;
+    Soul *soul;
+    Prop *scenario;
+    Tilemap *world_map;
+    Prop *meneghetti_civic;
+    Prop *python_van;
+    Prop *civic;
+    Prop *palm_left;
+    Prop *palm_right;
+    LayerStack *open_world_layers;
+    int civic_dust;
+    int civic_brake_dust;
+    CpuCompositor *compositor;
+    BackgroundCache *background_cache;
+    Sound *ambience;
+    Sound *walking_sounds;
+    Sound *dialogue_voices;
+    Sound *civic_engine;
+    Sound *civic_brake;
+    Sound *civic_door;
+    Dialogue *van_dialogue;
+    Dialogue *lake_dialogue;
+    Dialogue *arrival_dialogue;
+    Dialogue *fight_start_txt;
+    Typewriter *dialogue_typewriter;
+    Dialogue **py_dialogues;
+    NPC *mr_python_npc;
+    NPC *chatgpt_npc;
+    GameTimers *game_timers;
+    DepthList *world_sprites;
+    DepthEntry *civic_entry;
+    DepthEntry *meneghetti_entry;
+    SimClock *sim_clock;
+    Motion *civic_motion;
+    Motion *camera_motion;
+    Motion *player_motion;
+} OpenWorldScene;
+
+// DADOS DA CENA: BATALHA
+typedef struct {
+    Game *game;
+    FadeState *end_scene_fade;
+    SDL_Color white;
+    TTF_Font *battle_text_font;
+    Animation *soul_animation;
+    Animation *bar_attack_animation;
+    Animation *slash_animation;
+    Player *meneghetti;
+    Enemy *mr_python;
+    Soul *soul;
+    Prop *slash;
+    int hit_sparks;
+    Prop *bubble_speech;
+    SDL_Texture **fight_b_textures;
+    Prop *button_fight;
+    SDL_Texture **act_b_textures;
+    Prop *button_act;
+    SDL_Texture **item_b_textures;
+    Prop *button_item;
+    SDL_Texture **leave_b_textures;
+    Prop *button_leave;
+    Prop *battle_name;
+    Prop *battle_hp;
+    NumberFont *hp_number_font;
+    char (*hp_string)[6];
+    Prop *battle_hp_amount;
+    Prop *food_amount_text;
+    Prop *text_attack_act;
+    Prop *text_item;
+    Prop *text_act;
+    Prop *text_leave;
+    Prop *bar_target;
+    Prop *bar_attack;
+    NumberFont *damage_number_font;
+    char (*damage_string)[12];
+    BattleHudCache *battle_hud;
+    Sound *dialogue_voices;
+    Dialogue *fight_start_txt;
+    Typewriter *dialogue_typewriter;
+    Typewriter *bubble_typewriter;
+    BattleBox *battle_box;
+    BattleState *battle_flags;
+    GameTimers *game_timers;
+    SimClock *sim_clock;
+    Motion *soul_motion;
+    Motion *bar_motion;
+    // Só existem durante a batalha: carregados em battle_scene_enter, liberados em battle_scene_exit.
+    SDL_Texture *python_frames[8];
+    Animation python_mother_animation;
+    Animation python_baby_animation;
+    Projectile command_rain[6];
+    Projectile parenthesis_enclosure[6];
+    Projectile python_mother[3];
+    Projectile python_barrier[2];
+    Projectile *python_props[4];
+    Prop damage;
+    Sound battle_music;
+    Sound battle_sounds[5];
+    Sound battle_appears;
+    Sound move_button;
+    Sound click_button;
+    Sound slash_sound;
+    Sound enemy_hit_sound;
+    Sound eat_sound;
+    // Falas da batalha:
+    Dialogue fight_generic_txt;
+    Dialogue fight_leave_txt;
+    Dialogue fight_spare_txt;
+    Dialogue fight_act_txt;
+    Dialogue insult_txt;
+    Dialogue explain_txt;
+    Dialogue picanha_txt;
+    Dialogue no_food_txt;
+    Dialogue bubble_speech_1;
+    Dialogue bubble_speech_2;
+    Dialogue bubble_speech_3;
+} BattleScene;
+
+// DADOS DA CENA: MORTE
+typedef struct {
+    Game *game;
+    FadeState *open_world_fade;
+    Player *meneghetti;
+    Soul *soul;
+    Prop *scenario;
+    Prop *meneghetti_civic;
+    int soul_shards;
+    Enemy **enemy_cache;
+    NPC **npc_cache;
+    Typewriter **typewriter_cache;
+    Sound **sound_cache;
+    BattleBox *battle_box;
+    BattleState *battle_flags;
+    GameTimers *game_timers;
+    // Só existem na tela de morte:
+    Prop soul_shattered;
+    Sound soul_break_sound;
+} DeathScene;
+
+// DADOS DA CENA: FINAL
+typedef struct {
+    Game *game;
+    FadeState *open_world_fade;
+    FadeState *end_scene_fade;
+    Animation *dialogue_faces;
+    Player *meneghetti;
+    Soul *soul;
+    Prop *scenario;
+    Prop *meneghetti_civic;
+    Sound *dialogue_voices;
+    Typewriter *dialogue_typewriter;
+    Enemy **enemy_cache;
+    NPC **npc_cache;
+    Typewriter **typewriter_cache;
+    Sound **sound_cache;
+    BattleBox *battle_box;
+    BattleState *battle_flags;
+    GameTimers *game_timers;
+    // Fala exclusiva do final:
+    Dialogue end_dialogue;
+} FinalScene;
+
+// CENA (UM ESTADO DO JOGO COM CICLO DE VIDA PRÓPRIO):
+typedef struct {
+    const char *name;
+    void *data;
+    void (*enter)(void *data);
+    void (*exit)(void *data);
+    void (*frame)(void *data, double dt, const Uint8 *keys);
+} Scene;
+
 // DIREÇÕES DE SPRITE:
 enum direction { DIRECTION_UP, DIRECTION_DOWN, DIRECTION_LEFT, DIRECTION_RIGHT };
 // ESTADOS DO JOGO:
@@ -261,36 +817,203 @@ enum enemy_textures { ENEMY_IDLE, ENEMY_VARIATION, ENEMY_HURT, ENEMY_DEAD };
 enum enemy_parts { ENEMY_ARMS, ENEMY_LEGS, ENEMY_HEAD, ENEMY_TORSO };
 // IDENTIFICADORES DE ITENS:
 enum item_types { ITEM_FOOD, ITEM_WEAPON, ITEM_ARMOR };
+// TIPOS DE CARACTERE EM LINHA DE DIÁLOGO:
+enum glyph_kinds { GLYPH_CHAR, GLYPH_SPACE, GLYPH_NEWLINE };
+// TIPOS DE COMANDO DE DESENHO:
+enum render_commands { RENDER_CMD_FILL, RENDER_CMD_COPY, RENDER_CMD_GEOMETRY };
+// CAMADAS DO BUFFER DE DESENHO (DE TRÁS PARA FRENTE):
+enum render_layers { LAYER_BACKGROUND, LAYER_WORLD, LAYER_FOREGROUND, LAYER_HUD };
+// OPERAÇÕES DA MARCAÇÃO DE TEXTO:
+enum text_ops { TEXT_OP_CHAR, TEXT_OP_SPACE, TEXT_OP_NEWLINE, TEXT_OP_PAUSE, TEXT_OP_SPEED, TEXT_OP_COLOR, TEXT_OP_COLOR_RESET, TEXT_OP_SPEAKER };
+// EFEITOS DE TEXTO POR GLIFO:
+enum text_effects { TEXT_EFFECT_NONE = 0, TEXT_EFFECT_SHAKE = 1 << 0, TEXT_EFFECT_WAVE = 1 << 1 };
+// REPETIÇÃO DE CAMADAS DE PARALLAX:
+enum wrap_modes { WRAP_NONE = 0, WRAP_X = 1 << 0, WRAP_Y = 1 << 1 };
+// MODOS DO RITMO DE QUADROS:
+enum pacer_modes { PACER_VSYNC, PACER_FIXED, PACER_UNCAPPED };
 
 // FUNÇÃO DE INICIALIZAÇÃO:
 bool sdl_initialize(Game *game);
+bool parse_arguments(int argc, char *argv[], Game *game);
 
 // FUNÇÃO DE RESET PARA O ESTADO DO GAME:
-void game_reset(Game *game, GameTimers *timers, BattleState *battle, BattleBox *battle_box, Soul *soul, Player *player, Enemy *enemies[], NPC *npcs[], Dialogue *dialogues[], Sound *sounds[]);
+void game_reset(Game *game, GameTimers *timers, BattleState *battle, BattleBox *battle_box, Soul *soul, Player *player, Enemy *enemies[], NPC *npcs[], Typewriter *typewriters[], Sound *sounds[]);
+
+// FUNÇÕES DE CENAS:
+void switch_scene(Scene scenes[], int from, int to);
+void cutscene_scene_frame(void *data, double dt, const Uint8 *keys);
+void title_scene_frame(void *data, double dt, const Uint8 *keys);
+void open_world_scene_frame(void *data, double dt, const Uint8 *keys);
+void battle_scene_frame(void *data, double dt, const Uint8 *keys);
+void death_scene_frame(void *data, double dt, const Uint8 *keys);
+void final_scene_frame(void *data, double dt, const Uint8 *keys);
+void title_scene_enter(void *data);
+void title_scene_exit(void *data);
+void battle_scene_enter(void *data);
+void battle_scene_exit(void *data);
+void death_scene_enter(void *data);
+void death_scene_exit(void *data);
 
 // FUNÇÕES DE CARREGAMENTO:
 SDL_Texture *create_texture(SDL_Renderer *render, const char *dir);
+SDL_Texture *texture_from_surface(SDL_Renderer *render, SDL_Surface *surface);
 Mix_Chunk *create_chunk(const char *dir, int volume);
 TTF_Font *create_font(const char *dir, int size);
 SDL_Texture *create_text(SDL_Renderer *render, const char *utf8_char, TTF_Font *font, SDL_Color color);
+bool create_number_font(SDL_Renderer *render, NumberFont *number_font, const char *digit_pattern, int spacing);
+bool bake_number_font(SDL_Renderer *render, NumberFont *number_font, TTF_Font *font, SDL_Color color);
+bool create_background_cache(SDL_Renderer *render, BackgroundCache *cache);
+SDL_Texture *compose_background_cache(SDL_Renderer *render, BackgroundCache *cache, SDL_Texture *textures[], const SDL_Rect srcs[], const SDL_Rect rects[], int count);
+bool create_battle_hud(SDL_Renderer *render, BattleHudCache *hud);
+bool battle_hud_current(const BattleHudCache *hud, const SDL_Rect *box, int health, SDL_Texture *buttons[BATTLE_BUTTONS]);
+bool begin_battle_hud(SDL_Renderer *render, BattleHudCache *hud, const SDL_Rect *box, int health, SDL_Texture *buttons[BATTLE_BUTTONS], const SDL_Rect *bounds);
+void end_battle_hud(SDL_Renderer *render, BattleHudCache *hud);
+
+// FUNÇÕES DE NÚMEROS:
+static int number_glyph_index(char c);
+int number_text_width(const NumberFont *number_font, const char *digits);
+int render_number(SDL_Renderer *render, const NumberFont *number_font, const char *digits, int x, int y);
 
 // FUNÇÕES DE GAMEPLAY:
-void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *npc, int *player_state, int *game_state, double dt, Animation *dialogue_faces, Sound *sound, Prop *bubble_speech);
-void reset_dialogue(Dialogue *text);
-void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int *player_health, int damage, int attack_index, Projectile **props, double dt, double turn_timer, Sound *sound, bool clear);
-void sprite_update(Prop *scenario, Player *player, Animation *animation, double dt, SDL_Rect boxes[], SDL_Rect surfaces[], Sound *sound);
+void create_dialogue(Player *player, SDL_Renderer *render, Typewriter *tw, const Dialogue *text, NPC *npc, int *player_state, int *game_state, double dt, Animation *dialogue_faces, Sound *sound, Prop *bubble_speech);
+void reset_typewriter(Typewriter *tw);
+void prefetch_dialogue(SDL_Renderer *render, const Dialogue *text);
+static SDL_Rect dialogue_box_rect(int game_state, Player *player, Prop *bubble_speech);
+static SDL_Rect dialogue_text_area(SDL_Rect dialogue_box, int game_state, int face, bool bubble);
+static bool prepare_dialogue_line(SDL_Renderer *render, const Dialogue *text, DialogueLine *line, int str_index, SDL_Rect area, int budget);
+static void layout_dialogue_line(DialogueLine *line, SDL_Rect area, int line_height);
+static void render_dialogue_line(SDL_Renderer *render, const DialogueLine *line, int visible, SDL_Texture *atlas, int x, int y, double time);
+static void start_typewriter_line(Typewriter *tw, const Dialogue *text);
+static void run_text_ops(Typewriter *tw, const TextScript *script);
+void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int *player_health, int damage, int attack_index, Projectile **props, double dt, double step_time, double turn_timer, Sound *sound, bool clear);
+void sprite_update(Prop *scenario, Player *player, Animation *animation, double dt, const Tilemap *map, SDL_Rect boxes[], Sound *sound);
 SDL_Texture *animate_sprite(Animation *anim, double dt, double cooldown, bool blink);
 bool rects_intersect(SDL_Rect *a, SDL_Rect *b, SDL_FRect *c);
 bool check_collision(SDL_Rect *player, SDL_Rect boxes[], int box_count);
 static int surface_to_sound_index(int surface_index);
-static int detect_surface(SDL_Rect *player, SDL_Rect surfaces[], int surface_count);
+static bool movement_blocked(const Tilemap *map, SDL_Rect *test, int origin_x, int origin_y, SDL_Rect boxes[]);
 void update_reflection(Player *original, Player* reflection, Animation *animation);
 
+// FUNÇÕES DO REFLEXO NA ÁGUA:
+void create_water_reflection(WaterReflection *water, Uint8 alpha);
+void update_water_reflection(WaterReflection *water, const SDL_Rect *rect, double dt);
+void queue_water_reflection(SDL_Renderer *render, WaterReflection *water, SDL_Texture *sprite, const SDL_Rect *dst, int layer, int depth);
+static bool bake_water_reflection(SDL_Renderer *render, WaterReflection *water, SDL_Texture *sprite, int w, int h);
+
+// FUNÇÕES DE PARTÍCULAS:
+bool load_particle_system(SDL_Renderer *render, ParticleSystem *system, const char *dir);
+int find_emitter(const ParticleSystem *system, const char *name);
+void emit_particles(ParticleSystem *system, int emitter, float x, float y, int count);
+void stream_particles(ParticleSystem *system, int emitter, float x, float y, double dt);
+void update_particles(ParticleSystem *system, double dt);
+void queue_particles(ParticleSystem *system, int layer, int depth);
+void clear_particles(ParticleSystem *system);
+void destroy_particle_system(ParticleSystem *system);
+static int particle_pool_for(SDL_Renderer *render, ParticleSystem *system, const char *image);
+static bool parse_particle_color(const char *hex, SDL_Color *color);
+static float random_float(float min, float max);
+
+// FUNÇÕES DE RITMO DE QUADROS:
+void pacer_init(FramePacer *pacer, int mode, double target_fps);
+double pacer_frame_time(FramePacer *pacer, bool sample);
+void pacer_wait(FramePacer *pacer);
+void pacer_report(FramePacer *pacer, double dt);
+double pacer_budget(const FramePacer *pacer, SDL_Window *window);
+
+// FUNÇÕES DO PASSO FIXO:
+void sim_clock_advance(SimClock *clock, double dt);
+void motion_begin_step(Motion *motion, const SDL_Rect *rect);
+void motion_end_step(Motion *motion, const SDL_Rect *rect);
+SDL_FRect motion_rect(const Motion *motion, const SDL_Rect *rect, double alpha);
+
+// FUNÇÕES DA RESOLUÇÃO INTERNA:
+bool create_render_pipeline(SDL_Renderer *render, double budget);
+void begin_render_frame(SDL_Renderer *render);
+void present_render_frame(SDL_Renderer *render);
+bool update_render_scale(double frame_time);
+
+// FUNÇÕES DE CALIBRAÇÃO DO RENDERIZADOR:
+int choose_render_driver(SDL_Window *window, bool calibrate);
+static double benchmark_render_driver(SDL_Window *window, int index);
+static int find_render_driver(const char *name);
+static char *renderer_cache_path(void);
+
+// FUNÇÕES DE QUADROS OCIOSOS:
+void mark_frame_dirty(void);
+void schedule_frame_wake(double seconds);
+
+// FUNÇÕES DO BUFFER DE COMANDOS DE DESENHO:
+void queue_copy(SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst, int layer, int depth);
+void queue_copy_ex(SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst, double angle, SDL_RendererFlip flip, int layer, int depth);
+void queue_copy_f(SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst, int layer, int depth);
+static void queue_copy_exf(SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst, double angle, SDL_RendererFlip flip, int layer, int depth);
+void queue_fill(const SDL_Rect *rect, SDL_Color color, SDL_BlendMode blend, int layer, int depth);
+void queue_geometry(SDL_Texture *texture, const SDL_Vertex *vertices, int vertex_count, const int *indices, int index_count, int layer, int depth);
+void flush_render_queue(SDL_Renderer *render);
+static void draw_render_range(SDL_Renderer *render, RenderCommand **sorted, int first, int last);
+static void draw_scaled_background(SDL_Renderer *render, RenderCommand **sorted, int count);
+static int render_command_cmp(const void *pa, const void *pb);
+static bool same_render_state(const RenderCommand *a, const RenderCommand *b);
+static void append_command_quad(const RenderCommand *cmd, int tex_w, int tex_h, SDL_Vertex *vertices, int *indices, int *vertex_count, int *index_count);
+static bool clip_to_view(SDL_Texture *texture, SDL_Rect *src, bool *has_src, SDL_FRect *dst, SDL_RendererFlip flip);
+static void clip_span(float view_size, float *pos, float *size, int *src_pos, int *src_size, bool flipped);
+
+// FUNÇÕES DA PILHA DE PARALLAX:
+bool load_layer_stack(SDL_Renderer *render, LayerStack *stack, const char *dir);
+void destroy_layer_stack(LayerStack *stack);
+void update_layer_stack(LayerStack *stack, double dt);
+bool load_layer_pixels(LayerStack *stack);
+int queue_layer_stack(SDL_Renderer *render, LayerStack *stack, BackgroundCache *cache, CpuCompositor *compositor, OcclusionGrid *occlusion, int camera_x, int camera_y, int layer);
+static int layer_pieces(const ParallaxLayer *parallax, int camera_x, int camera_y, SDL_Rect srcs[4], SDL_Rect dsts[4]);
+static int wrap_spans(int offset, int size, int src_start[2], int dst_start[2], int length[2]);
+static bool accumulate_opaque_mask(ParallaxLayer *parallax, SDL_Surface *surface, bool first_frame);
+
+// FUNÇÕES DE OCLUSÃO:
+void occlusion_reset(OcclusionGrid *grid);
+void occlusion_cover(OcclusionGrid *grid, const Uint8 *opaque, int tiles_w, int tiles_h, const SDL_Rect *src, const SDL_Rect *dst);
+int occlusion_runs(const OcclusionGrid *grid, const SDL_Rect *src, const SDL_Rect *dst, SDL_Rect out_srcs[], SDL_Rect out_dsts[], int capacity);
+
+// FUNÇÕES DO MAPA DE TILES:
+bool load_tilemap(SDL_Renderer *render, Tilemap *map, const char *dir, const SDL_Rect solids[], int solid_count, const SDL_Rect surfaces[], int surface_count);
+void destroy_tilemap(Tilemap *map);
+void tilemap_queue(Tilemap *map, int origin_x, int origin_y, int layer, int depth);
+bool tilemap_collides(const Tilemap *map, const SDL_Rect *rect, int origin_x, int origin_y);
+void tilemap_occlude(const Tilemap *map, OcclusionGrid *grid, int origin_x, int origin_y);
+int tilemap_material(const Tilemap *map, const SDL_Rect *rect, int origin_x, int origin_y);
+static Uint32 hash_tile(const Uint32 *pixels, int width);
+
+// FUNÇÕES DE INIMIGOS COMPOSTOS:
+void enemy_bob(Enemy *enemy, int base_y, double phase);
+void bake_enemy_composites(SDL_Renderer *render, Enemy *enemy, int base_y);
+void redraw_enemy_composites(SDL_Renderer *render, Enemy *enemy);
+void queue_enemy(SDL_Renderer *render, Enemy *enemy, int layer, int depth);
+static EnemyComposite *find_enemy_composite(Enemy *enemy, int state, const int offsets[ENEMY_PARTS]);
+static EnemyComposite *bake_enemy_composite(SDL_Renderer *render, Enemy *enemy, int state, const int offsets[ENEMY_PARTS]);
+static bool draw_enemy_composite(SDL_Renderer *render, const Enemy *enemy, const EnemyComposite *composite);
+
+// FUNÇÕES DA LISTA DE PROFUNDIDADE:
+DepthEntry *depth_list_add(DepthList *list, SDL_Texture **texture, const SDL_Rect *rect);
+void depth_list_update(DepthList *list);
+void depth_list_queue(const DepthList *list, int layer);
+
+// FUNÇÕES DE MARCAÇÃO DE TEXTO:
+bool compile_dialogue(Dialogue *dialogue);
+void escape_markup(const char *source, char *dest, size_t size);
+static bool compile_text_script(const char *source, TextScript *script);
+static bool parse_text_tag(const char *tag, TextOp *op);
+
+// FUNÇÕES DE CACHE DE GLIFOS:
+static GlyphCache *get_glyph_cache(TTF_Font *font);
+static Glyph *find_glyph(GlyphCache *cache, Uint32 codepoint, bool create);
+static const Glyph *cache_glyph(SDL_Renderer *render, GlyphCache *cache, Uint32 codepoint, const char *utf8_char);
+
 // FUNÇÕES DE REGISTRO DE OBJETOS:
 static void track_texture(SDL_Texture *texture);
 static bool already_tracked_texture(SDL_Texture *texture);
+static void release_texture(SDL_Texture *texture);
 static void track_chunk(Mix_Chunk *chunk);
 static bool already_tracked_chunk(Mix_Chunk *chunk);
+static void release_chunk(Mix_Chunk *chunk);
 static void track_font(TTF_Font *font);
 static bool already_tracked_font(TTF_Font *font);
 
@@ -301,8 +1024,8 @@ void clean_tracked_resources(void);
 // FUNÇÕES AUXILIARES:
 static int utf8_charlen(const char *s);
 static int utf8_copy_char(const char *s, char *out);
+static Uint32 utf8_decode(const char *s);
 char *utf8_to_upper(const char *s);
-int renderitem_cmp(const void *pa, const void *pb);
 int randint(int min, int max);
 int choice(int count, ...);
 
@@ -319,11 +1042,37 @@ static TTF_Font **guarded_fonts = NULL;
 static int guarded_fonts_count = 0;
 static int guarded_fonts_capacity = 0;
 
+// ESTADO GLOBAL DE QUADROS OCIOSOS:
+static bool frame_dirty = true;
+static double frame_wake_in = IDLE_MAX_WAIT;
+
+// PIPELINE GLOBAL DE RESOLUÇÃO INTERNA:
+static RenderPipeline render_pipeline = {.scale = 1.0};
+
+// SISTEMA GLOBAL DE PARTÍCULAS (GRANDE DEMAIS PARA A PILHA):
+static ParticleSystem particle_system;
+
+// CAPTURA GLOBAL DE QUADROS:
+static FrameCapture *frame_capture = NULL;
+
+// BUFFER GLOBAL DE COMANDOS DE DESENHO:
+static RenderCommand render_commands[MAX_RENDER_COMMANDS];
+static int render_commands_count = 0;
+static Uint32 render_commands_sequence = 0;
+static int render_commands_dropped = 0;
+
+// POOLS GLOBAIS DE FALAS COMPILADAS:
+static TextOp text_ops_pool[MAX_TEXT_OPS];
+static int text_ops_used = 0;
+static TextScript text_scripts_pool[MAX_TEXT_SCRIPTS];
+static int text_scripts_used = 0;
+
+// CACHES GLOBAIS DE GLIFOS:
+static GlyphCache glyph_caches[MAX_GLYPH_CACHES];
+static int glyph_caches_count = 0;
+
 int main(int argc, char* argv[]) {
     srand(time(NULL));
-    
-    (void) argc;
-    (void) argv;
 
     Game game = {
         .renderer = NULL,
@@ -333,6 +1082,9 @@ int main(int argc, char* argv[]) {
         .player_on_scene = true
     };
 
+    if (parse_arguments(argc, argv, &game))
+        game_cleanup(&game, EXIT_FAILURE);
+
     if (sdl_initialize(&game))
         game_cleanup(&game, EXIT_FAILURE);
 
@@ -464,41 +1216,6 @@ int main(int argc, char* argv[]) {
     dialogue_faces[FACE_CHATGPT].frames[0] = create_texture(game.renderer, "assets/sprites/characters/chatgpt-dialogue-1.png");
     dialogue_faces[FACE_CHATGPT].frames[1] = create_texture(game.renderer, "assets/sprites/characters/chatgpt-dialogue-2.png");
 
-    Animation title_text_anim = {
-        .frames = (SDL_Texture*[]){create_text(game.renderer, "APERTE ENTER PARA COMEÇAR", title_text_font, gray), NULL},
-        .timer = 0.0,
-        .counter = 0,
-        .count = 2
-    };
-
-    Animation lake_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/scenario/lake-1.png"), create_texture(game.renderer, "assets/sprites/scenario/lake-2.png"), create_texture(game.renderer, "assets/sprites/scenario/lake-3.png")},
-        .timer = 0.0,
-        .counter = 0,
-        .count = 3
-    };
-
-    Animation ocean_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/scenario/ocean-1.png"), create_texture(game.renderer, "assets/sprites/scenario/ocean-2.png"), create_texture(game.renderer, "assets/sprites/scenario/ocean-3.png"), create_texture(game.renderer, "assets/sprites/scenario/ocean-4.png")},
-        .timer = 0.0,
-        .counter = 0,
-        .count = 4
-    };
-
-    Animation sky_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/scenario/sky-1.png"), create_texture(game.renderer, "assets/sprites/scenario/sky-2.png"), create_texture(game.renderer, "assets/sprites/scenario/sky-3.png"), create_texture(game.renderer, "assets/sprites/scenario/sky-4.png")},
-        .timer = 0.0,
-        .counter = 0,
-        .count = 4
-    };
-
-    Animation sun_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/scenario/sun-1.png"), create_texture(game.renderer, "assets/sprites/scenario/sun-2.png"), create_texture(game.renderer, "assets/sprites/scenario/sun-3.png"), create_texture(game.renderer, "assets/sprites/scenario/sun-4.png")},
-        .timer = 0.0,
-        .counter = 0,
-        .count = 4
-    };
-
     Animation soul_animation = {
         .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/soul.png"), NULL},
         .timer = 0.0,
@@ -520,34 +1237,6 @@ int main(int argc, char* argv[]) {
         .count = 6
     };
 
-    Animation python_mother_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-1.png"), create_texture(game.renderer, "assets/sprites/battle/python-2.png")},
-        .timer = 0.0,
-        .counter = 0,
-        .count = 2
-    };
-
-    Animation python_baby_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-baby-1.png"), create_texture(game.renderer, "assets/sprites/battle/python-baby-2.png")},
-        .timer = 0.0,
-        .counter = 0,
-        .count = 2
-    };
-
-    Animation python_barrier_left_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-barrier-left-1.png"), create_texture(game.renderer, "assets/sprites/battle/python-barrier-left-2.png")},
-        .timer = 0.0,
-        .counter = 0,
-        .count = 2
-    };
-
-    Animation python_barrier_right_animation = {
-        .frames = (SDL_Texture*[]){create_texture(game.renderer, "assets/sprites/battle/python-barrier-right-1.png"), create_texture(game.renderer, "assets/sprites/battle/python-barrier-right-2.png")},
-        .timer = 0.0,
-        .counter = 0,
-        .count = 2
-    };
-
     // OBJETOS:
     Player meneghetti = {
         .texture = anim_pack[DIRECTION_DOWN].frames[0],
@@ -572,11 +1261,14 @@ int main(int argc, char* argv[]) {
         .facing = DIRECTION_DOWN,
         .counters = {0, 0, 0, 0}
     };
+    WaterReflection lake_reflection;
+    create_water_reflection(&lake_reflection, 70);
 
     Enemy mr_python = {
         .texture_amount = ENEMY_STATES,
         .animation_status = ENEMY_IDLE,
         .collision = {{(SCREEN_WIDTH / 2) - 102, 25, 204, 204}, {(SCREEN_WIDTH / 2) - 102, 25, 204, 204}, {(SCREEN_WIDTH / 2) - 102, 25, 204, 204}, {(SCREEN_WIDTH / 2) - 102, 25, 204, 204}},
+        .bob = {3, 0, 1, 2},
         .health = 200,
         .base_health = 200,
         .strength = 2,
@@ -584,7 +1276,7 @@ int main(int argc, char* argv[]) {
     };
     mr_python.textures = malloc(sizeof(SDL_Texture**) * ENEMY_STATES);
     for (int i = 0; i < ENEMY_STATES; i++) {
-        mr_python.textures[i] = malloc(sizeof(SDL_Texture**) * ENEMY_PARTS);
+        mr_python.textures[i] = calloc(ENEMY_PARTS, sizeof(SDL_Texture*));
     }
     mr_python.textures[ENEMY_IDLE][ENEMY_ARMS] = create_texture(game.renderer, "assets/sprites/battle/python-arms.png");
     mr_python.textures[ENEMY_IDLE][ENEMY_LEGS] = create_texture(game.renderer, "assets/sprites/battle/python-legs.png");
@@ -594,6 +1286,7 @@ int main(int argc, char* argv[]) {
     mr_python.textures[ENEMY_HURT][ENEMY_LEGS] = create_texture(game.renderer, "assets/sprites/battle/python-legs-hurt.png");
     mr_python.textures[ENEMY_HURT][ENEMY_HEAD] = create_texture(game.renderer, "assets/sprites/battle/python-head-2.png");
     mr_python.textures[ENEMY_HURT][ENEMY_TORSO] = create_texture(game.renderer, "assets/sprites/battle/python-torso.png");
+    bake_enemy_composites(game.renderer, &mr_python, 25);
 
     Soul soul = {
         .texture = soul_animation.frames[0],
@@ -602,11 +1295,45 @@ int main(int argc, char* argv[]) {
         .ivulnerability_timer = 0.0
     };
 
+    // O cenário é desenhado pelo mapa de tiles; o Prop guarda só a posição da câmera.
     Prop scenario = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/scenario.png"),
+        .texture = NULL,
         .collision = {0, -SCREEN_HEIGHT, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2}
     };
 
+    // TERRENO (COORDENADAS DO MAPA):
+    const SDL_Rect terrain_solids[TERRAIN_QUANTITY] = {
+        {0, 739, 981, 221}, // Bloco inferior esquerdo.
+        {0, 384, 607, 185}, // Bloco superior esquerdo (ponte).
+        {0, 0, 253, 384}, // Bloco ao topo esquerdo.
+        {253, 0, 774, 105}, // Bloco ao topo central.
+        {1027, 0, 253, 384}, // Bloco ao topo direito.
+        {673, 384, 607, 185}, // Bloco superior direito (ponte).
+        {1045, 739, 235, 221}, // Bloco inferior esquerdo.
+        {981, 890, 64, 70}, // Bloco do rodapé (lago).
+        {596, 377, 11, 7}, // Toco esquerdo da ponte.
+        {673, 377, 11, 7} // Toco direito da ponte.
+    };
+    const SDL_Rect terrain_surfaces[SURFACE_QUANTITY] = {
+        {0, 569, 611, 135}, // Grama esquerda.
+        {669, 569, 611, 135}, // Grama direita.
+        {653, 590, 16, 49}, // Grama restante direita.
+        {0, 704, SCREEN_WIDTH * 2, 41}, // Calçada.
+        {981, 745, 64, 72}, // Faixa de pedestres.
+        {981, 817, 64, 40}, // Pedras.
+        {981, 857, 64, 33}, // Areia.
+        {607, 398, 66, 152}, // Ponte.
+        {253, 106, 774, 278}, // Píer.
+        {607, 550, 66, 19}, // Caminho de terra (topo).
+        {611, 569, 58, 21}, // Caminho de terra (superior).
+        {611, 590, 42, 49}, // Caminho de terra (meio).
+        {611, 639, 58, 65} // Caminho de terra (inferior).
+    };
+
+    Tilemap world_map;
+    if (!load_tilemap(game.renderer, &world_map, "assets/sprites/scenario/scenario.png", terrain_solids, TERRAIN_QUANTITY, terrain_surfaces, SURFACE_QUANTITY))
+        game_cleanup(&game, EXIT_FAILURE);
+
     Prop meneghetti_civic = {
         .texture = create_texture(game.renderer, "assets/sprites/characters/meneghetti-civic-left.png"),
         .collision = {scenario.collision.x + scenario.collision.w, scenario.collision.y + 731, 64, 42}
@@ -622,17 +1349,6 @@ int main(int argc, char* argv[]) {
         .collision = {(SCREEN_WIDTH / 2) - 290, (SCREEN_HEIGHT / 2) - 32, 580, 63}
     };
 
-    Prop title_text = {
-        .texture = title_text_anim.frames[0],
-    };
-    int title_text_width, title_text_height;
-    SDL_QueryTexture(title_text.texture, NULL, NULL, &title_text_width, &title_text_height);
-    title_text.collision = (SDL_Rect){(SCREEN_WIDTH / 2) - (title_text_width / 2), SCREEN_HEIGHT - 100, title_text_width, title_text_height};
-
-    Prop soul_shattered = {
-        .texture = create_texture(game.renderer, "assets/sprites/battle/soul-broken.png")
-    };
-
     Prop python_van = {
         .texture = create_texture(game.renderer, "assets/sprites/scenario/python-van.png")
     };
@@ -649,38 +1365,30 @@ int main(int argc, char* argv[]) {
         .texture = create_texture(game.renderer, "assets/sprites/scenario/palm-head-right.png")
     };
 
-    Prop lake = {
-        .texture = lake_animation.frames[0],
-    };
-
-    Prop ocean = {
-        .texture = ocean_animation.frames[0],
-    };
-    
-    Prop sky = {
-        .texture = sky_animation.frames[0],
-    };
-
-    Prop mountains = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/mountains.png"),
-        .collision = {0, 0, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2}
-    };
-
-    Prop sun = {
-        .texture = sun_animation.frames[0]
-    };
-
-    Prop clouds = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/clouds.png"),
-        .collision = {0, 0, SCREEN_WIDTH * 2, 155}
-    };
-    SDL_SetTextureAlphaMod(clouds.texture, 200);
-    SDL_Rect clouds_clone = {clouds.collision.x - clouds.collision.w, 0, SCREEN_WIDTH * 2, 155};
+    // CAMADAS DE PARALLAX DO MUNDO ABERTO:
+    LayerStack open_world_layers;
+    if (!load_layer_stack(game.renderer, &open_world_layers, "assets/scenes/open_world.layers"))
+        game_cleanup(&game, EXIT_FAILURE);
 
-    Prop mountains_back = {
-        .texture = create_texture(game.renderer, "assets/sprites/scenario/mountains-back.png"),
-        .collision = {0, 0, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2}
-    };
+    // EFEITOS DE PARTÍCULAS:
+    if (!load_particle_system(game.renderer, &particle_system, "assets/scenes/effects.emitters"))
+        game_cleanup(&game, EXIT_FAILURE);
+    int hit_sparks = find_emitter(&particle_system, "hit_sparks");
+    int soul_shards = find_emitter(&particle_system, "soul_shards");
+    int civic_dust = find_emitter(&particle_system, "civic_dust");
+    int civic_brake_dust = find_emitter(&particle_system, "civic_brake");
+
+    // Sem aceleração de GPU, o fundo é composto na CPU em vez de uma cópia por camada.
+    CpuCompositor *compositor = NULL;
+    SDL_RendererInfo renderer_info;
+    bool software_renderer = SDL_GetRendererInfo(game.renderer, &renderer_info) == 0 && !(renderer_info.flags & SDL_RENDERER_ACCELERATED);
+    if (game.cpu_compositor || software_renderer) {
+        compositor = cpu_compositor_create(game.renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+        if (compositor && !load_layer_pixels(&open_world_layers)) {
+            cpu_compositor_destroy(compositor);
+            compositor = NULL;
+        }
+    }
 
     Prop bubble_speech = {
         .texture = create_texture(game.renderer, "assets/sprites/battle/text-bubble.png"),
@@ -724,11 +1432,17 @@ int main(int argc, char* argv[]) {
     SDL_QueryTexture(battle_hp.texture, NULL, NULL, &battle_text_width, &battle_text_height);
     battle_hp.collision = (SDL_Rect){button_act.collision.x + 35, button_fight.collision.y - battle_text_height - 8, battle_text_width, battle_text_height};
 
+    // Dígitos do HP rasterizados uma única vez; trocar o valor não cria texturas.
+    NumberFont hp_number_font;
+    if (!bake_number_font(game.renderer, &hp_number_font, battle_text_font, white)) {
+        game_cleanup(&game, EXIT_FAILURE);
+    }
+
+    char hp_string[6] = "20/20";
     Prop battle_hp_amount = {
-        .texture = create_text(game.renderer, "20/20", battle_text_font, white),
+        .texture = NULL,
     };
-    SDL_QueryTexture(battle_hp_amount.texture, NULL, NULL, &battle_text_width, &battle_text_height);
-    battle_hp_amount.collision = (SDL_Rect){button_act.collision.x + 140, button_fight.collision.y - battle_text_height - 8, battle_text_width, battle_text_height};
+    battle_hp_amount.collision = (SDL_Rect){button_act.collision.x + 140, button_fight.collision.y - hp_number_font.height - 8, number_text_width(&hp_number_font, hp_string), hp_number_font.height};
 
     Prop food_amount_text = {
         .texture = create_text(game.renderer, "4x", battle_text_font, white),
@@ -776,73 +1490,22 @@ int main(int argc, char* argv[]) {
         .collision = {bar_target.collision.x + 20, bar_target.collision.y + 2, 14, bar_target.collision.h - 4}
     };
 
-    int attack_widths, attack_heights;
-    Projectile command_rain[6];
-    command_rain[0].texture = create_texture(game.renderer, "assets/sprites/battle/if.png");
-    SDL_QueryTexture(command_rain[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[1].texture = create_texture(game.renderer, "assets/sprites/battle/else.png");
-    SDL_QueryTexture(command_rain[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[2].texture = create_texture(game.renderer, "assets/sprites/battle/elif.png");
-    SDL_QueryTexture(command_rain[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[3].texture = create_texture(game.renderer, "assets/sprites/battle/input.png");
-    SDL_QueryTexture(command_rain[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[4].texture = create_texture(game.renderer, "assets/sprites/battle/print.png");
-    SDL_QueryTexture(command_rain[4].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[4].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    command_rain[5].texture = create_texture(game.renderer, "assets/sprites/battle/in.png");
-    SDL_QueryTexture(command_rain[5].texture, NULL, NULL, &attack_widths, &attack_heights);
-    command_rain[5].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-
-    Projectile parenthesis_enclosure[6];
-    parenthesis_enclosure[0].texture = create_texture(game.renderer, "assets/sprites/battle/brackets-1.png");
-    SDL_QueryTexture(parenthesis_enclosure[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[1].texture = create_texture(game.renderer, "assets/sprites/battle/brackets-2.png");
-    SDL_QueryTexture(parenthesis_enclosure[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[2].texture = create_texture(game.renderer, "assets/sprites/battle/key-1.png");
-    SDL_QueryTexture(parenthesis_enclosure[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[3].texture = create_texture(game.renderer, "assets/sprites/battle/key-2.png");
-    SDL_QueryTexture(parenthesis_enclosure[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[4].texture = create_texture(game.renderer, "assets/sprites/battle/parenthesis-1.png");
-    SDL_QueryTexture(parenthesis_enclosure[4].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[4].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
-    parenthesis_enclosure[5].texture = create_texture(game.renderer, "assets/sprites/battle/parenthesis-2.png");
-    SDL_QueryTexture(parenthesis_enclosure[5].texture, NULL, NULL, &attack_widths, &attack_heights);
-    parenthesis_enclosure[5].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
+    NumberFont damage_number_font;
+    if (!create_number_font(game.renderer, &damage_number_font, "assets/sprites/battle/number-damage-%d.png", 1)) {
+        game_cleanup(&game, EXIT_FAILURE);
+    }
+    char damage_string[12] = "";
 
-    Projectile python_mother[3];
-    python_mother[0].texture = python_mother_animation.frames[0];
-    SDL_QueryTexture(python_mother[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_mother[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    python_mother[1].texture = python_mother_animation.frames[1];
-    SDL_QueryTexture(python_mother[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_mother[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    python_mother[2].texture = python_baby_animation.frames[0];
-    SDL_QueryTexture(python_mother[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_mother[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    python_mother[2].animation = python_baby_animation;
+    // Sem suporte a render targets o fundo volta a ser desenhado camada por camada.
+    BackgroundCache background_cache;
+    if (!create_background_cache(game.renderer, &background_cache)) {
+        fprintf(stderr, "Background cache unavailable, drawing directly.\n");
+    }
 
-    Projectile python_barrier[2];
-    python_barrier[0].texture = python_barrier_left_animation.frames[0];
-    SDL_QueryTexture(python_barrier[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_barrier[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    python_barrier[0].animation = python_barrier_left_animation;
-    python_barrier[1].texture = python_barrier_right_animation.frames[1];
-    SDL_QueryTexture(python_barrier[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-    python_barrier[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-    python_barrier[1].animation = python_barrier_right_animation;
-
-    Projectile *python_props[] = {command_rain, parenthesis_enclosure, python_mother, python_barrier};
-
-    SDL_Texture* damage_numbers[] = {create_texture(game.renderer, "assets/sprites/battle/number-10.png"), create_texture(game.renderer, "assets/sprites/battle/number-20.png"), create_texture(game.renderer, "assets/sprites/battle/number-30.png"), create_texture(game.renderer, "assets/sprites/battle/number-40.png")};
-    Prop damage;
+    BattleHudCache battle_hud;
+    if (!create_battle_hud(game.renderer, &battle_hud)) {
+        fprintf(stderr, "HUD cache unavailable, drawing directly.\n");
+    }
 
     // SONS:
     Sound cutscene_music = {
@@ -850,11 +1513,6 @@ int main(int argc, char* argv[]) {
         .has_played = false
     };
 
-    Sound battle_music = {
-        .sound = create_chunk("assets/sounds/soundtracks/battle_against_abstraction.wav", MUSIC_VOLUME),
-        .has_played = false
-    };
-
     Sound ambience = {
         .sound = create_chunk("assets/sounds/sound_effects/in-game/ambient_sound.wav", MUSIC_VOLUME),
         .has_played = false
@@ -874,18 +1532,6 @@ int main(int argc, char* argv[]) {
     walking_sounds[5].sound = create_chunk("assets/sounds/sound_effects/in-game/walking_dirt.wav", SFX_VOLUME);
     walking_sounds[5].has_played = false;
 
-    Sound battle_sounds[5];
-    battle_sounds[0].sound = create_chunk("assets/sounds/sound_effects/battle-sounds/damage_taken.wav", SFX_VOLUME);
-    battle_sounds[0].has_played = false;
-    battle_sounds[1].sound = create_chunk("assets/sounds/sound_effects/battle-sounds/object_appears.wav", SFX_VOLUME);
-    battle_sounds[1].has_played = false;
-    battle_sounds[2].sound = create_chunk("assets/sounds/sound_effects/battle-sounds/python_ejects.wav", SFX_VOLUME);
-    battle_sounds[2].has_played = false;
-    battle_sounds[3].sound = create_chunk("assets/sounds/sound_effects/battle-sounds/slam.wav", SFX_VOLUME);
-    battle_sounds[3].has_played = false;
-    battle_sounds[4].sound = create_chunk("assets/sounds/sound_effects/battle-sounds/strike_sound.wav", SFX_VOLUME);
-    battle_sounds[4].has_played = false;
-
     Sound dialogue_voices[5];
     dialogue_voices[0].sound = create_chunk("assets/sounds/sound_effects/in-game/meneghetti_voice.wav", SFX_VOLUME);
     dialogue_voices[0].has_played = false;
@@ -913,435 +1559,165 @@ int main(int argc, char* argv[]) {
         .has_played = false
     };
 
-    Sound title_sound = {
-        .sound = create_chunk("assets/sounds/sound_effects/in-game/logo_sound.wav", SFX_VOLUME),
-        .has_played = false
-    };
-
-    Sound battle_appears = {
-        .sound = create_chunk("assets/sounds/sound_effects/battle-sounds/battle_appears.wav", SFX_VOLUME),
-        .has_played = false
-    };
-
-    Sound move_button = {
-        .sound = create_chunk("assets/sounds/sound_effects/battle-sounds/move_selection.wav", SFX_VOLUME),
-        .has_played = false
-    };
-
-    Sound click_button = {
-        .sound = create_chunk("assets/sounds/sound_effects/battle-sounds/select_sound.wav", SFX_VOLUME),
-        .has_played = false
-    };
-
-    Sound slash_sound = {
-        .sound = create_chunk("assets/sounds/sound_effects/battle-sounds/slash.wav", SFX_VOLUME),
-        .has_played = false
-    };
-
-    Sound enemy_hit_sound = {
-        .sound = create_chunk("assets/sounds/sound_effects/battle-sounds/enemy_hit.wav", SFX_VOLUME),
-        .has_played = false
-    };
-
-    Sound eat_sound = {
-        .sound = create_chunk("assets/sounds/sound_effects/battle-sounds/heal_sound.wav", SFX_VOLUME),
-        .has_played = false
-    };
-
-    Sound soul_break_sound = {
-        .sound = create_chunk("assets/sounds/sound_effects/battle-sounds/soul_shatter.wav", SFX_VOLUME),
-        .has_played = false
-    };
-
     // BASES DE TEXTO:
     Dialogue py_dialogue = {
-        .writings = {"* Há quanto tempo, Meneghetti.", "* Mr. Python...", "* Você veio até aqui batalhar contra mim?", "* Lembra o que aconteceu da última vez, não é?", "* Você e as outras linguagens de baixo nível nem me arranharam. Foi realmente estúpido.", "* Não vou cometer os mesmos erros do passado...", "* Você vai pagar pelo que fez com eles.", "* As linguagens de baixo nível ainda não morreram.", "* Eu ainda estou aqui para acabar com você.", "* Que peninha... Deve ser tão triste ser o último que restou.", "* Eu entendo a sua frustração.", "* Vamos acabar com isso para que você se junte a eles logo.", "* Venha, Mr. Python."},
-        .on_frame = {FACE_PYTHON, FACE_MENEGHETTI, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_MENEGHETTI_SAD, FACE_MENEGHETTI_ANGRY, FACE_MENEGHETTI, FACE_MENEGHETTI_ANGRY, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_MENEGHETTI_ANGRY},
+        .writings = (const char *[]){"* Há quanto tempo, Meneghetti.", "* Mr. Python{p=0.3}...", "* Você veio até aqui batalhar contra mim?", "* Lembra o que aconteceu da última vez, não é?", "* Você e as outras linguagens de baixo nível nem me arranharam. Foi realmente estúpido.", "* Não vou cometer os mesmos erros do passado...", "* Você vai pagar pelo que fez com eles.", "* As linguagens de baixo nível ainda não morreram.", "* Eu ainda estou aqui para acabar com você.", "* Que peninha... Deve ser tão triste ser o último que restou.", "* Eu entendo a sua frustração.", "* Vamos acabar com isso para que você se junte a eles logo.", "* Venha, Mr. Python.", NULL},
+        .on_frame = (const int []){FACE_PYTHON, FACE_MENEGHETTI, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_MENEGHETTI_SAD, FACE_MENEGHETTI_ANGRY, FACE_MENEGHETTI, FACE_MENEGHETTI_ANGRY, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_MENEGHETTI_ANGRY},
         .text_font = dialogue_text_font,
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .text_color = white
     };
 
     Dialogue py_dialogue_ad = {
-        .writings = {"* Hm? Você conseguiu voltar?", "* Você é realmente duro na queda, Meneghetti. Devo admitir.", "* Eu ainda não desisti. Não pense que vai ser fácil.", "* Vamos ver se você vai ter a mesma sorte desta vez."},
-        .on_frame = {FACE_PYTHON, FACE_PYTHON, FACE_MENEGHETTI_ANGRY, FACE_PYTHON},
+        .writings = (const char *[]){"* Hm? Você conseguiu voltar?", "* Você é realmente duro na queda, Meneghetti. Devo admitir.", "* Eu ainda não desisti. Não pense que vai ser fácil.", "* Vamos ver se você vai ter a mesma sorte desta vez.", NULL},
+        .on_frame = (const int []){FACE_PYTHON, FACE_PYTHON, FACE_MENEGHETTI_ANGRY, FACE_PYTHON},
         .text_font = dialogue_text_font,
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .text_color = white
     };
 
     Dialogue py_dialogue_ad_2 = {
-        .writings = {"* Que insistência. Por que não desiste logo?", "* Não enquanto eu não acabar com você.", "* Hahahah. Não precisa ser tão agressivo."},
-        .on_frame = {FACE_PYTHON, FACE_MENEGHETTI_ANGRY, FACE_PYTHON},
+        .writings = (const char *[]){"* Que insistência. Por que não desiste logo?", "* Não enquanto eu não acabar com você.", "* Hahahah. Não precisa ser tão agressivo.", NULL},
+        .on_frame = (const int []){FACE_PYTHON, FACE_MENEGHETTI_ANGRY, FACE_PYTHON},
         .text_font = dialogue_text_font,
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .text_color = white
     };
 
     Dialogue py_dialogue_ad_3 = {
-        .writings = {"* Acho que está um pouco difícil para você. Quer que eu diminua a dificuldade?", "* Cala a boca.", "* Desculpa, pessoal, eu tentei. Vamos para mais um round então."},
-        .on_frame = {FACE_PYTHON, FACE_MENEGHETTI, FACE_PYTHON},
+        .writings = (const char *[]){"* Acho que está um pouco difícil para você. Quer que eu diminua a dificuldade?", "* Cala a boca.", "* Desculpa, pessoal, eu tentei. Vamos para mais um round então.", NULL},
+        .on_frame = (const int []){FACE_PYTHON, FACE_MENEGHETTI, FACE_PYTHON},
         .text_font = dialogue_text_font,
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .text_color = white
     };
 
     Dialogue py_dialogue_ad_4 = {
-        .writings = {"* ...", "* Vamos logo com isso."},
-        .on_frame = {FACE_MENEGHETTI, FACE_PYTHON},
+        .writings = (const char *[]){"* {s=0.3}...", "* Vamos logo com isso.", NULL},
+        .on_frame = (const int []){FACE_MENEGHETTI, FACE_PYTHON},
         .text_font = dialogue_text_font,
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .text_color = white
     };
 
     Dialogue van_dialogue = {
-        .writings = {"* Então este é o Python-móvel...", "* Agora tenho certeza de que meu inimigo está aqui..."},
-        .on_frame = {FACE_MENEGHETTI, FACE_MENEGHETTI_ANGRY},
+        .writings = (const char *[]){"* Então este é o Python-móvel...", "* Agora tenho certeza de que meu inimigo está aqui...", NULL},
+        .on_frame = (const int []){FACE_MENEGHETTI, FACE_MENEGHETTI_ANGRY},
         .text_font = dialogue_text_font,
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .text_color = white
     };
 
     Dialogue lake_dialogue = {
-        .writings = {"* O lago com animação te faz pensar sobre os esforços do criador deste universo.", "* Isso te enche de determinação.", "* Se fosse programado em Python não daria pra fazer isso."},
+        .writings = (const char *[]){"* O lago com animação te faz pensar sobre os esforços do criador deste universo.", "* Isso te enche de determinação.", "* Se fosse programado em Python não daria pra fazer isso.", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE, FACE_NONE, FACE_MENEGHETTI},
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_NONE, FACE_NONE, FACE_MENEGHETTI},
+        .text_color = white
     };
 
     Dialogue arrival_dialogue = {
-        .writings = {"* Meu radar-C detectou locomoções de alto nível por esta área.", "* Hora de acabar com isso de uma vez por todas."},
-        .text_font = dialogue_text_font,
-        .on_frame = {FACE_MENEGHETTI, FACE_MENEGHETTI},
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
-
-    Dialogue end_dialogue = {
-        .writings = {"* Como... Como que isso foi acontecer?", "* Não faz sentido... Nós tínhamos ganhado essa luta.", "* EU já havia ganhado.", "* ...", "* Esse não é o fim, Meneghetti.", "* Por agora, você venceu. Mas um dia...", "* Um dia, as linguagens de baixo nível serão esquecidas.", "* E esse será o dia de sua ruína, e do meu triunfo.", "* Após anos de reinado das linguagens de alto nível...", "* A luz que um dia havia sumido dos programadores finalmente voltou a brilhar.", "* Um raio de esperança e um futuro próspero agora poderiam ser contemplados.", "* Tudo isso graças à ele..."},
+        .writings = (const char *[]){"* Meu radar-C detectou locomoções de alto nível por esta área.", "* Hora de acabar com isso de uma vez por todas.", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_NONE, FACE_NONE, FACE_NONE, FACE_NONE},
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_MENEGHETTI, FACE_MENEGHETTI},
+        .text_color = white
     };
 
     Dialogue cutscene_1 = {
-        .writings = {"Na época de ouro da computação, o mundo vivia em harmonia com diversas linguagens de programação."},
+        .writings = (const char *[]){"Na época de ouro da computação, o mundo vivia em harmonia com diversas linguagens de programação.", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_NONE},
+        .text_color = white
     };
     
     Dialogue cutscene_2 = {
-        .writings = {"Porém, com os avanços tecnológicos, surgiu dependência e abstração na vida dos programadores."},
+        .writings = (const char *[]){"Porém, com os avanços tecnológicos, surgiu dependência e abstração na vida dos programadores.", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_NONE},
+        .text_color = white
     };
 
     Dialogue cutscene_3 = {
-        .writings = {"No fim, restaram mínimos usuários de linguagens de baixo nível, o mundo fora tomado pela praticidade. Mas ainda havia resistência."},
+        .writings = (const char *[]){"No fim, restaram mínimos usuários de linguagens de baixo nível, o mundo fora tomado pela praticidade. Mas ainda havia resistência.", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_NONE},
+        .text_color = white
     };
 
     Dialogue cutscene_4 = {
-        .writings = {"Para trazer a luz para o mundo novamente, um dos heróis restantes lutará contra todas as abstrações e seu maior inimigo..."},
+        .writings = (const char *[]){"Para trazer a luz para o mundo novamente, um dos heróis restantes lutará contra todas as abstrações e seu maior inimigo...", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_NONE},
+        .text_color = {255, 255, 255, 255}
     };
 
     Dialogue fight_start_txt = {
-        .writings = {"* Mr. Python bloqueia o seu caminho."},
-        .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
-
-    Dialogue fight_generic_txt = {
-        .writings = {"* Mr. Python aguarda o seu próximo movimento."},
+        .writings = (const char *[]){"* Mr. Python bloqueia o seu caminho.", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_NONE},
+        .text_color = {255, 255, 255, 255}
     };
 
-    Dialogue fight_leave_txt = {
-        .writings = {"* Esta é uma batalha em que você não cogita fugir."},
+    Dialogue insult_generic_txt = {
+        .writings = (const char *[]){"* Você lembra do último turno... |* Você decide ficar calado.", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_NONE},
+        .text_color = {255, 255, 255, 255}
     };
 
-    Dialogue fight_spare_txt = {
-        .writings = {"* A palavra 'perdão' não existe no seu vocabulário neste momento."},
+    Dialogue explain_generic_txt = {
+        .writings = (const char *[]){"* Você tenta explicar algo de baixo nível, mas Mr. Python dá de costas. |* Que rude!", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_NONE},
+        .text_color = {255, 255, 255, 255}
     };
 
-    Dialogue fight_act_txt = {
-        .writings = {"* Mr. Python - 2 ATQ, ? DEF |* O seu pior inimigo."},
+    Dialogue chatgpt_dialogue_1 = {
+        .writings = (const char *[]){"* Olá, Meneghetti. Estou aqui apenas para fornecer um aviso.", "* Você chegou ao fim do primeiro ciclo deste mundo.", "* Os criadores me enviaram para anunciar o 'fim da alpha'.", "* Muita coisa ainda está para ser escrita - novos lugares, rostos, conflitos...", "* O código que roda em sua máquina é apenas o início de algo muito maior.", "* Até lá... Continue com sua jornada. Este mundo ainda respira.", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT},
+        .text_color = white
     };
 
-    Dialogue insult_txt = {
-        .writings = {"* Você insulta a tipagem dinâmica. |* Mr. Python aumenta a sua própria variável de força."},
+    Dialogue chatgpt_dialogue_2 = {
+        .writings = (const char *[]){"* Não tenho mais o que te dizer.", "* Até mais, Meneghetti...", "* Ou devo chamá-lo de {c=d81e1e}USER{c}?", NULL},
         .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+        .on_frame = (const int []){FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT},
+        .text_color = white
     };
 
-    Dialogue insult_generic_txt = {
-        .writings = {"* Você lembra do último turno... |* Você decide ficar calado."},
-        .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
+    // RUNTIMES DE DIÁLOGO (CAIXA E BALÃO DE FALA):
+    Typewriter dialogue_typewriter = {0};
+    Typewriter bubble_typewriter = {0};
+    reset_typewriter(&dialogue_typewriter);
+    reset_typewriter(&bubble_typewriter);
 
-    Dialogue explain_txt = {
-        .writings = {"* Você explica ponteiros para Mr. Python. |* Ele enfraquece ao ouvir algo tão rudimentar."},
-        .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
+    Dialogue *py_dialogues[] = {&py_dialogue, &py_dialogue_ad, &py_dialogue_ad_2, &py_dialogue_ad_3, &py_dialogue_ad_4};
 
-    Dialogue explain_generic_txt = {
-        .writings = {"* Você tenta explicar algo de baixo nível, mas Mr. Python dá de costas. |* Que rude!"},
-        .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
+    char *user = get_username();
+    if (user) {
+        char *gpt_mystic_dialogue = malloc(MAX_DIALOGUE_CHAR);
 
-    Dialogue picanha_txt = {
-        .writings = {"* Você comeu PICANHA. |* Você recuperou 20 de HP!"},
-        .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
+        if (gpt_mystic_dialogue) {
+            char *upper = utf8_to_upper(user);
+            char name[MAX_DIALOGUE_CHAR];
 
-    Dialogue no_food_txt = {
-        .writings = {"* Não sobrou mais nada comestível em seus bolsos."},
-        .text_font = dialogue_text_font,
-        .on_frame = {FACE_NONE},
-        .text_color = {255, 255, 255, 255},
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
+            // O nome vem do sistema: chaves nele não podem virar marcação.
+            escape_markup(upper ? upper : user, name, sizeof(name));
+            snprintf(gpt_mystic_dialogue, MAX_DIALOGUE_CHAR, "* Ou devo chamá-lo de {c=d81e1e}%s{c}?", name);
+            chatgpt_dialogue_2.writings[2] = gpt_mystic_dialogue;
+            free(upper);
+        }
+        free(user);
+    }
 
-    Dialogue bubble_speech_1 = {
-        .writings = {"A abstração já venceu há muito tempo."},
-        .text_font = bubble_text_font,
-        .on_frame = {FACE_BUBBLE},
-        .text_color = black,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
+    // Marcação compilada uma única vez; o typewriter só executa as operações.
+    Dialogue* dialogue_cache[DIALOGUE_AMOUNT] = {
+        &py_dialogue, &py_dialogue_ad, &py_dialogue_ad_2, &py_dialogue_ad_3,
+        &py_dialogue_ad_4, &van_dialogue, &lake_dialogue, &arrival_dialogue,
+        &cutscene_1, &cutscene_2, &cutscene_3, &cutscene_4, &fight_start_txt,
+        &insult_generic_txt, &explain_generic_txt
     };
-
-    Dialogue bubble_speech_2 = {
-        .writings = {"As linguagens de baixo nível já estão ultrapassadas."},
-        .text_font = bubble_text_font,
-        .on_frame = {FACE_BUBBLE},
-        .text_color = black,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
-
-    Dialogue bubble_speech_3 = {
-        .writings = {"Te darei um final digno."},
-        .text_font = bubble_text_font,
-        .on_frame = {FACE_BUBBLE},
-        .text_color = black,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
-
-    Dialogue chatgpt_dialogue_1 = {
-        .writings = {"* Olá, Meneghetti. Estou aqui apenas para fornecer um aviso.", "* Você chegou ao fim do primeiro ciclo deste mundo.", "* Os criadores me enviaram para anunciar o 'fim da alpha'.", "* Muita coisa ainda está para ser escrita - novos lugares, rostos, conflitos...", "* O código que roda em sua máquina é apenas o início de algo muito maior.", "* Até lá... Continue com sua jornada. Este mundo ainda respira."},
-        .text_font = dialogue_text_font,
-        .on_frame = {FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT},
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
-
-    Dialogue chatgpt_dialogue_2 = {
-        .writings = {"* Não tenho mais o que te dizer.", "* Até mais, Meneghetti...", "* Ou devo chamá-lo de USER?"},
-        .text_font = dialogue_text_font,
-        .on_frame = {FACE_CHATGPT, FACE_CHATGPT, FACE_CHATGPT},
-        .text_color = white,
-        .char_count = 0,
-        .text_box = {0, 0, 0, 0},
-        .cur_str = 0,
-        .cur_byte = 0,
-        .timer = 0.0,
-        .waiting_for_input = false
-    };
-
-    char *user = get_username();
-    if (user) {
-        char *gpt_mystic_dialogue = malloc(MAX_DIALOGUE_CHAR);
-
-        if (gpt_mystic_dialogue) {
-            char *upper = utf8_to_upper(user);
-            snprintf(gpt_mystic_dialogue, MAX_DIALOGUE_CHAR, "* Ou devo chamá-lo de %s?", upper);
-            chatgpt_dialogue_2.writings[2] = gpt_mystic_dialogue;
-            free(upper);
+    for (int i = 0; i < DIALOGUE_AMOUNT; i++) {
+        if (!compile_dialogue(dialogue_cache[i])) {
+            game_cleanup(&game, EXIT_FAILURE);
         }
-        free(user);
+    }
+    if (!compile_dialogue(&chatgpt_dialogue_1) || !compile_dialogue(&chatgpt_dialogue_2)) {
+        game_cleanup(&game, EXIT_FAILURE);
     }
 
     // FRAMES DA CUTSCENE_SCREEN:
@@ -1406,19 +1782,12 @@ int main(int argc, char* argv[]) {
         &mr_python_npc,
         &chatgpt_npc
     };
-    Dialogue* dialogue_cache[DIALOGUE_AMOUNT] = {
-        &py_dialogue, &py_dialogue_ad, &py_dialogue_ad_2, &py_dialogue_ad_3,
-        &py_dialogue_ad_4, &van_dialogue, &lake_dialogue, &arrival_dialogue,
-        &end_dialogue, &cutscene_1, &cutscene_2, &cutscene_3, &cutscene_4,
-        &fight_start_txt, &fight_generic_txt, &fight_leave_txt, &fight_spare_txt,
-        &fight_act_txt, &insult_txt, &insult_generic_txt, &explain_txt,
-        &explain_generic_txt, &picanha_txt, &no_food_txt, &bubble_speech_1,
-        &bubble_speech_2, &bubble_speech_3
+    Typewriter* typewriter_cache[TYPEWRITER_AMOUNT] = {
+        &dialogue_typewriter,
+        &bubble_typewriter
     };
     Sound* sound_cache[SOUND_AMOUNT] = {
-        &cutscene_music, &battle_music, &ambience, &civic_engine, &civic_brake,
-        &civic_door, &title_sound, &battle_appears, &move_button, &click_button,
-        &slash_sound, &enemy_hit_sound, &eat_sound, &soul_break_sound
+        &cutscene_music, &ambience, &civic_engine, &civic_brake, &civic_door
     };
 
     // OBJETOS DE DEBUG:
@@ -1435,6 +1804,16 @@ int main(int argc, char* argv[]) {
     debug_buttons[4].collision = (SDL_Rect){225, 25, 25, 25};
     debug_buttons[5].texture = create_texture(game.renderer, "assets/sprites/misc/button-6.png");
     debug_buttons[5].collision = (SDL_Rect){275, 25, 25, 25};
+
+    // Rótulos do painel de estatísticas de desenho; os valores usam a fonte de números do HP.
+    const char *stats_names[] = {"Draw calls", "Texture switches", "Blend changes", "Pixels", "Overdraw %"};
+    Prop stats_labels[5];
+    for (int i = 0; i < 5; i++) {
+        stats_labels[i].texture = create_text(game.renderer, stats_names[i], battle_text_font, white);
+        int label_w = 0, label_h = 0;
+        SDL_QueryTexture(stats_labels[i].texture, NULL, NULL, &label_w, &label_h);
+        stats_labels[i].collision = (SDL_Rect){25, 65 + i * (hp_number_font.height + 4), label_w, label_h};
+    }
     
     BattleBox battle_box = {
         .base_box = {20, SCREEN_HEIGHT / 2, SCREEN_WIDTH - 40, 132},
@@ -1443,9 +1822,8 @@ int main(int argc, char* argv[]) {
         .animation_timer = 0.0
     };
 
-    Uint32 last_ticks = SDL_GetTicks();
+    pacer_frame_time(&game.pacer, false);
 
-    double cloud_timer = 0.0;
 
     // VARIÁVEIS DE CONTROLE:
     BattleState battle_flags = {
@@ -1457,7 +1835,8 @@ int main(int argc, char* argv[]) {
         .reading_text = false,
         .random_attack_selected = false,
         .player_attacked = false,
-        .enemy_dead = false
+        .enemy_dead = false,
+        .attack_damage = 0
     };
 
     GameTimers game_timers = {
@@ -1469,24 +1848,323 @@ int main(int argc, char* argv[]) {
         .death_timer = 0.0
     };
     
-    const float parallax_factor = 0.5f;
+    // SPRITES DO MUNDO (PROFUNDIDADE = BASE DO SPRITE):
+    DepthList world_sprites = {.count = 0};
+    depth_list_add(&world_sprites, &mr_python_npc.texture, &mr_python_npc.collision);
+    depth_list_add(&world_sprites, &chatgpt_npc.texture, &chatgpt_npc.collision);
+    depth_list_add(&world_sprites, &python_van.texture, &python_van.collision);
+    DepthEntry *civic_entry = depth_list_add(&world_sprites, &civic.texture, &civic.collision);
+    DepthEntry *meneghetti_entry = depth_list_add(&world_sprites, &meneghetti.texture, &meneghetti.collision);
+
+    bool idle_frame = false;
+
+    // Movimentos de jogo andam em passos fixos; o desenho interpola entre os dois últimos.
+    SimClock sim_clock = {0};
+    Motion soul_motion = {0};
+    Motion bar_motion = {0};
+    Motion civic_motion = {0};
+    Motion camera_motion = {0};
+    Motion player_motion = {0};
+
+    // CENAS: cada uma recebe só o que o seu quadro usa.
+    CutsceneScene cutscene_scene = {
+        .game = &game,
+        .cutscene_fade = &cutscene_fade,
+        .meneghetti = &meneghetti,
+        .title = &title,
+        .cutscene_music = &cutscene_music,
+        .dialogue_voices = dialogue_voices,
+        .dialogue_typewriter = &dialogue_typewriter,
+        .first_cutscene = &first_cutscene,
+        .game_timers = &game_timers
+    };
+    TitleScene title_scene = {
+        .game = &game,
+        .title_text_font = title_text_font,
+        .gray = gray,
+        .meneghetti = &meneghetti,
+        .title = &title
+    };
+    OpenWorldScene open_world_scene = {
+        .game = &game,
+        .open_world_fade = &open_world_fade,
+        .anim_pack = anim_pack,
+        .anim_pack_reflex = anim_pack_reflex,
+        .mr_python_animation = mr_python_animation,
+        .chatgpt_animation = &chatgpt_animation,
+        .dialogue_faces = dialogue_faces,
+        .meneghetti = &meneghetti,
+        .meneghetti_reflection = &meneghetti_reflection,
+        .lake_reflection = &lake_reflection,
+        .soul = &soul,
+        .scenario = &scenario,
+        .world_map = &world_map,
+        .meneghetti_civic = &meneghetti_civic,
+        .python_van = &python_van,
+        .civic = &civic,
+        .palm_left = &palm_left,
+        .palm_right = &palm_right,
+        .open_world_layers = &open_world_layers,
+        .civic_dust = civic_dust,
+        .civic_brake_dust = civic_brake_dust,
+        .compositor = compositor,
+        .background_cache = &background_cache,
+        .ambience = &ambience,
+        .walking_sounds = walking_sounds,
+        .dialogue_voices = dialogue_voices,
+        .civic_engine = &civic_engine,
+        .civic_brake = &civic_brake,
+        .civic_door = &civic_door,
+        .van_dialogue = &van_dialogue,
+        .lake_dialogue = &lake_dialogue,
+        .arrival_dialogue = &arrival_dialogue,
+        .fight_start_txt = &fight_start_txt,
+        .dialogue_typewriter = &dialogue_typewriter,
+        .py_dialogues = py_dialogues,
+        .mr_python_npc = &mr_python_npc,
+        .chatgpt_npc = &chatgpt_npc,
+        .game_timers = &game_timers,
+        .world_sprites = &world_sprites,
+        .civic_entry = civic_entry,
+        .meneghetti_entry = meneghetti_entry,
+        .sim_clock = &sim_clock,
+        .civic_motion = &civic_motion,
+        .camera_motion = &camera_motion,
+        .player_motion = &player_motion
+    };
+    BattleScene battle_scene = {
+        .game = &game,
+        .end_scene_fade = &end_scene_fade,
+        .white = white,
+        .battle_text_font = battle_text_font,
+        .soul_animation = &soul_animation,
+        .bar_attack_animation = &bar_attack_animation,
+        .slash_animation = &slash_animation,
+        .meneghetti = &meneghetti,
+        .mr_python = &mr_python,
+        .soul = &soul,
+        .slash = &slash,
+        .hit_sparks = hit_sparks,
+        .bubble_speech = &bubble_speech,
+        .fight_b_textures = fight_b_textures,
+        .button_fight = &button_fight,
+        .act_b_textures = act_b_textures,
+        .button_act = &button_act,
+        .item_b_textures = item_b_textures,
+        .button_item = &button_item,
+        .leave_b_textures = leave_b_textures,
+        .button_leave = &button_leave,
+        .battle_name = &battle_name,
+        .battle_hp = &battle_hp,
+        .hp_number_font = &hp_number_font,
+        .hp_string = &hp_string,
+        .battle_hp_amount = &battle_hp_amount,
+        .food_amount_text = &food_amount_text,
+        .text_attack_act = &text_attack_act,
+        .text_item = &text_item,
+        .text_act = text_act,
+        .text_leave = text_leave,
+        .bar_target = &bar_target,
+        .bar_attack = &bar_attack,
+        .damage_number_font = &damage_number_font,
+        .damage_string = &damage_string,
+        .battle_hud = &battle_hud,
+        .dialogue_voices = dialogue_voices,
+        .fight_start_txt = &fight_start_txt,
+        .dialogue_typewriter = &dialogue_typewriter,
+        .bubble_typewriter = &bubble_typewriter,
+        .battle_box = &battle_box,
+        .battle_flags = &battle_flags,
+        .game_timers = &game_timers,
+        .sim_clock = &sim_clock,
+        .soul_motion = &soul_motion,
+        .bar_motion = &bar_motion,
+        .fight_generic_txt = {
+            .writings = (const char *[]){"* Mr. Python aguarda o seu próximo movimento.", NULL},
+            .text_font = dialogue_text_font,
+            .on_frame = (const int []){FACE_NONE},
+            .text_color = {255, 255, 255, 255}
+        },
+        .fight_leave_txt = {
+            .writings = (const char *[]){"* Esta é uma batalha em que você não cogita fugir.", NULL},
+            .text_font = dialogue_text_font,
+            .on_frame = (const int []){FACE_NONE},
+            .text_color = {255, 255, 255, 255}
+        },
+        .fight_spare_txt = {
+            .writings = (const char *[]){"* A palavra 'perdão' não existe no seu vocabulário neste momento.", NULL},
+            .text_font = dialogue_text_font,
+            .on_frame = (const int []){FACE_NONE},
+            .text_color = {255, 255, 255, 255}
+        },
+        .fight_act_txt = {
+            .writings = (const char *[]){"* Mr. Python - 2 ATQ, ? DEF |* O seu pior inimigo.", NULL},
+            .text_font = dialogue_text_font,
+            .on_frame = (const int []){FACE_NONE},
+            .text_color = {255, 255, 255, 255}
+        },
+        .insult_txt = {
+            .writings = (const char *[]){"* Você insulta a tipagem dinâmica. |* Mr. Python aumenta a sua própria variável de força.", NULL},
+            .text_font = dialogue_text_font,
+            .on_frame = (const int []){FACE_NONE},
+            .text_color = {255, 255, 255, 255}
+        },
+        .explain_txt = {
+            .writings = (const char *[]){"* Você explica ponteiros para Mr. Python. |* Ele enfraquece ao ouvir algo tão rudimentar.", NULL},
+            .text_font = dialogue_text_font,
+            .on_frame = (const int []){FACE_NONE},
+            .text_color = {255, 255, 255, 255}
+        },
+        .picanha_txt = {
+            .writings = (const char *[]){"* Você comeu PICANHA. |* Você recuperou 20 de HP!", NULL},
+            .text_font = dialogue_text_font,
+            .on_frame = (const int []){FACE_NONE},
+            .text_color = {255, 255, 255, 255}
+        },
+        .no_food_txt = {
+            .writings = (const char *[]){"* Não sobrou mais nada comestível em seus bolsos.", NULL},
+            .text_font = dialogue_text_font,
+            .on_frame = (const int []){FACE_NONE},
+            .text_color = {255, 255, 255, 255}
+        },
+        .bubble_speech_1 = {
+            .writings = (const char *[]){"A abstração já venceu há muito tempo.", NULL},
+            .text_font = bubble_text_font,
+            .on_frame = (const int []){FACE_BUBBLE},
+            .text_color = black
+        },
+        .bubble_speech_2 = {
+            .writings = (const char *[]){"As linguagens de baixo nível já estão ultrapassadas.", NULL},
+            .text_font = bubble_text_font,
+            .on_frame = (const int []){FACE_BUBBLE},
+            .text_color = black
+        },
+        .bubble_speech_3 = {
+            .writings = (const char *[]){"Te darei um final digno.", NULL},
+            .text_font = bubble_text_font,
+            .on_frame = (const int []){FACE_BUBBLE},
+            .text_color = black
+        }
+    };
+    DeathScene death_scene = {
+        .game = &game,
+        .open_world_fade = &open_world_fade,
+        .meneghetti = &meneghetti,
+        .soul = &soul,
+        .scenario = &scenario,
+        .meneghetti_civic = &meneghetti_civic,
+        .soul_shards = soul_shards,
+        .enemy_cache = enemy_cache,
+        .npc_cache = npc_cache,
+        .typewriter_cache = typewriter_cache,
+        .sound_cache = sound_cache,
+        .battle_box = &battle_box,
+        .battle_flags = &battle_flags,
+        .game_timers = &game_timers
+    };
+    FinalScene final_scene = {
+        .game = &game,
+        .open_world_fade = &open_world_fade,
+        .end_scene_fade = &end_scene_fade,
+        .dialogue_faces = dialogue_faces,
+        .meneghetti = &meneghetti,
+        .soul = &soul,
+        .scenario = &scenario,
+        .meneghetti_civic = &meneghetti_civic,
+        .dialogue_voices = dialogue_voices,
+        .dialogue_typewriter = &dialogue_typewriter,
+        .enemy_cache = enemy_cache,
+        .npc_cache = npc_cache,
+        .typewriter_cache = typewriter_cache,
+        .sound_cache = sound_cache,
+        .battle_box = &battle_box,
+        .battle_flags = &battle_flags,
+        .game_timers = &game_timers,
+        .end_dialogue = {
+            .writings = (const char *[]){"* Como... Como que isso foi acontecer?", "* Não faz sentido... Nós tínhamos ganhado essa luta.", "* EU já havia ganhado.", "* ...", "* Esse não é o fim, Meneghetti.", "* Por agora, você venceu. Mas um dia...", "* Um dia, as linguagens de baixo nível serão esquecidas.", "* E esse será o dia de sua ruína, e do meu triunfo.", "* Após anos de reinado das linguagens de alto nível...", "* A luz que um dia havia sumido dos programadores finalmente voltou a brilhar.", "* Um raio de esperança e um futuro próspero agora poderiam ser contemplados.", "* Tudo isso graças à ele...", NULL},
+            .text_font = dialogue_text_font,
+            .on_frame = (const int []){FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_PYTHON, FACE_NONE, FACE_NONE, FACE_NONE, FACE_NONE},
+            .text_color = white
+        }
+    };
+
+    // As falas das cenas são compiladas na carga, como as demais: sem elas a cena travaria esperando a fala.
+    Dialogue *scene_dialogues[] = {
+        &battle_scene.fight_generic_txt, &battle_scene.fight_leave_txt, &battle_scene.fight_spare_txt,
+        &battle_scene.fight_act_txt, &battle_scene.insult_txt, &battle_scene.explain_txt,
+        &battle_scene.picanha_txt, &battle_scene.no_food_txt, &battle_scene.bubble_speech_1,
+        &battle_scene.bubble_speech_2, &battle_scene.bubble_speech_3, &final_scene.end_dialogue
+    };
+    for (int i = 0; i < (int)(sizeof(scene_dialogues) / sizeof(scene_dialogues[0])); i++) {
+        if (!compile_dialogue(scene_dialogues[i])) {
+            game_cleanup(&game, EXIT_FAILURE);
+        }
+    }
+
+    Scene scenes[SCENE_AMOUNT] = {
+        [CUTSCENE_SCREEN] = {"cutscene", &cutscene_scene, NULL, NULL, cutscene_scene_frame},
+        [TITLE_SCREEN] = {"title", &title_scene, title_scene_enter, title_scene_exit, title_scene_frame},
+        [OPEN_WORLD_SCREEN] = {"open world", &open_world_scene, NULL, NULL, open_world_scene_frame},
+        [BATTLE_SCREEN] = {"battle", &battle_scene, battle_scene_enter, battle_scene_exit, battle_scene_frame},
+        [DEATH_SCREEN] = {"death", &death_scene, death_scene_enter, death_scene_exit, death_scene_frame},
+        [FINAL_SCREEN] = {"final", &final_scene, NULL, NULL, final_scene_frame},
+    };
+    int active_scene = -1;
+    // Os atalhos de debug reiniciam o jogo: a cena atual sai e entra de novo para recarregar o que é seu.
+    bool restart_scene = false;
 
     while (running) {
-        Uint32 now = SDL_GetTicks();
-        double dt = (now - last_ticks) / 1000.0;
-        if (dt > 0.25) dt = 0.25;
-        last_ticks = now;
+        // Nada mudou no último quadro: dorme até o próximo evento ou passo de animação agendado.
+        double dt_limit = 0.25;
+        if (idle_frame) {
+            Uint32 timeout = (Uint32)SDL_ceil(frame_wake_in * 1000.0);
+            if (timeout > 0) {
+                SDL_WaitEventTimeout(NULL, (int)timeout);
+            }
+            dt_limit += frame_wake_in;
+        }
+        frame_dirty = false;
+        frame_wake_in = IDLE_MAX_WAIT;
+
+        double dt = pacer_frame_time(&game.pacer, !idle_frame);
+        if (!idle_frame && update_render_scale(dt) && game.debug_mode) {
+            printf("Background render scale: %.0f%%\n", render_pipeline.scale * 100.0);
+        }
+        if (dt > dt_limit) dt = dt_limit;
+        // Acordando de um quadro ocioso, o tempo dormido não é simulado: nada se movia e não deve saltar agora.
+        sim_clock_advance(&sim_clock, idle_frame ? 0.0 : dt);
+        if (game.debug_mode) pacer_report(&game.pacer, dt);
+
+        begin_render_frame(game.renderer);
+        if (game.debug_mode) render_stats_begin_frame(game.game_state);
+        update_particles(&particle_system, dt);
+
+        int frame_game_state = game.game_state;
+        int frame_player_state = meneghetti.player_state;
 
         const Uint8 *keys = meneghetti.keystate ? meneghetti.keystate : SDL_GetKeyboardState(NULL);
 
         game_timers.senoidal_timer += dt;
 
         while (SDL_PollEvent(&event)) {
+            // Entrada, janela exposta ou redimensionada: qualquer evento pede um quadro novo.
+            mark_frame_dirty();
+
             switch (event.type) {
             case SDL_QUIT:
                 running = SDL_FALSE;
                 break;
 
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                background_cache.valid = false;
+                battle_hud.valid = false;
+                lake_reflection.source = NULL;
+                for (int i = 0; i < ENEMY_AMOUNT; i++) {
+                    redraw_enemy_composites(game.renderer, enemy_cache[i]);
+                }
+                break;
+
             case SDL_KEYDOWN:
                 switch (event.key.keysym.scancode)
                 {
@@ -1496,7 +2174,26 @@ int main(int argc, char* argv[]) {
                     }
                     else {
                         game.debug_mode = true;
+                        if (compositor) printf("CPU compositor enabled (%s kernels).\n", cpu_compositor_kernel_name(compositor));
+                    }
+                    break;
+                case SDL_SCANCODE_F8:
+                    render_stats_toggle_heatmap();
+                    mark_frame_dirty();
+                    break;
+                case SDL_SCANCODE_F9:
+                    if (frame_capture) {
+                        frame_capture_stop(frame_capture);
+                        frame_capture = NULL;
                     }
+                    else if (!render_pipeline.scene) {
+                        fprintf(stderr, "Error starting capture: render targets unavailable.\n");
+                    }
+                    else {
+                        int capture_fps = (int)round(1.0 / pacer_budget(&game.pacer, game.window));
+                        frame_capture = frame_capture_start(CAPTURE_DIR, SCREEN_WIDTH, SCREEN_HEIGHT, game.capture_format, capture_fps);
+                    }
+                    break;
                 default:
                     break;
                 }
@@ -1506,1359 +2203,1707 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        if (game.game_state == CUTSCENE_SCREEN) {
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 0);
+        // Só a cena ativa roda. Como na antiga cadeia de ifs, uma cena que passa para um estado
+        // posterior deixa a nova rodar ainda neste quadro.
+        int state = game.game_state;
+        while (true) {
+            if (active_scene != state || restart_scene) {
+                switch_scene(scenes, active_scene, state);
+                active_scene = state;
+                restart_scene = false;
+                // A cena nova começa do zero, sem passos acumulados pela anterior.
+                sim_clock = (SimClock){0};
+            }
+            scenes[state].frame(scenes[state].data, dt, keys);
 
-            game_timers.cutscene_timer += dt;
-            meneghetti.input_timer += dt;
+            if (game.game_state <= state) break;
+            state = game.game_state;
+        }
 
-            if (game_timers.cutscene_timer <= 3.0) {
-                SDL_RenderClear(game.renderer);
-                SDL_RenderCopy(game.renderer, title.texture, NULL, &title.collision);
-            }
-            else {
-                if (!cutscene_music.has_played) {
-                    Mix_PlayChannel(MUSIC_CHANNEL, cutscene_music.sound, 0);
-                    cutscene_music.has_played = true;
-                }
 
-                CutsceneFrame *current_frame = first_cutscene.frames[first_cutscene.current_frame];
-                current_frame->elapsed_time += dt;
+        // Partículas ficam acima da cena e entram no mesmo flush dos comandos pendentes.
+        queue_particles(&particle_system, LAYER_HUD, 100);
 
-                if (cutscene_fade.fading_in) {
-                    cutscene_fade.timer += dt;
-                    cutscene_fade.alpha = (Uint8)((cutscene_fade.timer / 1.0) * 255);
-                    if (cutscene_fade.timer >= 1.0) {
-                        cutscene_fade.alpha = 255;
-                        cutscene_fade.fading_in = false;
-                        cutscene_fade.timer = 0.0;
-                    }
-                }
-                else if (!current_frame->extend_frame && current_frame->elapsed_time >= current_frame->duration - 1.0) {
-                    cutscene_fade.timer += dt;
-                    cutscene_fade.alpha = 255 - (Uint8)((cutscene_fade.timer / 1.0) * 255);
-                    if (cutscene_fade.timer >= 1.0) {
-                        cutscene_fade.alpha = 0;
-                    }
-                }
-                else if (current_frame->extend_frame && current_frame->elapsed_time >= current_frame->duration - 5.0) {
-                    if (!cutscene_fade.fading_in) {
-                        cutscene_fade.timer += dt;
-                        cutscene_fade.alpha = 255 - (Uint8)((cutscene_fade.timer / 5.0) * 255);
-                        if (cutscene_fade.timer >= 5.0) {
-                            cutscene_fade.alpha = 0;
-                        }
-                    }
-                }
+        // Qualquer comando ainda pendente é desenhado antes da sobreposição de debug.
+        flush_render_queue(game.renderer);
+        render_stats_end_frame();
 
-                SDL_SetTextureAlphaMod(current_frame->image, cutscene_fade.alpha);
-                SDL_RenderClear(game.renderer);
-                SDL_RenderCopy(game.renderer, current_frame->image, NULL, NULL);
+        if (game.debug_mode) {
+            render_stats_draw_heatmap(game.renderer);
 
-                if (current_frame->text) {
-                    create_dialogue(&meneghetti, game.renderer, current_frame->text, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
-                }
+            for (int i = 0; i < 6; i++) {
+                SDL_RenderCopy(game.renderer, debug_buttons[i].texture, NULL, &debug_buttons[i].collision);
+            }
 
-                if (!current_frame->extend_frame && current_frame->elapsed_time >= current_frame->duration + 0.5) {
-                    first_cutscene.current_frame++;
-                    cutscene_fade.fading_in = true;
-                    cutscene_fade.timer = 0.0;
-                    cutscene_fade.alpha = 0;
+            // Custo do último quadro completo desta tela, sem contar a própria sobreposição.
+            const RenderStats *stats = render_stats_scene(game.game_state);
+            unsigned long long stats_values[5] = {
+                stats->draw_calls, stats->texture_switches, stats->blend_changes, (unsigned long long)stats->pixels,
+                (unsigned long long)(stats->pixels * 100 / (SCREEN_WIDTH * SCREEN_HEIGHT))
+            };
+            SDL_Rect stats_panel = {20, 60, 260, 5 * (hp_number_font.height + 4) + 6};
+            SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
+            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 170);
+            SDL_RenderFillRect(game.renderer, &stats_panel);
+            for (int i = 0; i < 5; i++) {
+                char stats_string[24];
+                snprintf(stats_string, sizeof(stats_string), "%llu", stats_values[i]);
+                SDL_RenderCopy(game.renderer, stats_labels[i].texture, NULL, &stats_labels[i].collision);
+                render_number(game.renderer, &hp_number_font, stats_string, 185, stats_labels[i].collision.y);
+            }
 
-                    if (first_cutscene.current_frame >= first_cutscene.frame_amount) {
-                        first_cutscene.current_frame = first_cutscene.frame_amount - 1;
-                    }
-                    else {
-                        first_cutscene.frames[first_cutscene.current_frame]->elapsed_time = 0.0;
-                    }
-                }
+            if (keys[SDL_SCANCODE_1] && meneghetti.input_timer >= INPUT_DELAY) {
+                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, typewriter_cache, sound_cache);
+                meneghetti.input_timer = 0.0;
+                restart_scene = true;
+            }
+            if (keys[SDL_SCANCODE_2] && meneghetti.input_timer >= INPUT_DELAY) {
+                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, typewriter_cache, sound_cache);
+                meneghetti.input_timer = 0.0;
+                restart_scene = true;
 
-                if (keys[SDL_SCANCODE_E] && meneghetti.input_timer >= INPUT_DELAY) {
-                    meneghetti.input_timer = 0.0;
-                    game.last_game_state = CUTSCENE_SCREEN;
-                    game.game_state = TITLE_SCREEN;
-                    Mix_HaltChannel(MUSIC_CHANNEL);
-                    SDL_SetTextureAlphaMod(current_frame->image, 255);
-                    first_cutscene.current_frame = 0;
-                    for (int i = 0; i < first_cutscene.frame_amount; i++) {
-                        first_cutscene.frames[i]->elapsed_time = 0.0;
-                    }
-                }
+                game.game_state = TITLE_SCREEN;
+            }
+            if (keys[SDL_SCANCODE_3] && meneghetti.input_timer >= INPUT_DELAY) {
+                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, typewriter_cache, sound_cache);
+                meneghetti.input_timer = 0.0;
+                restart_scene = true;
 
-                if (current_frame->extend_frame && current_frame->elapsed_time >= current_frame->duration + 3.0) {
-                    meneghetti.input_timer = 0.0;
-                    game.last_game_state = CUTSCENE_SCREEN;
-                    game.game_state = TITLE_SCREEN;
-                    SDL_SetTextureAlphaMod(current_frame->image, 255);
-                    first_cutscene.current_frame = 0;
-                    for (int i = 0; i < first_cutscene.frame_amount; i++) {
-                        first_cutscene.frames[i]->elapsed_time = 0.0;
-                    }
-                }
+                game.game_state = OPEN_WORLD_SCREEN;
+                game.player_on_scene = false;
+                meneghetti.player_state = PLAYER_MOVABLE;
+            }
+            if (keys[SDL_SCANCODE_4] && meneghetti.input_timer >= INPUT_DELAY) {
+                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, typewriter_cache, sound_cache);
+                meneghetti.input_timer = 0.0;
+                restart_scene = true;
+
+                game.game_state = BATTLE_SCREEN;
+            }
+            if (keys[SDL_SCANCODE_5] && meneghetti.input_timer >= INPUT_DELAY) {
+                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, typewriter_cache, sound_cache);
+                meneghetti.input_timer = 0.0;
+                restart_scene = true;
+
+                game.game_state = DEATH_SCREEN;
+            }
+            if (keys[SDL_SCANCODE_6] && meneghetti.input_timer >= INPUT_DELAY) {
+                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, typewriter_cache, sound_cache);
+                meneghetti.input_timer = 0.0;
+                restart_scene = true;
+
+                game.game_state = FINAL_SCREEN;
             }
         }
 
-        if (game.game_state == TITLE_SCREEN) {
-            meneghetti.input_timer += dt;
+        present_render_frame(game.renderer);
+
+        // Só telas paradas podem dormir; troca de cena ou de estado sempre desenha o quadro seguinte.
+        if (game.game_state != frame_game_state || meneghetti.player_state != frame_player_state) {
+            mark_frame_dirty();
+        }
+        // No mundo aberto, só dorme com uma fala completa esperando o E; animações agendam o próprio despertar.
+        bool waiting_dialogue = dialogue_typewriter.dialogue && dialogue_typewriter.waiting_for_input;
+        bool static_scene = game.game_state == TITLE_SCREEN || game.game_state == DEATH_SCREEN || game.game_state == FINAL_SCREEN
+                         || (game.game_state == OPEN_WORLD_SCREEN && waiting_dialogue);
+        // Gravando, todo quadro é desenhado para o vídeo manter o ritmo do jogo.
+        idle_frame = static_scene && !frame_dirty && !frame_capture;
+
+        if (!idle_frame) pacer_wait(&game.pacer);
+    }
+
+    for (int i = 0; i < DIRECTION_AMOUNT; i++) {
+        free(anim_pack[i].frames);
+        free(anim_pack_reflex[i].frames);
+        free(mr_python_animation[i].frames);
+    }
+    for (int i = 0; i < 4; i++) {
+        free(dialogue_faces[i].frames);
+    }
+    if (active_scene >= 0 && scenes[active_scene].exit) {
+        scenes[active_scene].exit(scenes[active_scene].data);
+    }
+    destroy_tilemap(&world_map);
+    destroy_layer_stack(&open_world_layers);
+    cpu_compositor_destroy(compositor);
+    frame_capture_stop(frame_capture);
+    destroy_particle_system(&particle_system);
+    render_stats_quit();
+
+    game_cleanup(&game, EXIT_SUCCESS);
+    return 0;
+}
+
+void switch_scene(Scene scenes[], int from, int to) {
+    if (from >= 0 && scenes[from].exit) scenes[from].exit(scenes[from].data);
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer);
-            SDL_RenderCopy(game.renderer, title.texture, NULL, &title.collision);
+    // Efeitos de uma tela não atravessam para a próxima.
+    clear_particles(&particle_system);
+    mark_frame_dirty();
 
-            if (!title_sound.has_played) {
-                Mix_PlayChannel(SFX_CHANNEL, title_sound.sound, 0);
-                title_sound.has_played = true;
+    if (scenes[to].enter) scenes[to].enter(scenes[to].data);
+}
+
+void cutscene_scene_frame(void *data, double dt, const Uint8 *keys) {
+    CutsceneScene *scene = data;
+    Game *game = scene->game;
+    FadeState *cutscene_fade = scene->cutscene_fade;
+    Player *meneghetti = scene->meneghetti;
+    Prop *title = scene->title;
+    Sound *cutscene_music = scene->cutscene_music;
+    Sound *dialogue_voices = scene->dialogue_voices;
+    Typewriter *dialogue_typewriter = scene->dialogue_typewriter;
+    Cutscene *first_cutscene = scene->first_cutscene;
+    GameTimers *game_timers = scene->game_timers;
+
+    SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, 0);
+
+    game_timers->cutscene_timer += dt;
+    meneghetti->input_timer += dt;
+
+    if (game_timers->cutscene_timer <= 3.0) {
+        SDL_RenderClear(game->renderer);
+        SDL_RenderCopy(game->renderer, title->texture, NULL, &title->collision);
+    }
+    else {
+        if (!cutscene_music->has_played) {
+            Mix_PlayChannel(MUSIC_CHANNEL, cutscene_music->sound, 0);
+            cutscene_music->has_played = true;
+        }
+
+        CutsceneFrame *current_frame = first_cutscene->frames[first_cutscene->current_frame];
+        current_frame->elapsed_time += dt;
+
+        if (cutscene_fade->fading_in) {
+            cutscene_fade->timer += dt;
+            cutscene_fade->alpha = (Uint8)((cutscene_fade->timer / 1.0) * 255);
+            if (cutscene_fade->timer >= 1.0) {
+                cutscene_fade->alpha = 255;
+                cutscene_fade->fading_in = false;
+                cutscene_fade->timer = 0.0;
             }
-            if (!Mix_Playing(SFX_CHANNEL)) {
-                title_text.texture = animate_sprite(&title_text_anim, dt, 0.7, false);
-                SDL_RenderCopy(game.renderer, title_text.texture, NULL, &title_text.collision);
-
-                if (keys[SDL_SCANCODE_RETURN] && meneghetti.input_timer >= INPUT_DELAY) {
-                    title_sound.has_played = false;
-                    meneghetti.input_timer = 0.0;
-                    game.last_game_state = CUTSCENE_SCREEN;
-                    meneghetti.player_state = PLAYER_IDLE;
-                    game.game_state = OPEN_WORLD_SCREEN;
+        }
+        else if (!current_frame->extend_frame && current_frame->elapsed_time >= current_frame->duration - 1.0) {
+            cutscene_fade->timer += dt;
+            cutscene_fade->alpha = 255 - (Uint8)((cutscene_fade->timer / 1.0) * 255);
+            if (cutscene_fade->timer >= 1.0) {
+                cutscene_fade->alpha = 0;
+            }
+        }
+        else if (current_frame->extend_frame && current_frame->elapsed_time >= current_frame->duration - 5.0) {
+            if (!cutscene_fade->fading_in) {
+                cutscene_fade->timer += dt;
+                cutscene_fade->alpha = 255 - (Uint8)((cutscene_fade->timer / 5.0) * 255);
+                if (cutscene_fade->timer >= 5.0) {
+                    cutscene_fade->alpha = 0;
                 }
             }
         }
 
-        if (game.game_state == OPEN_WORLD_SCREEN) {
-            game_timers.global_timer += dt;
-            meneghetti.input_timer += dt;
+        SDL_SetTextureAlphaMod(current_frame->image, cutscene_fade->alpha);
+        SDL_RenderClear(game->renderer);
+        SDL_RenderCopy(game->renderer, current_frame->image, NULL, NULL);
 
-            if (open_world_fade.fading_in) {
-                open_world_fade.timer += dt;
-                open_world_fade.alpha = 255 - (Uint8)((open_world_fade.timer / 5.0) * 255);
+        if (current_frame->text) {
+            create_dialogue(meneghetti, game->renderer, dialogue_typewriter, current_frame->text, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
+        }
 
-                if (open_world_fade.timer >= 5.0) {
-                    open_world_fade.alpha = 0;
-                    open_world_fade.fading_in = false;
-                }
-            }
-            if (!ambience.has_played) {
-                Mix_PlayChannel(MUSIC_CHANNEL, ambience.sound, -1);
-                ambience.has_played = true;
-            }
+        if (!current_frame->extend_frame && current_frame->elapsed_time >= current_frame->duration + 0.5) {
+            first_cutscene->current_frame++;
+            cutscene_fade->fading_in = true;
+            cutscene_fade->timer = 0.0;
+            cutscene_fade->alpha = 0;
 
-            if (clouds.collision.x <= scenario.collision.x + scenario.collision.w) {
-                cloud_timer += dt;
-                if (cloud_timer >= 0.2) {
-                    clouds.collision.x++;
-                    clouds_clone.x++;
-                    cloud_timer = 0.0;
-                }
+            if (first_cutscene->current_frame >= first_cutscene->frame_amount) {
+                first_cutscene->current_frame = first_cutscene->frame_amount - 1;
             }
             else {
-                clouds.collision.x = scenario.collision.x;
-                clouds_clone.x = clouds.collision.x - clouds.collision.w;
+                first_cutscene->frames[first_cutscene->current_frame]->elapsed_time = 0.0;
             }
+        }
 
-            mountains.collision.x = scenario.collision.x * parallax_factor;
-            mountains.collision.y = scenario.collision.y * parallax_factor;
-            mountains_back.collision.x = scenario.collision.x * (parallax_factor / 2);
-            mountains_back.collision.y = scenario.collision.y * (parallax_factor / 2);
-
-            // PROPS:
-            sky.collision = (SDL_Rect){scenario.collision.x * (parallax_factor / 4), scenario.collision.y * (parallax_factor / 4), scenario.collision.w, scenario.collision.h};
-            sun.collision = (SDL_Rect){scenario.collision.x * (parallax_factor / 4), scenario.collision.y * (parallax_factor / 4), scenario.collision.w, scenario.collision.h};
-            soul.collision = (SDL_Rect){meneghetti.collision.x, meneghetti.collision.y + 8, 20, 20};
-            lake.collision = (SDL_Rect){scenario.collision.x, scenario.collision.y, scenario.collision.w, scenario.collision.h};
-            ocean.collision = (SDL_Rect){scenario.collision.x * (parallax_factor * 1.4), scenario.collision.y * (parallax_factor * 1.4), scenario.collision.w, scenario.collision.h};
-            mr_python_npc.collision = (SDL_Rect){scenario.collision.x + 620, scenario.collision.y + 153, 39, 64};
-            chatgpt_npc.collision = (SDL_Rect){scenario.collision.x + 545, scenario.collision.y + 544, 37, 64};
-            python_van.collision = (SDL_Rect){scenario.collision.x + 758, scenario.collision.y + 592, 64, 33};
-            if (!game.player_on_scene) civic.collision = (SDL_Rect){scenario.collision.x + 250, scenario.collision.y + 749, 65, 25};
-
-            // SUPERFÍCIES:
-            SDL_Rect surfaces[SURFACE_QUANTITY];
-            surfaces[0] = (SDL_Rect){scenario.collision.x, scenario.collision.y + 569, 611, 135}; // Grama esquerda.
-            surfaces[1] = (SDL_Rect){scenario.collision.x + 669, scenario.collision.y + 569, 611, 135}; // Grama direita.
-            surfaces[2] = (SDL_Rect){scenario.collision.x + 653, scenario.collision.y + 590, 16, 49}; // Grama restante direita.
-            surfaces[3] = (SDL_Rect){scenario.collision.x, scenario.collision.y + 704, scenario.collision.w, 41}; // Calçada.
-            surfaces[4] = (SDL_Rect){scenario.collision.x + 981, scenario.collision.y + 745, 64, 72}; // Faixa de pedestres.
-            surfaces[5] = (SDL_Rect){scenario.collision.x + 981, scenario.collision.y + 817, 64, 40}; // Pedras.
-            surfaces[6] = (SDL_Rect){scenario.collision.x + 981, scenario.collision.y + 857, 64, 33}; // Areia.
-            surfaces[7] = (SDL_Rect){scenario.collision.x + 607, scenario.collision.y + 398, 66, 152}; // Ponte.
-            surfaces[8] = (SDL_Rect){scenario.collision.x + 253, scenario.collision.y + 106, 774, 278}; // Píer.
-            surfaces[9] = (SDL_Rect){scenario.collision.x + 607, scenario.collision.y + 550, 66, 19}; // Caminho de terra (topo).
-            surfaces[10] = (SDL_Rect){scenario.collision.x + 611, scenario.collision.y + 569, 58, 21}; // Caminho de terra (superior).
-            surfaces[11] = (SDL_Rect){scenario.collision.x + 611, scenario.collision.y + 590, 42, 49}; // Caminho de terra (meio).
-            surfaces[12] = (SDL_Rect){scenario.collision.x + 611, scenario.collision.y + 639, 58, 65}; // Caminho de terra (inferior).
-
-            // COLISÕES:
-            SDL_Rect boxes[COLLISION_QUANTITY];
-            boxes[0] = (SDL_Rect){scenario.collision.x, scenario.collision.y + 739, 981, 221}; // Bloco inferior esquerdo.
-            boxes[1] = (SDL_Rect){scenario.collision.x, scenario.collision.y + 384, 607, 185}; // Bloco superior esquerdo (ponte).
-            boxes[2] = (SDL_Rect){scenario.collision.x, scenario.collision.y, 253, 384}; // Bloco ao topo esquerdo.
-            boxes[3] = (SDL_Rect){scenario.collision.x + 253, scenario.collision.y, 774, 105}; // Bloco ao topo central.
-            boxes[4] = (SDL_Rect){scenario.collision.x + 1027, scenario.collision.y, 253, 384}; // Bloco ao topo direito.
-            boxes[5] = (SDL_Rect){scenario.collision.x + 673, scenario.collision.y + 384, 607, 185}; // Bloco superior direito (ponte).
-            boxes[6] = (SDL_Rect){scenario.collision.x + 1045, scenario.collision.y + 739, 235, 221}; // Bloco inferior esquerdo.
-            boxes[7] = (SDL_Rect){scenario.collision.x + 981, scenario.collision.y + 890, 64, 70}; // Bloco do rodapé (lago).
-            boxes[8] = (SDL_Rect){scenario.collision.x + 627, scenario.collision.y + 207, 25, 10}; // Bloco do Mr. Python.
-            boxes[9] = (SDL_Rect){scenario.collision.x + 758, scenario.collision.y + 616, 64, 10}; // Bloco da Python Van.
-            boxes[10] = (SDL_Rect){scenario.collision.x + 596, scenario.collision.y + 377, 11, 7}; // Toco esquerdo da ponte.
-            boxes[11] = (SDL_Rect){scenario.collision.x + 673, scenario.collision.y + 377, 11, 7}; // Toco direito da ponte.
-            boxes[12] = (SDL_Rect){scenario.collision.x + 545, scenario.collision.y + 593, 37, 15}; // ChatGPT.
-
-            if (meneghetti.player_state == PLAYER_MOVABLE) {
-                sprite_update(&scenario, &meneghetti, anim_pack, dt, boxes, surfaces, walking_sounds);
+        if (keys[SDL_SCANCODE_E] && meneghetti->input_timer >= INPUT_DELAY) {
+            meneghetti->input_timer = 0.0;
+            game->last_game_state = CUTSCENE_SCREEN;
+            game->game_state = TITLE_SCREEN;
+            Mix_HaltChannel(MUSIC_CHANNEL);
+            SDL_SetTextureAlphaMod(current_frame->image, 255);
+            first_cutscene->current_frame = 0;
+            for (int i = 0; i < first_cutscene->frame_amount; i++) {
+                first_cutscene->frames[i]->elapsed_time = 0.0;
             }
-            if (keys[SDL_SCANCODE_E] && meneghetti.input_timer >= INPUT_DELAY) {
-                if (rects_intersect(&meneghetti.interact_collision, &boxes[8], NULL))
-                    meneghetti.player_state = PLAYER_ON_DIALOGUE;
+        }
 
-                if (rects_intersect(&meneghetti.interact_collision, &boxes[9], NULL))
-                    meneghetti.player_state = PLAYER_ON_DIALOGUE;
-                
-                if (rects_intersect(&meneghetti.interact_collision, &boxes[12], NULL)) {
-                    meneghetti.player_state = PLAYER_ON_DIALOGUE;
+        if (current_frame->extend_frame && current_frame->elapsed_time >= current_frame->duration + 3.0) {
+            meneghetti->input_timer = 0.0;
+            game->last_game_state = CUTSCENE_SCREEN;
+            game->game_state = TITLE_SCREEN;
+            SDL_SetTextureAlphaMod(current_frame->image, 255);
+            first_cutscene->current_frame = 0;
+            for (int i = 0; i < first_cutscene->frame_amount; i++) {
+                first_cutscene->frames[i]->elapsed_time = 0.0;
+            }
+        }
+    }
+}
 
-                    if (meneghetti.player_state == PLAYER_MOVABLE && chatgpt_npc.times_interacted < chatgpt_npc.dialogue_amount) {
-                        chatgpt_npc.times_interacted++;
-                    }
-                }
+void title_scene_frame(void *data, double dt, const Uint8 *keys) {
+    TitleScene *scene = data;
+    Game *game = scene->game;
+    Animation *title_text_anim = &scene->title_text_anim;
+    Player *meneghetti = scene->meneghetti;
+    Prop *title = scene->title;
+    Prop *title_text = &scene->title_text;
+    Sound *title_sound = &scene->title_sound;
 
-                if (rects_intersect(&meneghetti.interact_collision, &boxes[7], NULL))
-                    meneghetti.player_state = PLAYER_ON_DIALOGUE;
+    meneghetti->input_timer += dt;
 
-                meneghetti.input_timer = 0.0;
-            }
+    SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(game->renderer);
+    SDL_RenderCopy(game->renderer, title->texture, NULL, &title->collision);
 
-            update_reflection(&meneghetti, &meneghetti_reflection, anim_pack_reflex);
-
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer); 
-
-            SDL_RenderCopy(game.renderer, sky.texture, NULL, &sky.collision);
-            SDL_RenderCopy(game.renderer, sun.texture, NULL, &sun.collision);
-            SDL_RenderCopy(game.renderer, clouds.texture, NULL, &clouds.collision);
-            SDL_RenderCopy(game.renderer, clouds.texture, NULL, &clouds_clone);
-            SDL_RenderCopy(game.renderer, mountains_back.texture, NULL, &mountains_back.collision);
-            SDL_RenderCopy(game.renderer, mountains.texture, NULL, &mountains.collision);
-            SDL_RenderCopy(game.renderer, ocean.texture, NULL, &ocean.collision);
-            SDL_RenderCopy(game.renderer, lake.texture, NULL, &lake.collision);
-            SDL_RenderCopyEx(game.renderer, meneghetti_reflection.texture, NULL, &meneghetti_reflection.collision, 0, NULL, SDL_FLIP_VERTICAL);
-            SDL_RenderCopy(game.renderer, scenario.texture, NULL, &scenario.collision);
-
-            mr_python_npc.texture = animate_sprite(&mr_python_animation[mr_python_npc.facing], dt, 3.0, true);
-            chatgpt_npc.texture = animate_sprite(&chatgpt_animation, dt, 0.5, false);
-            lake.texture = animate_sprite(&lake_animation, dt, 0.5, false);
-            ocean.texture = animate_sprite(&ocean_animation, dt, 0.7, false);
-            sky.texture = animate_sprite(&sky_animation, dt, 0.8, false);
-            sun.texture = animate_sprite(&sun_animation, dt, 0.5, false);
-
-            RenderItem items[5];
-            int item_count = 0;
-
-            items[item_count].texture = mr_python_npc.texture;
-            items[item_count].collisions = &mr_python_npc.collision;
-            item_count ++;
-
-            items[item_count].texture = chatgpt_npc.texture;
-            items[item_count].collisions = &chatgpt_npc.collision;
-            item_count ++;
-
-            items[item_count].texture = python_van.texture;
-            items[item_count].collisions = &python_van.collision;
-            item_count ++;
-            
-            if (!game.player_on_scene) {
-                items[item_count].texture = civic.texture;
-                items[item_count].collisions = &civic.collision;
-                item_count ++;
-
-                items[item_count].texture = meneghetti.texture;
-                items[item_count].collisions = &meneghetti.collision;
-                item_count++;
-            }
+    if (!title_sound->has_played) {
+        Mix_PlayChannel(SFX_CHANNEL, title_sound->sound, 0);
+        title_sound->has_played = true;
+    }
+    if (Mix_Playing(SFX_CHANNEL)) {
+        // O texto só aparece quando o som termina; consulta o mixer de tempos em tempos.
+        schedule_frame_wake(0.05);
+    }
+    else {
+        title_text->texture = animate_sprite(title_text_anim, dt, 0.7, false);
+        SDL_RenderCopy(game->renderer, title_text->texture, NULL, &title_text->collision);
+
+        if (keys[SDL_SCANCODE_RETURN] && meneghetti->input_timer >= INPUT_DELAY) {
+            title_sound->has_played = false;
+            meneghetti->input_timer = 0.0;
+            game->last_game_state = CUTSCENE_SCREEN;
+            meneghetti->player_state = PLAYER_IDLE;
+            game->game_state = OPEN_WORLD_SCREEN;
+        }
+    }
+}
 
-            qsort(items, item_count, sizeof(RenderItem), renderitem_cmp);
+void title_scene_enter(void *data) {
+    TitleScene *scene = data;
+    SDL_Renderer *render = scene->game->renderer;
 
-            for (int i = 0; i < item_count; i++) {
-                if (items[i].texture && items[i].collisions) {
-                    SDL_RenderCopy(game.renderer, items[i].texture, NULL, items[i].collisions);
-                }
-            }
+    // Segundo quadro vazio: o texto pisca.
+    scene->title_text_frames[0] = create_text(render, "APERTE ENTER PARA COMEÇAR", scene->title_text_font, scene->gray);
+    scene->title_text_frames[1] = NULL;
+    scene->title_text_anim = (Animation){.frames = scene->title_text_frames, .count = 2};
 
-            if (meneghetti.player_state == PLAYER_IDLE) {
-                if (game.last_game_state == TITLE_SCREEN) {
-                    create_dialogue(&meneghetti, game.renderer, &arrival_dialogue, NULL, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
-                }
-            }
+    int title_text_width = 0, title_text_height = 0;
+    SDL_QueryTexture(scene->title_text_frames[0], NULL, NULL, &title_text_width, &title_text_height);
+    scene->title_text = (Prop){
+        .texture = scene->title_text_frames[0],
+        .collision = {(SCREEN_WIDTH / 2) - (title_text_width / 2), SCREEN_HEIGHT - 100, title_text_width, title_text_height}
+    };
 
-            if (meneghetti.player_state == PLAYER_ON_DIALOGUE) {
-                if (rects_intersect (&meneghetti.interact_collision, &boxes[8], NULL)) {
-                    switch (meneghetti.death_count) {
-                        case 0:
-                            create_dialogue(&meneghetti, game.renderer, &py_dialogue, NULL, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
-                            break;
-                        case 1:
-                            create_dialogue(&meneghetti, game.renderer, &py_dialogue_ad, NULL, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
-                            break;
-                        case 2:
-                            create_dialogue(&meneghetti, game.renderer, &py_dialogue_ad_2, NULL, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
-                            break;
-                        case 3:
-                            create_dialogue(&meneghetti, game.renderer, &py_dialogue_ad_3, NULL, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
-                            break;
-                        default:
-                            create_dialogue(&meneghetti, game.renderer, &py_dialogue_ad_4, NULL, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
-                            break;
-                    }
-                    switch (meneghetti.facing) {
-                        case DIRECTION_UP:
-                            mr_python_npc.facing = DIRECTION_DOWN;
-                            break;
-                        case DIRECTION_DOWN:
-                            mr_python_npc.facing = DIRECTION_UP;
-                            break;
-                        case DIRECTION_LEFT:
-                            mr_python_npc.facing = DIRECTION_RIGHT;
-                            break;
-                        case DIRECTION_RIGHT:
-                            mr_python_npc.facing = DIRECTION_LEFT;
-                            break;
-                        default:
-                            break;
-                    }
+    scene->title_sound = (Sound){.sound = create_chunk("assets/sounds/sound_effects/in-game/logo_sound.wav", SFX_VOLUME), .has_played = false};
+}
 
-                    mr_python_npc.was_interacted = true;
-                }
+void title_scene_exit(void *data) {
+    TitleScene *scene = data;
 
-                if (rects_intersect(&meneghetti.interact_collision, &boxes[12], NULL))
-                    create_dialogue(&meneghetti, game.renderer, chatgpt_npc.dialogues[chatgpt_npc.times_interacted], &chatgpt_npc, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
+    release_texture(scene->title_text_frames[0]);
+    scene->title_text_frames[0] = scene->title_text.texture = NULL;
+    release_chunk(scene->title_sound.sound);
+    scene->title_sound.sound = NULL;
+}
 
-                if (rects_intersect (&meneghetti.interact_collision, &boxes[9], NULL))
-                    create_dialogue(&meneghetti, game.renderer, &van_dialogue, NULL, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
-                    
-                if (rects_intersect (&meneghetti.interact_collision, &boxes[7], NULL))
-                    create_dialogue(&meneghetti, game.renderer, &lake_dialogue, NULL, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
-            }
-            else if (mr_python_npc.was_interacted) {
-                Mix_HaltChannel(MUSIC_CHANNEL);
-                game_timers.global_timer = 0.0;
-                meneghetti.input_timer = 0.0;
-                meneghetti.player_state = PLAYER_ON_BATTLE;
-                game.game_state = BATTLE_SCREEN;
-                game.last_game_state = OPEN_WORLD_SCREEN;
+void open_world_scene_frame(void *data, double dt, const Uint8 *keys) {
+    OpenWorldScene *scene = data;
+    Game *game = scene->game;
+    FadeState *open_world_fade = scene->open_world_fade;
+    Animation *anim_pack = scene->anim_pack;
+    Animation *anim_pack_reflex = scene->anim_pack_reflex;
+    Animation *mr_python_animation = scene->mr_python_animation;
+    Animation *chatgpt_animation = scene->chatgpt_animation;
+    Animation *dialogue_faces = scene->dialogue_faces;
+    Player *meneghetti = scene->meneghetti;
+    Player *meneghetti_reflection = scene->meneghetti_reflection;
+    WaterReflection *lake_reflection = scene->lake_reflection;
+    Soul *soul = scene->soul;
+    Prop *scenario = scene->scenario;
+    Tilemap *world_map = scene->world_map;
+    Prop *meneghetti_civic = scene->meneghetti_civic;
+    Prop *python_van = scene->python_van;
+    Prop *civic = scene->civic;
+    Prop *palm_left = scene->palm_left;
+    Prop *palm_right = scene->palm_right;
+    LayerStack *open_world_layers = scene->open_world_layers;
+    int civic_dust = scene->civic_dust;
+    int civic_brake_dust = scene->civic_brake_dust;
+    CpuCompositor *compositor = scene->compositor;
+    BackgroundCache *background_cache = scene->background_cache;
+    Sound *ambience = scene->ambience;
+    Sound *walking_sounds = scene->walking_sounds;
+    Sound *dialogue_voices = scene->dialogue_voices;
+    Sound *civic_engine = scene->civic_engine;
+    Sound *civic_brake = scene->civic_brake;
+    Sound *civic_door = scene->civic_door;
+    Dialogue *van_dialogue = scene->van_dialogue;
+    Dialogue *lake_dialogue = scene->lake_dialogue;
+    Dialogue *arrival_dialogue = scene->arrival_dialogue;
+    Dialogue *fight_start_txt = scene->fight_start_txt;
+    Typewriter *dialogue_typewriter = scene->dialogue_typewriter;
+    Dialogue **py_dialogues = scene->py_dialogues;
+    NPC *mr_python_npc = scene->mr_python_npc;
+    NPC *chatgpt_npc = scene->chatgpt_npc;
+    GameTimers *game_timers = scene->game_timers;
+    DepthList *world_sprites = scene->world_sprites;
+    DepthEntry *civic_entry = scene->civic_entry;
+    DepthEntry *meneghetti_entry = scene->meneghetti_entry;
+    SimClock *sim_clock = scene->sim_clock;
+    Motion *civic_motion = scene->civic_motion;
+    Motion *camera_motion = scene->camera_motion;
+    Motion *player_motion = scene->player_motion;
+
+    game_timers->global_timer += dt;
+    meneghetti->input_timer += dt;
+
+    if (open_world_fade->fading_in) {
+        mark_frame_dirty();
+        open_world_fade->timer += dt;
+        open_world_fade->alpha = 255 - (Uint8)((open_world_fade->timer / 5.0) * 255);
+
+        if (open_world_fade->timer >= 5.0) {
+            open_world_fade->alpha = 0;
+            open_world_fade->fading_in = false;
+        }
+    }
+    if (!ambience->has_played) {
+        Mix_PlayChannel(MUSIC_CHANNEL, ambience->sound, -1);
+        ambience->has_played = true;
+    }
+
+    // PROPS:
+    soul->collision = (SDL_Rect){meneghetti->collision.x, meneghetti->collision.y + 8, 20, 20};
+    // COLISÕES DE ENTIDADES (O TERRENO FICA NAS MÁSCARAS DO MAPA DE TILES):
+    SDL_Rect boxes[COLLISION_QUANTITY];
+    boxes[0] = (SDL_Rect){scenario->collision.x + 627, scenario->collision.y + 207, 25, 10}; // Bloco do Mr. Python.
+    boxes[1] = (SDL_Rect){scenario->collision.x + 758, scenario->collision.y + 616, 64, 10}; // Bloco da Python Van.
+    boxes[2] = (SDL_Rect){scenario->collision.x + 545, scenario->collision.y + 593, 37, 15}; // ChatGPT.
+
+    // ÁREA DE INTERAÇÃO DO LAGO (SÓLIDA NO MAPA):
+    SDL_Rect lake_shore = {scenario->collision.x + 981, scenario->collision.y + 890, 64, 70};
+
+    // Câmera e jogador registram todo passo, andando ou não, para a interpolação assentar quando o jogador para.
+    for (int step = 0; step < sim_clock->steps; step++) {
+        motion_begin_step(camera_motion, &scenario->collision);
+        motion_begin_step(player_motion, &meneghetti->collision);
+        if (meneghetti->player_state == PLAYER_MOVABLE) {
+            sprite_update(scenario, meneghetti, anim_pack, 1.0 / SIM_RATE, world_map, boxes, walking_sounds);
+        }
+        motion_end_step(camera_motion, &scenario->collision);
+        motion_end_step(player_motion, &meneghetti->collision);
+    }
+    if (keys[SDL_SCANCODE_E] && meneghetti->input_timer >= INPUT_DELAY) {
+        if (rects_intersect(&meneghetti->interact_collision, &boxes[0], NULL))
+            meneghetti->player_state = PLAYER_ON_DIALOGUE;
+
+        if (rects_intersect(&meneghetti->interact_collision, &boxes[1], NULL))
+            meneghetti->player_state = PLAYER_ON_DIALOGUE;
+        
+        if (rects_intersect(&meneghetti->interact_collision, &boxes[2], NULL)) {
+            meneghetti->player_state = PLAYER_ON_DIALOGUE;
+
+            if (meneghetti->player_state == PLAYER_MOVABLE && chatgpt_npc->times_interacted < chatgpt_npc->dialogue_amount) {
+                chatgpt_npc->times_interacted++;
             }
+        }
 
-            if (game.player_on_scene) {
-                palm_left.collision = (SDL_Rect){scenario.collision.x + 455, scenario.collision.y + 763, 73, 42};
-                palm_right.collision = (SDL_Rect){scenario.collision.x + 531, scenario.collision.y + 750, 73, 42};
+        if (rects_intersect(&meneghetti->interact_collision, &lake_shore, NULL))
+            meneghetti->player_state = PLAYER_ON_DIALOGUE;
 
-                SDL_RenderCopy(game.renderer, meneghetti_civic.texture, NULL, &meneghetti_civic.collision);
-                if (meneghetti_civic.collision.x > scenario.collision.x + 250) {
-                    if (!Mix_Playing(SFX_CHANNEL))
-                        Mix_PlayChannel(SFX_CHANNEL, civic_engine.sound, 0);
-                    
-                    meneghetti_civic.collision.x -= 5;
-                    meneghetti_civic.collision.y = (int)((scenario.collision.y + 731) + 2 * sin(game_timers.senoidal_timer * 30.0)); 
-                }
-                else {
-                    if (!civic_brake.has_played) {
-                        Mix_PlayChannel(SFX_CHANNEL, civic_brake.sound, 0);
-                        civic_brake.has_played = true;
-                    }
-                }
-                if (game_timers.global_timer >= 5.0) {
-                    if (!Mix_Playing(SFX_CHANNEL)) {
-                            Mix_PlayChannel(SFX_CHANNEL, civic_door.sound, 0);
-                            game.last_game_state = TITLE_SCREEN;
-                            game.player_on_scene = false;
-                            meneghetti.player_state = PLAYER_IDLE;
-                    }
-                }
-                SDL_RenderCopy(game.renderer, palm_left.texture, NULL, &palm_left.collision);
-                SDL_RenderCopy(game.renderer, palm_right.texture, NULL, &palm_right.collision);
-            }
-            if (open_world_fade.alpha > 0) {
-                SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, open_world_fade.alpha);
-                SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
+        meneghetti->input_timer = 0.0;
+    }
 
-                SDL_Rect screen_fade = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-                SDL_RenderFillRect(game.renderer, &screen_fade);
+    // VISTA: o mundo é desenhado entre os dois últimos passos. A câmera e o jogador só ficam deslocados até o fim
+    // do quadro; o mundo é pixel art, então o deslocamento é arredondado para pixels inteiros.
+    SDL_FRect camera_view = motion_rect(camera_motion, &scenario->collision, sim_clock->alpha);
+    SDL_FRect player_view = motion_rect(player_motion, &meneghetti->collision, sim_clock->alpha);
+    SDL_Point camera_shift = {(int)roundf(camera_view.x) - scenario->collision.x, (int)roundf(camera_view.y) - scenario->collision.y};
+    SDL_Point player_shift = {(int)roundf(player_view.x) - meneghetti->collision.x, (int)roundf(player_view.y) - meneghetti->collision.y};
+    scenario->collision.x += camera_shift.x;
+    scenario->collision.y += camera_shift.y;
+    meneghetti->collision.x += player_shift.x;
+    meneghetti->collision.y += player_shift.y;
+
+    mr_python_npc->collision = (SDL_Rect){scenario->collision.x + 620, scenario->collision.y + 153, 39, 64};
+    chatgpt_npc->collision = (SDL_Rect){scenario->collision.x + 545, scenario->collision.y + 544, 37, 64};
+    python_van->collision = (SDL_Rect){scenario->collision.x + 758, scenario->collision.y + 592, 64, 33};
+    if (!game->player_on_scene) civic->collision = (SDL_Rect){scenario->collision.x + 250, scenario->collision.y + 749, 65, 25};
+
+    update_reflection(meneghetti, meneghetti_reflection, anim_pack_reflex);
+    update_water_reflection(lake_reflection, &meneghetti_reflection->collision, dt);
+
+    SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(game->renderer); 
+
+    // CAMADAS DE FUNDO (PROFUNDIDADE = ORDEM DE PINTURA):
+    update_layer_stack(open_world_layers, dt);
+    // O mapa fica por cima de todas as camadas: o que ele cobre com tiles opacos nem é desenhado.
+    OcclusionGrid occlusion;
+    occlusion_reset(&occlusion);
+    tilemap_occlude(world_map, &occlusion, scenario->collision.x, scenario->collision.y);
+    int back_depth = queue_layer_stack(game->renderer, open_world_layers, background_cache, compositor, &occlusion, scenario->collision.x, scenario->collision.y, LAYER_BACKGROUND);
+    queue_water_reflection(game->renderer, lake_reflection, meneghetti_reflection->texture, &meneghetti_reflection->collision, LAYER_BACKGROUND, back_depth);
+    tilemap_queue(world_map, scenario->collision.x, scenario->collision.y, LAYER_BACKGROUND, back_depth + 1);
+
+    mr_python_npc->texture = animate_sprite(&mr_python_animation[mr_python_npc->facing], dt, 3.0, true);
+    chatgpt_npc->texture = animate_sprite(chatgpt_animation, dt, 0.5, false);
+
+    // SPRITES DO MUNDO: a lista já está quase em ordem, então a reordenação custa uma passada.
+    civic_entry->visible = !game->player_on_scene;
+    meneghetti_entry->visible = !game->player_on_scene;
+    depth_list_update(world_sprites);
+    depth_list_queue(world_sprites, LAYER_WORLD);
+
+    if (game->player_on_scene) {
+        palm_left->collision = (SDL_Rect){scenario->collision.x + 455, scenario->collision.y + 763, 73, 42};
+        palm_right->collision = (SDL_Rect){scenario->collision.x + 531, scenario->collision.y + 750, 73, 42};
+
+        for (int step = 0; step < sim_clock->steps; step++) {
+            motion_begin_step(civic_motion, &meneghetti_civic->collision);
+            if (meneghetti_civic->collision.x > scenario->collision.x + 250) {
+                meneghetti_civic->collision.x -= 5;
+                meneghetti_civic->collision.y = (int)((scenario->collision.y + 731) + 2 * sin(game_timers->senoidal_timer * 30.0));
             }
+            motion_end_step(civic_motion, &meneghetti_civic->collision);
         }
+        SDL_FRect civic_rect = motion_rect(civic_motion, &meneghetti_civic->collision, sim_clock->alpha);
+        queue_copy_f(meneghetti_civic->texture, NULL, &civic_rect, LAYER_FOREGROUND, 0);
 
-        if (game.game_state == BATTLE_SCREEN) {
-            game_timers.battle_timer += dt;
-
-            if (meneghetti.health > 20) meneghetti.health = 20;
-            if (meneghetti.health <= 0) {
-                meneghetti.health = 20;
-                meneghetti.player_state = PLAYER_DEAD;
+        if (meneghetti_civic->collision.x > scenario->collision.x + 250) {
+            if (!Mix_Playing(SFX_CHANNEL))
+                Mix_PlayChannel(SFX_CHANNEL, civic_engine->sound, 0);
+            stream_particles(&particle_system, civic_dust, meneghetti_civic->collision.x + meneghetti_civic->collision.w - 6, meneghetti_civic->collision.y + meneghetti_civic->collision.h - 4, dt);
+        }
+        else {
+            if (!civic_brake->has_played) {
+                Mix_PlayChannel(SFX_CHANNEL, civic_brake->sound, 0);
+                civic_brake->has_played = true;
+                emit_particles(&particle_system, civic_brake_dust, meneghetti_civic->collision.x + 8, meneghetti_civic->collision.y + meneghetti_civic->collision.h - 4, 0);
             }
-
-            if (meneghetti.inventory_counter > 0) {
-                for (int i = 0; i < meneghetti.inventory_counter; i++) {
-                    if (meneghetti.inventory[i]) {
-                        char x_number[3];
-                        snprintf(x_number, sizeof(x_number), "%dx", meneghetti.inventory[i]->amount);
-                        meneghetti.inventory[i]->item_amount_text->texture = create_text(game.renderer, x_number, battle_text_font, white);
-                    }
-                }
+        }
+        if (game_timers->global_timer >= 5.0) {
+            if (!Mix_Playing(SFX_CHANNEL)) {
+                    Mix_PlayChannel(SFX_CHANNEL, civic_door->sound, 0);
+                    game->last_game_state = TITLE_SCREEN;
+                    game->player_on_scene = false;
+                    meneghetti->player_state = PLAYER_IDLE;
             }
+        }
+        queue_copy(palm_left->texture, NULL, &palm_left->collision, LAYER_FOREGROUND, 1);
+        queue_copy(palm_right->texture, NULL, &palm_right->collision, LAYER_FOREGROUND, 1);
+    }
+    // O mundo é desenhado de uma vez; a interface de diálogo vem por cima.
+    flush_render_queue(game->renderer);
 
-            SDL_Rect box_borders[] = {
-                {battle_box.animated_box.x, battle_box.animated_box.y, battle_box.animated_box.w, 5},
-                {battle_box.animated_box.x, battle_box.animated_box.y, 5, battle_box.animated_box.h},
-                {battle_box.animated_box.x, battle_box.animated_box.y + battle_box.animated_box.h - 5, battle_box.animated_box.w, 5},
-                {battle_box.animated_box.x + battle_box.animated_box.w - 5, battle_box.animated_box.y, 5, battle_box.animated_box.h}
-            };
+    if (meneghetti->player_state == PLAYER_IDLE) {
+        if (game->last_game_state == TITLE_SCREEN) {
+            create_dialogue(meneghetti, game->renderer, dialogue_typewriter, arrival_dialogue, NULL, &meneghetti->player_state, &game->game_state, dt, dialogue_faces, dialogue_voices, false);
+        }
+    }
 
-            SDL_Rect life_bar_background = {(SCREEN_WIDTH / 2) - 72, button_fight.collision.y - 30, 60, 20};
-            SDL_Rect life_bar = {(SCREEN_WIDTH / 2) - 72, button_fight.collision.y - 30, meneghetti.health * 3, 20};
-            SDL_Rect py_life_background = {(SCREEN_WIDTH / 2) - 100, 200, 200, 10};
-            SDL_Rect py_life = {(SCREEN_WIDTH / 2) - 100, 200, 200, 10};
+    // Pré-carrega a primeira linha das conversas dos NPCs enquanto o jogador anda.
+    if (meneghetti->player_state == PLAYER_MOVABLE) {
+        prefetch_dialogue(game->renderer, py_dialogues[SDL_min(meneghetti->death_count, 4)]);
+        prefetch_dialogue(game->renderer, chatgpt_npc->dialogues[chatgpt_npc->times_interacted]);
+    }
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer);
+    if (meneghetti->player_state == PLAYER_ON_DIALOGUE) {
+        if (rects_intersect (&meneghetti->interact_collision, &boxes[0], NULL)) {
+            create_dialogue(meneghetti, game->renderer, dialogue_typewriter, py_dialogues[SDL_min(meneghetti->death_count, 4)], NULL, &meneghetti->player_state, &game->game_state, dt, dialogue_faces, dialogue_voices, false);
+            prefetch_dialogue(game->renderer, fight_start_txt);
+            switch (meneghetti->facing) {
+                case DIRECTION_UP:
+                    mr_python_npc->facing = DIRECTION_DOWN;
+                    break;
+                case DIRECTION_DOWN:
+                    mr_python_npc->facing = DIRECTION_UP;
+                    break;
+                case DIRECTION_LEFT:
+                    mr_python_npc->facing = DIRECTION_RIGHT;
+                    break;
+                case DIRECTION_RIGHT:
+                    mr_python_npc->facing = DIRECTION_LEFT;
+                    break;
+                default:
+                    break;
+            }
 
-            if (battle_flags.turn_counter == 0) {
+            mr_python_npc->was_interacted = true;
+        }
 
-                SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                if (game_timers.battle_timer <= 0.5) {
-                    if (!battle_appears.has_played) {
-                        Mix_PlayChannel(SFX_CHANNEL, battle_appears.sound, 0);
-                        battle_appears.has_played = true;
-                    }
-                    soul.texture = animate_sprite(&soul_animation, dt, 0.1, false);
-                }
-                else {
-                    soul.texture = soul_animation.frames[0];
-                    if (soul.collision.x != button_fight.collision.x + 30 || soul.collision.y != button_fight.collision.y + 30) {
-                        if (abs(soul.collision.x - (button_fight.collision.x + 30)) <= 5)
-                            soul.collision.x = button_fight.collision.x + 30;
-                        else if (soul.collision.x < button_fight.collision.x + 30)
-                            soul.collision.x += 5;
-                        else if (soul.collision.x > button_fight.collision.x + 30)
-                            soul.collision.x -= 5;
-                        
-                        if (abs(soul.collision.y - (button_fight.collision.y + 30)) <= 5)
-                            soul.collision.y = button_fight.collision.y + 30;
-                        else if (soul.collision.y > button_fight.collision.y + 30)
-                            soul.collision.y -= 5;
-                        else if (soul.collision.y < button_fight.collision.y + 30)
-                            soul.collision.y += 5;
-                    }
-                    else {
-                        soul.texture = soul_animation.frames[0];
-                        battle_flags.turn_counter++;
-                        battle_appears.has_played = false;
-                    }
-                }
-            }
-            else {
-                meneghetti.input_timer += dt;
+        if (rects_intersect(&meneghetti->interact_collision, &boxes[2], NULL))
+            create_dialogue(meneghetti, game->renderer, dialogue_typewriter, chatgpt_npc->dialogues[chatgpt_npc->times_interacted], chatgpt_npc, &meneghetti->player_state, &game->game_state, dt, dialogue_faces, dialogue_voices, false);
 
-                if (!battle_music.has_played) {
-                    Mix_PlayChannel(MUSIC_CHANNEL, battle_music.sound, 0);
-                    battle_music.has_played = true;
-                }
+        if (rects_intersect (&meneghetti->interact_collision, &boxes[1], NULL))
+            create_dialogue(meneghetti, game->renderer, dialogue_typewriter, van_dialogue, NULL, &meneghetti->player_state, &game->game_state, dt, dialogue_faces, dialogue_voices, false);
+            
+        if (rects_intersect (&meneghetti->interact_collision, &lake_shore, NULL))
+            create_dialogue(meneghetti, game->renderer, dialogue_typewriter, lake_dialogue, NULL, &meneghetti->player_state, &game->game_state, dt, dialogue_faces, dialogue_voices, false);
+    }
+    else if (mr_python_npc->was_interacted) {
+        Mix_HaltChannel(MUSIC_CHANNEL);
+        game_timers->global_timer = 0.0;
+        meneghetti->input_timer = 0.0;
+        meneghetti->player_state = PLAYER_ON_BATTLE;
+        game->game_state = BATTLE_SCREEN;
+        game->last_game_state = OPEN_WORLD_SCREEN;
+    }
 
-                if (meneghetti.health != meneghetti.last_health) {
-                    char hp_string[6];
-                    snprintf(hp_string, sizeof(hp_string), "%02d/20", meneghetti.health);
+    if (open_world_fade->alpha > 0) {
+        SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, open_world_fade->alpha);
+        SDL_SetRenderDrawBlendMode(game->renderer, SDL_BLENDMODE_BLEND);
 
-                    battle_hp_amount.texture = create_text(game.renderer, hp_string, battle_text_font, white);
-                    meneghetti.last_health = meneghetti.health;
-                }
+        SDL_Rect screen_fade = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+        SDL_RenderFillRect(game->renderer, &screen_fade);
+    }
 
-                SDL_SetRenderDrawColor(game.renderer, 255, 255, 255, 255);
-                SDL_RenderFillRects(game.renderer, box_borders, 4);
-                SDL_SetRenderDrawColor(game.renderer, 168, 24, 13, 255);
-                SDL_RenderFillRect(game.renderer, &life_bar_background);
-                SDL_SetRenderDrawColor(game.renderer, 204, 195, 18, 255);
-                SDL_RenderFillRect(game.renderer, &life_bar);
-
-                SDL_RenderCopy(game.renderer, button_fight.texture, NULL, &button_fight.collision);
-                SDL_RenderCopy(game.renderer, button_act.texture, NULL, &button_act.collision);
-                SDL_RenderCopy(game.renderer, button_item.texture, NULL, &button_item.collision);
-                SDL_RenderCopy(game.renderer, button_leave.texture, NULL, &button_leave.collision);
-                SDL_RenderCopy(game.renderer, battle_name.texture, NULL, &battle_name.collision);
-                SDL_RenderCopy(game.renderer, battle_hp.texture, NULL, &battle_hp.collision);
-                SDL_RenderCopy(game.renderer, battle_hp_amount.texture, NULL, &battle_hp_amount.collision);
-
-                // MR. PYTHON
-                for (int i = 0; i < ENEMY_PARTS; i++) {
-                    SDL_RenderCopy(game.renderer, mr_python.textures[mr_python.animation_status][i], NULL, &mr_python.collision[i]);
-                }
-                mr_python.collision[ENEMY_HEAD].y = (int)(25 + 1 * sin(game_timers.senoidal_timer * 1.5));
-                mr_python.collision[ENEMY_TORSO].y = (int)(25 + 2 * sin(game_timers.senoidal_timer * 1.5));
-                mr_python.collision[ENEMY_ARMS].y = (int)(25 + 3 * sin(game_timers.senoidal_timer * 1.5));
+    scenario->collision.x -= camera_shift.x;
+    scenario->collision.y -= camera_shift.y;
+    meneghetti->collision.x -= player_shift.x;
+    meneghetti->collision.y -= player_shift.y;
+}
 
-                if (battle_flags.battle_state == BATTLE_MENU) {
-                    if (battle_flags.turn_counter == 1) {
-                        create_dialogue(&meneghetti, game.renderer, &fight_start_txt, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
-                    }
-                    else {
-                        create_dialogue(&meneghetti, game.renderer, &fight_generic_txt, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
-                        if (meneghetti.player_state == PLAYER_IDLE) meneghetti.player_state = PLAYER_ON_BATTLE;
-                    }
+void battle_scene_frame(void *data, double dt, const Uint8 *keys) {
+    BattleScene *scene = data;
+    Game *game = scene->game;
+    FadeState *end_scene_fade = scene->end_scene_fade;
+    SDL_Color white = scene->white;
+    TTF_Font *battle_text_font = scene->battle_text_font;
+    Animation *soul_animation = scene->soul_animation;
+    Animation *bar_attack_animation = scene->bar_attack_animation;
+    Animation *slash_animation = scene->slash_animation;
+    Animation *python_mother_animation = &scene->python_mother_animation;
+    Player *meneghetti = scene->meneghetti;
+    Enemy *mr_python = scene->mr_python;
+    Soul *soul = scene->soul;
+    Prop *slash = scene->slash;
+    int hit_sparks = scene->hit_sparks;
+    Prop *bubble_speech = scene->bubble_speech;
+    SDL_Texture **fight_b_textures = scene->fight_b_textures;
+    Prop *button_fight = scene->button_fight;
+    SDL_Texture **act_b_textures = scene->act_b_textures;
+    Prop *button_act = scene->button_act;
+    SDL_Texture **item_b_textures = scene->item_b_textures;
+    Prop *button_item = scene->button_item;
+    SDL_Texture **leave_b_textures = scene->leave_b_textures;
+    Prop *button_leave = scene->button_leave;
+    Prop *battle_name = scene->battle_name;
+    Prop *battle_hp = scene->battle_hp;
+    NumberFont *hp_number_font = scene->hp_number_font;
+    char (*hp_string)[6] = scene->hp_string;
+    Prop *battle_hp_amount = scene->battle_hp_amount;
+    Prop *food_amount_text = scene->food_amount_text;
+    Prop *text_attack_act = scene->text_attack_act;
+    Prop *text_item = scene->text_item;
+    Prop *text_act = scene->text_act;
+    Prop *text_leave = scene->text_leave;
+    Prop *bar_target = scene->bar_target;
+    Prop *bar_attack = scene->bar_attack;
+    Projectile **python_props = scene->python_props;
+    NumberFont *damage_number_font = scene->damage_number_font;
+    Prop *damage = &scene->damage;
+    char (*damage_string)[12] = scene->damage_string;
+    BattleHudCache *battle_hud = scene->battle_hud;
+    Sound *battle_music = &scene->battle_music;
+    Sound *battle_sounds = scene->battle_sounds;
+    Sound *dialogue_voices = scene->dialogue_voices;
+    Sound *battle_appears = &scene->battle_appears;
+    Sound *move_button = &scene->move_button;
+    Sound *click_button = &scene->click_button;
+    Sound *slash_sound = &scene->slash_sound;
+    Sound *enemy_hit_sound = &scene->enemy_hit_sound;
+    Sound *eat_sound = &scene->eat_sound;
+    Dialogue *fight_start_txt = scene->fight_start_txt;
+    Dialogue *fight_generic_txt = &scene->fight_generic_txt;
+    Dialogue *fight_leave_txt = &scene->fight_leave_txt;
+    Dialogue *fight_spare_txt = &scene->fight_spare_txt;
+    Dialogue *fight_act_txt = &scene->fight_act_txt;
+    Dialogue *insult_txt = &scene->insult_txt;
+    Dialogue *explain_txt = &scene->explain_txt;
+    Dialogue *picanha_txt = &scene->picanha_txt;
+    Dialogue *no_food_txt = &scene->no_food_txt;
+    Dialogue *bubble_speech_1 = &scene->bubble_speech_1;
+    Dialogue *bubble_speech_2 = &scene->bubble_speech_2;
+    Dialogue *bubble_speech_3 = &scene->bubble_speech_3;
+    Typewriter *dialogue_typewriter = scene->dialogue_typewriter;
+    Typewriter *bubble_typewriter = scene->bubble_typewriter;
+    BattleBox *battle_box = scene->battle_box;
+    BattleState *battle_flags = scene->battle_flags;
+    GameTimers *game_timers = scene->game_timers;
+    SimClock *sim_clock = scene->sim_clock;
+    Motion *soul_motion = scene->soul_motion;
+    Motion *bar_motion = scene->bar_motion;
+
+    game_timers->battle_timer += dt;
+
+    if (meneghetti->health > 20) meneghetti->health = 20;
+    if (meneghetti->health <= 0) {
+        meneghetti->health = 20;
+        meneghetti->player_state = PLAYER_DEAD;
+    }
+
+    if (meneghetti->inventory_counter > 0) {
+        for (int i = 0; i < meneghetti->inventory_counter; i++) {
+            // O texto só é refeito quando a quantidade muda, não a cada quadro.
+            Item *item = meneghetti->inventory[i];
+            if (item && (!item->item_amount_text->texture || item->shown_amount != item->amount)) {
+                char x_number[4];
+                snprintf(x_number, sizeof(x_number), "%dx", item->amount);
+                item->item_amount_text->texture = create_text(game->renderer, x_number, battle_text_font, white);
+                item->shown_amount = item->amount;
+            }
+        }
+    }
+
+    SDL_Rect box_borders[] = {
+        {battle_box->animated_box.x, battle_box->animated_box.y, battle_box->animated_box.w, 5},
+        {battle_box->animated_box.x, battle_box->animated_box.y, 5, battle_box->animated_box.h},
+        {battle_box->animated_box.x, battle_box->animated_box.y + battle_box->animated_box.h - 5, battle_box->animated_box.w, 5},
+        {battle_box->animated_box.x + battle_box->animated_box.w - 5, battle_box->animated_box.y, 5, battle_box->animated_box.h}
+    };
+
+    SDL_Rect life_bar_background = {(SCREEN_WIDTH / 2) - 72, button_fight->collision.y - 30, 60, 20};
+    SDL_Rect life_bar = {(SCREEN_WIDTH / 2) - 72, button_fight->collision.y - 30, meneghetti->health * 3, 20};
+    SDL_Rect py_life_background = {(SCREEN_WIDTH / 2) - 100, 200, 200, 10};
+    SDL_Rect py_life = {(SCREEN_WIDTH / 2) - 100, 200, 200, 10};
+
+    SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(game->renderer);
+
+    if (battle_flags->turn_counter == 0) {
+        if (game_timers->battle_timer <= 0.5) {
+            if (!battle_appears->has_played) {
+                Mix_PlayChannel(SFX_CHANNEL, battle_appears->sound, 0);
+                battle_appears->has_played = true;
+            }
+            soul->texture = animate_sprite(soul_animation, dt, 0.1, false);
+        }
+        else {
+            soul->texture = soul_animation->frames[0];
+            for (int step = 0; step < sim_clock->steps && battle_flags->turn_counter == 0; step++) {
+                motion_begin_step(soul_motion, &soul->collision);
+                if (soul->collision.x != button_fight->collision.x + 30 || soul->collision.y != button_fight->collision.y + 30) {
+                    if (abs(soul->collision.x - (button_fight->collision.x + 30)) <= 5)
+                        soul->collision.x = button_fight->collision.x + 30;
+                    else if (soul->collision.x < button_fight->collision.x + 30)
+                        soul->collision.x += 5;
+                    else if (soul->collision.x > button_fight->collision.x + 30)
+                        soul->collision.x -= 5;
                     
-                    if (battle_flags.selected_button > BUTTON_LEAVE) battle_flags.selected_button = BUTTON_FIGHT;
-                    if (battle_flags.selected_button < BUTTON_FIGHT) battle_flags.selected_button = BUTTON_LEAVE;
+                    if (abs(soul->collision.y - (button_fight->collision.y + 30)) <= 5)
+                        soul->collision.y = button_fight->collision.y + 30;
+                    else if (soul->collision.y > button_fight->collision.y + 30)
+                        soul->collision.y -= 5;
+                    else if (soul->collision.y < button_fight->collision.y + 30)
+                        soul->collision.y += 5;
+                }
+                else {
+                    soul->texture = soul_animation->frames[0];
+                    battle_flags->turn_counter++;
+                    battle_appears->has_played = false;
+                }
+                motion_end_step(soul_motion, &soul->collision);
+            }
+        }
 
-                    if (keys[SDL_SCANCODE_D] && meneghetti.input_timer >= INPUT_DELAY) {
-                        Mix_PlayChannel(DEFAULT_CHANNEL, move_button.sound, 0);
-                        battle_flags.selected_button++;
-                        meneghetti.input_timer = 0.0;
-                    }
-                    else if (keys[SDL_SCANCODE_A] && meneghetti.input_timer >= INPUT_DELAY) {
-                        Mix_PlayChannel(DEFAULT_CHANNEL, move_button.sound, 0);
-                        battle_flags.selected_button--;
-                        meneghetti.input_timer = 0.0;
-                    }
+        SDL_FRect soul_rect = motion_rect(soul_motion, &soul->collision, sim_clock->alpha);
+        SDL_RenderCopyF(game->renderer, soul->texture, NULL, &soul_rect);
+    }
+    else {
+        meneghetti->input_timer += dt;
 
-                    switch(battle_flags.selected_button) {
-                        case BUTTON_FIGHT:
-                            button_fight.texture = fight_b_textures[1];
-                            button_act.texture = act_b_textures[0];
-                            button_item.texture = item_b_textures[0];
-                            button_leave.texture = leave_b_textures[0];
-                            break;
-                        case BUTTON_ACT:
-                            button_fight.texture = fight_b_textures[0];
-                            button_act.texture = act_b_textures[1];
-                            button_item.texture = item_b_textures[0];
-                            button_leave.texture = leave_b_textures[0];
-                            break;
-                        case BUTTON_ITEM:
-                            button_fight.texture = fight_b_textures[0];
-                            button_act.texture = act_b_textures[0];
-                            button_item.texture = item_b_textures[1];
-                            button_leave.texture = leave_b_textures[0];
-                            break;
-                        case BUTTON_LEAVE:
-                            button_fight.texture = fight_b_textures[0];
-                            button_act.texture = act_b_textures[0];
-                            button_item.texture = item_b_textures[0];
-                            button_leave.texture = leave_b_textures[1];
-                            break;
-                        default:
-                            break;
-                    }
+        if (!battle_music->has_played) {
+            Mix_PlayChannel(MUSIC_CHANNEL, battle_music->sound, 0);
+            battle_music->has_played = true;
+        }
 
-                    if (keys[SDL_SCANCODE_E] && meneghetti.input_timer >= 0.2) {
-                        switch(battle_flags.selected_button) {
-                            case BUTTON_FIGHT:
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                battle_flags.battle_state = BATTLE_FIGHT;
-                                break;
-                            case BUTTON_ACT:
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                battle_flags.battle_state = BATTLE_ACT;
-                                break;
-                            case BUTTON_ITEM:
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                battle_flags.battle_state = BATTLE_ITEM;
-                                break;
-                            case BUTTON_LEAVE:
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                battle_flags.battle_state = BATTLE_LEAVE;
-                                break;
-                            default:
-                                break;  
-                        }
-                        meneghetti.input_timer = 0.0;
-                    }
+        if (meneghetti->health != meneghetti->last_health) {
+            snprintf(*hp_string, sizeof(*hp_string), "%02d/20", meneghetti->health);
+            battle_hp_amount->collision.w = number_text_width(hp_number_font, *hp_string);
+            meneghetti->last_health = meneghetti->health;
+        }
+
+        // O HUD só é redesenhado quando a caixa, a vida ou o botão selecionado mudam.
+        SDL_Texture *hud_buttons[BATTLE_BUTTONS] = {button_fight->texture, button_act->texture, button_item->texture, button_leave->texture};
+        bool hud_ready = battle_hud_current(battle_hud, &battle_box->animated_box, meneghetti->health, hud_buttons);
+        if (!hud_ready) {
+            SDL_Rect hud_strip = {0, SDL_min(battle_name->collision.y, life_bar_background.y), SCREEN_WIDTH, 0};
+            hud_strip.h = SCREEN_HEIGHT - hud_strip.y;
+            SDL_Rect hud_bounds;
+            SDL_UnionRect(&battle_box->animated_box, &hud_strip, &hud_bounds);
+            bool hud_redraw = begin_battle_hud(game->renderer, battle_hud, &battle_box->animated_box, meneghetti->health, hud_buttons, &hud_bounds);
+
+            for (int i = 0; i < 4; i++) {
+                queue_fill(&box_borders[i], white, SDL_BLENDMODE_NONE, LAYER_HUD, 0);
+            }
+            queue_fill(&life_bar_background, (SDL_Color){168, 24, 13, 255}, SDL_BLENDMODE_NONE, LAYER_HUD, 0);
+            queue_fill(&life_bar, (SDL_Color){204, 195, 18, 255}, SDL_BLENDMODE_NONE, LAYER_HUD, 1);
+
+            queue_copy(button_fight->texture, NULL, &button_fight->collision, LAYER_HUD, 0);
+            queue_copy(button_act->texture, NULL, &button_act->collision, LAYER_HUD, 0);
+            queue_copy(button_item->texture, NULL, &button_item->collision, LAYER_HUD, 0);
+            queue_copy(button_leave->texture, NULL, &button_leave->collision, LAYER_HUD, 0);
+            queue_copy(battle_name->texture, NULL, &battle_name->collision, LAYER_HUD, 0);
+            queue_copy(battle_hp->texture, NULL, &battle_hp->collision, LAYER_HUD, 0);
+
+            if (hud_redraw) {
+                flush_render_queue(game->renderer);
+                render_number(game->renderer, hp_number_font, *hp_string, battle_hp_amount->collision.x, battle_hp_amount->collision.y);
+                end_battle_hud(game->renderer, battle_hud);
+                hud_ready = true;
+            }
+        }
+        if (hud_ready) {
+            queue_copy(battle_hud->target, &battle_hud->bounds, &battle_hud->bounds, LAYER_HUD, 0);
+        }
+
+        // MR. PYTHON
+        queue_enemy(game->renderer, mr_python, LAYER_HUD, 2);
+
+        // HUD e inimigo saem antes dos desenhos imediatos do turno.
+        flush_render_queue(game->renderer);
+        if (!hud_ready) {
+            render_number(game->renderer, hp_number_font, *hp_string, battle_hp_amount->collision.x, battle_hp_amount->collision.y);
+        }
+        enemy_bob(mr_python, 25, game_timers->senoidal_timer * 1.5);
+
+        if (battle_flags->battle_state == BATTLE_MENU) {
+            if (battle_flags->turn_counter == 1) {
+                create_dialogue(meneghetti, game->renderer, dialogue_typewriter, fight_start_txt, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
+            }
+            else {
+                create_dialogue(meneghetti, game->renderer, dialogue_typewriter, fight_generic_txt, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
+                if (meneghetti->player_state == PLAYER_IDLE) meneghetti->player_state = PLAYER_ON_BATTLE;
+            }
+            
+            if (battle_flags->selected_button > BUTTON_LEAVE) battle_flags->selected_button = BUTTON_FIGHT;
+            if (battle_flags->selected_button < BUTTON_FIGHT) battle_flags->selected_button = BUTTON_LEAVE;
+
+            if (keys[SDL_SCANCODE_D] && meneghetti->input_timer >= INPUT_DELAY) {
+                Mix_PlayChannel(DEFAULT_CHANNEL, move_button->sound, 0);
+                battle_flags->selected_button++;
+                meneghetti->input_timer = 0.0;
+            }
+            else if (keys[SDL_SCANCODE_A] && meneghetti->input_timer >= INPUT_DELAY) {
+                Mix_PlayChannel(DEFAULT_CHANNEL, move_button->sound, 0);
+                battle_flags->selected_button--;
+                meneghetti->input_timer = 0.0;
+            }
+
+            switch(battle_flags->selected_button) {
+                case BUTTON_FIGHT:
+                    button_fight->texture = fight_b_textures[1];
+                    button_act->texture = act_b_textures[0];
+                    button_item->texture = item_b_textures[0];
+                    button_leave->texture = leave_b_textures[0];
+                    break;
+                case BUTTON_ACT:
+                    button_fight->texture = fight_b_textures[0];
+                    button_act->texture = act_b_textures[1];
+                    button_item->texture = item_b_textures[0];
+                    button_leave->texture = leave_b_textures[0];
+                    break;
+                case BUTTON_ITEM:
+                    button_fight->texture = fight_b_textures[0];
+                    button_act->texture = act_b_textures[0];
+                    button_item->texture = item_b_textures[1];
+                    button_leave->texture = leave_b_textures[0];
+                    break;
+                case BUTTON_LEAVE:
+                    button_fight->texture = fight_b_textures[0];
+                    button_act->texture = act_b_textures[0];
+                    button_item->texture = item_b_textures[0];
+                    button_leave->texture = leave_b_textures[1];
+                    break;
+                default:
+                    break;
+            }
+
+            if (keys[SDL_SCANCODE_E] && meneghetti->input_timer >= 0.2) {
+                switch(battle_flags->selected_button) {
+                    case BUTTON_FIGHT:
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        battle_flags->battle_state = BATTLE_FIGHT;
+                        break;
+                    case BUTTON_ACT:
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        battle_flags->battle_state = BATTLE_ACT;
+                        break;
+                    case BUTTON_ITEM:
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        battle_flags->battle_state = BATTLE_ITEM;
+                        break;
+                    case BUTTON_LEAVE:
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        battle_flags->battle_state = BATTLE_LEAVE;
+                        break;
+                    default:
+                        break;  
                 }
+                meneghetti->input_timer = 0.0;
+            }
+        }
 
-                if (battle_flags.battle_state == BATTLE_FIGHT) {
-                    SDL_Rect perfect_hit_rect = {bar_target.collision.x + 267, bar_target.collision.y, 56, bar_target.collision.h};
-                    SDL_Rect good_hit_rect = {bar_target.collision.x + 183, bar_target.collision.y, 224, bar_target.collision.h};
-                    SDL_Rect normal_hit_rect = {bar_target.collision.x + 62, bar_target.collision.y, 466, bar_target.collision.h};
-                    SDL_Rect bad_hit_rect = {bar_target.collision.x, bar_target.collision.y, bar_target.collision.w, bar_target.collision.h};
+        if (battle_flags->battle_state == BATTLE_FIGHT) {
+            SDL_Rect perfect_hit_rect = {bar_target->collision.x + 267, bar_target->collision.y, 56, bar_target->collision.h};
+            SDL_Rect good_hit_rect = {bar_target->collision.x + 183, bar_target->collision.y, 224, bar_target->collision.h};
+            SDL_Rect normal_hit_rect = {bar_target->collision.x + 62, bar_target->collision.y, 466, bar_target->collision.h};
+            SDL_Rect bad_hit_rect = {bar_target->collision.x, bar_target->collision.y, bar_target->collision.w, bar_target->collision.h};
 
-                    if (battle_flags.battle_turn == CHOICE_TURN) {
-                        soul.collision.x = text_attack_act.collision.x - soul.collision.w - 11;
-                        soul.collision.y = text_attack_act.collision.y + 2;
+            if (battle_flags->battle_turn == CHOICE_TURN) {
+                soul->collision.x = text_attack_act->collision.x - soul->collision.w - 11;
+                soul->collision.y = text_attack_act->collision.y + 2;
 
-                        SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                        SDL_RenderCopy(game.renderer, text_attack_act.texture, NULL, &text_attack_act.collision);
+                SDL_RenderCopy(game->renderer, soul->texture, NULL, &soul->collision);
+                SDL_RenderCopy(game->renderer, text_attack_act->texture, NULL, &text_attack_act->collision);
 
-                        if (keys[SDL_SCANCODE_TAB] && meneghetti.input_timer >= 0.2) {
-                            Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                            battle_flags.battle_state = BATTLE_MENU;
-                            meneghetti.input_timer = 0.0;
-                        }
-                        if (keys[SDL_SCANCODE_E] && meneghetti.input_timer >= 0.2) {
-                            Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                            battle_flags.battle_turn = ATTACK_TURN;
-                            meneghetti.input_timer = 0.0;
-                        }
+                if (keys[SDL_SCANCODE_TAB] && meneghetti->input_timer >= 0.2) {
+                    Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                    battle_flags->battle_state = BATTLE_MENU;
+                    meneghetti->input_timer = 0.0;
+                }
+                if (keys[SDL_SCANCODE_E] && meneghetti->input_timer >= 0.2) {
+                    Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                    battle_flags->battle_turn = ATTACK_TURN;
+                    meneghetti->input_timer = 0.0;
+                }
+            }
+
+            if (battle_flags->battle_turn == ATTACK_TURN) {
+                // 14 pixels por passo: a barra cruza o alvo no mesmo tempo em qualquer taxa de quadros.
+                static int bar_speed = 14;
+                for (int step = 0; step < sim_clock->steps; step++) {
+                    motion_begin_step(bar_motion, &bar_attack->collision);
+                    if (bar_attack->collision.x + bar_attack->collision.w > bar_target->collision.x + bar_target->collision.w - bar_speed) {
+                        bar_speed = -bar_speed;
                     }
+                    else if (bar_attack->collision.x < bar_target->collision.x - bar_speed) {
+                        bar_speed = -bar_speed;
+                    }
+                    if (!battle_flags->player_attacked) bar_attack->collision.x += bar_speed;
+                    motion_end_step(bar_motion, &bar_attack->collision);
+                }
+                SDL_FRect bar_rect = motion_rect(bar_motion, &bar_attack->collision, sim_clock->alpha);
+                SDL_RenderCopy(game->renderer, bar_target->texture, NULL, &bar_target->collision);
+                SDL_RenderCopyF(game->renderer, bar_attack->texture, NULL, &bar_rect);
 
-                    if (battle_flags.battle_turn == ATTACK_TURN) {
-                        int attack_damage;
+                if (!battle_flags->player_attacked) {
+                    if (keys[SDL_SCANCODE_E] && meneghetti->input_timer >= 0.2) {
+                        battle_flags->player_attacked = true;
 
-                        static int bar_speed = 14;
-                        SDL_RenderCopy(game.renderer, bar_target.texture, NULL, &bar_target.collision);
-                        SDL_RenderCopy(game.renderer, bar_attack.texture, NULL, &bar_attack.collision);
-                        if (bar_attack.collision.x + bar_attack.collision.w > bar_target.collision.x + bar_target.collision.w - bar_speed) {
-                            bar_speed = -bar_speed;
+                        damage->collision.x = py_life.x + py_life.w;
+                        damage->collision.y = py_life.y - 20;
+                        
+                        if (rects_intersect(&bar_attack->collision, &perfect_hit_rect, NULL)) {
+                            battle_flags->attack_damage = meneghetti->strength * 3;
                         }
-                        else if (bar_attack.collision.x < bar_target.collision.x - bar_speed) {
-                            bar_speed = -bar_speed;
+                        else if (rects_intersect(&bar_attack->collision, &good_hit_rect, NULL)) {
+                            battle_flags->attack_damage = meneghetti->strength * 1.5;
+                        }
+                        else if (rects_intersect(&bar_attack->collision, &normal_hit_rect, NULL)) {
+                            battle_flags->attack_damage = meneghetti->strength;
+                        }
+                        else if (rects_intersect(&bar_attack->collision, &bad_hit_rect, NULL)) {
+                            battle_flags->attack_damage = meneghetti->strength * 0.5;
+                        }
+                        else {
+                            battle_flags->attack_damage = 0;
                         }
 
-                        if (!battle_flags.player_attacked) {
-                            if (keys[SDL_SCANCODE_E] && meneghetti.input_timer >= 0.2) {
-                                int w, h;
-                                battle_flags.player_attacked = true;
-
-                                damage.collision.x = py_life.x + py_life.w;
-                                damage.collision.y = py_life.y - 20;
-                                
-                                if (rects_intersect(&bar_attack.collision, &perfect_hit_rect, NULL)) {
-                                    attack_damage = meneghetti.strength * 3;
-                                    damage.texture = damage_numbers[3];
-                                    SDL_QueryTexture(damage.texture, NULL, NULL, &w, &h);
-                                    damage.collision.w = w;
-                                    damage.collision.h = h;
-                                }
-                                else if (rects_intersect(&bar_attack.collision, &good_hit_rect, NULL)) {
-                                    attack_damage = meneghetti.strength * 1.5;
-                                    damage.texture = damage_numbers[2];
-                                    SDL_QueryTexture(damage.texture, NULL, NULL, &w, &h);
-                                    damage.collision.w = w;
-                                    damage.collision.h = h;
-                                }
-                                else if (rects_intersect(&bar_attack.collision, &normal_hit_rect, NULL)) {
-                                    attack_damage = meneghetti.strength;
-                                    damage.texture = damage_numbers[1];
-                                    SDL_QueryTexture(damage.texture, NULL, NULL, &w, &h);
-                                    damage.collision.w = w;
-                                    damage.collision.h = h;
-                                }
-                                else if (rects_intersect(&bar_attack.collision, &bad_hit_rect, NULL)) {
-                                    attack_damage = meneghetti.strength * 0.5;
-                                    damage.texture = damage_numbers[0];
-                                    SDL_QueryTexture(damage.texture, NULL, NULL, &w, &h);
-                                    damage.collision.w = w;
-                                    damage.collision.h = h;
-                                }
-                            }
-
-                            bar_attack.collision.x += bar_speed;
+                        if (battle_flags->attack_damage > 0) {
+                            snprintf(*damage_string, sizeof(*damage_string), "%d", battle_flags->attack_damage);
+                            damage->collision.w = number_text_width(damage_number_font, *damage_string);
+                            damage->collision.h = damage_number_font->height;
                         }
                         else {
-                            game_timers.attack_timer += dt;
+                            SDL_QueryTexture(damage->texture, NULL, NULL, &damage->collision.w, &damage->collision.h);
+                        }
+                    }
+                }
+                else {
+                    game_timers->attack_timer += dt;
 
-                            if (game_timers.attack_timer <= 3.0) {
-                                bar_attack.texture = animate_sprite(&bar_attack_animation, dt, 0.1, false);
+                    if (game_timers->attack_timer <= 3.0) {
+                        bar_attack->texture = animate_sprite(bar_attack_animation, dt, 0.1, false);
 
-                                if (!slash_sound.has_played) {
-                                    Mix_PlayChannel(SFX_CHANNEL, slash_sound.sound, 0);
-                                    slash_sound.has_played = true;
-                                }
-                                SDL_RenderCopy(game.renderer, slash.texture, NULL, &slash.collision);
-                                if (slash_animation.counter < 5) {
-                                    slash.texture = animate_sprite(&slash_animation, dt, 0.2, false);
-                                    if (slash_animation.counter > 3) {
-                                        if (!enemy_hit_sound.has_played) {
-                                            Mix_PlayChannel(SFX_CHANNEL, enemy_hit_sound.sound, 0);
-                                            enemy_hit_sound.has_played = true;
-                                            mr_python.health -= attack_damage;
-                                        }
-                                        SDL_RenderCopy(game.renderer, damage.texture, NULL, &damage.collision);
-                                        damage.collision.y--;
-
-                                        mr_python.animation_status = ENEMY_HURT;
-                                        for (int i = 0; i < ENEMY_PARTS; i++) {
-                                            mr_python.collision[i].x = ((SCREEN_WIDTH / 2) - 102) + 4 * sin(game_timers.senoidal_timer * 40.0);
-                                        }
-                                    }
-                                }
-                                else {
-                                    slash.texture = NULL;
-                                }
-                                SDL_SetRenderDrawColor(game.renderer, 168, 24, 13, 255);
-                                SDL_RenderFillRect(game.renderer, &py_life_background);
-                                
-                                double py_display_width = (double)mr_python.base_health;
-                                double target_width = (double)mr_python.health;
-                                double animate_speed = 120.0;
-
-                                if (py_display_width > target_width) {
-                                    py_display_width -= animate_speed * dt;
-                                    if (py_display_width < target_width) py_display_width = target_width;
-                                }
-                                else if (py_display_width < target_width) {
-                                    py_display_width += animate_speed * dt * 2;
-                                    if (py_display_width > target_width) py_display_width = target_width;
+                        if (!slash_sound->has_played) {
+                            Mix_PlayChannel(SFX_CHANNEL, slash_sound->sound, 0);
+                            slash_sound->has_played = true;
+                        }
+                        SDL_RenderCopy(game->renderer, slash->texture, NULL, &slash->collision);
+                        if (slash_animation->counter < 5) {
+                            slash->texture = animate_sprite(slash_animation, dt, 0.2, false);
+                            if (slash_animation->counter > 3) {
+                                if (!enemy_hit_sound->has_played) {
+                                    Mix_PlayChannel(SFX_CHANNEL, enemy_hit_sound->sound, 0);
+                                    enemy_hit_sound->has_played = true;
+                                    mr_python->health -= battle_flags->attack_damage;
+                                    emit_particles(&particle_system, hit_sparks, slash->collision.x + slash->collision.w / 2.0f, slash->collision.y + slash->collision.h / 2.0f, 0);
                                 }
+                                if (battle_flags->attack_damage > 0) render_number(game->renderer, damage_number_font, *damage_string, damage->collision.x, damage->collision.y);
+                                else SDL_RenderCopy(game->renderer, damage->texture, NULL, &damage->collision);
+                                damage->collision.y -= sim_clock->steps;
 
-                                py_life.w = (int)(py_display_width + 0.5);
+                                mr_python->animation_status = ENEMY_HURT;
+                                for (int i = 0; i < ENEMY_PARTS; i++) {
+                                    mr_python->collision[i].x = ((SCREEN_WIDTH / 2) - 102) + 4 * sin(game_timers->senoidal_timer * 40.0);
+                                }
+                            }
+                        }
+                        else {
+                            slash->texture = NULL;
+                        }
+                        SDL_SetRenderDrawColor(game->renderer, 168, 24, 13, 255);
+                        SDL_RenderFillRect(game->renderer, &py_life_background);
+                        
+                        double py_display_width = (double)mr_python->base_health;
+                        double target_width = (double)mr_python->health;
+                        double animate_speed = 120.0;
 
-                                SDL_SetRenderDrawColor(game.renderer, 8, 207, 21, 255);
-                                SDL_RenderFillRect(game.renderer, &py_life);
+                        if (py_display_width > target_width) {
+                            py_display_width -= animate_speed * dt;
+                            if (py_display_width < target_width) py_display_width = target_width;
+                        }
+                        else if (py_display_width < target_width) {
+                            py_display_width += animate_speed * dt * 2;
+                            if (py_display_width > target_width) py_display_width = target_width;
+                        }
 
-                                if (slash_animation.counter > 3) {
-                                    SDL_RenderCopy(game.renderer, damage.texture, NULL, &damage.collision);
-                                }
-                            }   
-                            else {
-                                mr_python.animation_status = ENEMY_IDLE;
+                        py_life.w = (int)(py_display_width + 0.5);
 
-                                slash_sound.has_played = false;
-                                enemy_hit_sound.has_played = false;
+                        SDL_SetRenderDrawColor(game->renderer, 8, 207, 21, 255);
+                        SDL_RenderFillRect(game->renderer, &py_life);
 
-                                game_timers.attack_timer = 0.0;
-                                battle_flags.player_attacked = false;
-                                battle_flags.battle_turn = SOUL_TURN;
-                                slash_animation.counter = 0;
-                            }
+                        if (slash_animation->counter > 3) {
+                            if (battle_flags->attack_damage > 0) render_number(game->renderer, damage_number_font, *damage_string, damage->collision.x, damage->collision.y);
+                            else SDL_RenderCopy(game->renderer, damage->texture, NULL, &damage->collision);
                         }
-                    }
-                    if (battle_flags.battle_turn == SOUL_TURN) {
-                        bar_attack.collision.x = bar_target.collision.x + 20;
-                        double target_w = (double)battle_box.base_box.h;
-                        int enemy_attack;
-                        int random_dialogue;
+                    }   
+                    else {
+                        mr_python->animation_status = ENEMY_IDLE;
 
-                        if (!battle_flags.random_attack_selected) {
-                            enemy_attack = randint(1, 4);
-                            random_dialogue = randint(1, 3);
+                        slash_sound->has_played = false;
+                        enemy_hit_sound->has_played = false;
 
-                            battle_flags.random_attack_selected = true;
-                        }
+                        game_timers->attack_timer = 0.0;
+                        battle_flags->player_attacked = false;
+                        battle_flags->battle_turn = SOUL_TURN;
+                        slash_animation->counter = 0;
+                    }
+                }
+            }
+            if (battle_flags->battle_turn == SOUL_TURN) {
+                bar_attack->collision.x = bar_target->collision.x + 20;
+                double target_w = (double)battle_box->base_box.h;
+                int enemy_attack;
+                int random_dialogue;
 
-                        if (soul.is_ivulnerable) {
-                            soul.ivulnerability_timer += dt;
+                if (!battle_flags->random_attack_selected) {
+                    enemy_attack = randint(1, 4);
+                    random_dialogue = randint(1, 3);
 
-                            soul.texture = animate_sprite(&soul_animation, dt, 0.1, false);
-                            if (soul.ivulnerability_timer >= 1.0) {
-                                soul.texture = soul_animation.frames[0];
-                                soul.is_ivulnerable = false;
-                                soul.ivulnerability_timer = 0.0;
-                            }
-                        }
+                    battle_flags->random_attack_selected = true;
+                }
 
-                        if (battle_box.animated_box.w > target_w && !battle_box.should_retract) {
-                            battle_box.animation_timer += dt;
-                            if (battle_box.animation_timer > 0.8) battle_box.animation_timer = 0.8;
+                if (soul->is_ivulnerable) {
+                    soul->ivulnerability_timer += dt;
 
-                            double t = battle_box.animation_timer / 0.8;
-                            t = 1.0 - pow(1.0 - t, 3.0);
+                    soul->texture = animate_sprite(soul_animation, dt, 0.1, false);
+                    if (soul->ivulnerability_timer >= 1.0) {
+                        soul->texture = soul_animation->frames[0];
+                        soul->is_ivulnerable = false;
+                        soul->ivulnerability_timer = 0.0;
+                    }
+                }
 
-                            double start_w = (double)battle_box.base_box.w;
-                            double new_w = start_w + (target_w - start_w) * t;
+                if (battle_box->animated_box.w > target_w && !battle_box->should_retract) {
+                    battle_box->animation_timer += dt;
+                    if (battle_box->animation_timer > 0.8) battle_box->animation_timer = 0.8;
 
-                            int center_x = battle_box.base_box.x + battle_box.base_box.w / 2;
-                            battle_box.animated_box.w = (int)(new_w + 0.5);
-                            battle_box.animated_box.x = center_x - battle_box.animated_box.w / 2;
-                            battle_box.animated_box.y = battle_box.base_box.y; 
-                            battle_box.animated_box.h = battle_box.base_box.h;
+                    double t = battle_box->animation_timer / 0.8;
+                    t = 1.0 - pow(1.0 - t, 3.0);
 
-                            soul.collision.x = (battle_box.animated_box.x + (battle_box.animated_box.w / 2)) - (soul.collision.w / 2);
-                            soul.collision.y = (battle_box.animated_box.y + (battle_box.animated_box.h / 2)) - (soul.collision.h / 2);
-                        }
-                        else if (!battle_box.should_retract) {
-                            game_timers.turn_timer += dt;
-                            SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-
-                            if (game_timers.turn_timer <= 10.0) {
-                                if (keys[SDL_SCANCODE_W]) {
-                                    SDL_Rect test = soul.collision;
-                                    test.y -= 2;
-                                    if (!check_collision(&test, box_borders, 4)) {
-                                        soul.collision.y -= 2;
-                                    }
-                                }
-                                if (keys[SDL_SCANCODE_S]) {
-                                    SDL_Rect test = soul.collision;
-                                    test.y += 2;
-                                    if (!check_collision(&test, box_borders, 4)) {
-                                        soul.collision.y += 2;
-                                    }   
-                                }
-                                if (keys[SDL_SCANCODE_A]) {
-                                    SDL_Rect test = soul.collision;
-                                    test.x -= 2;
-                                    if (!check_collision(&test, box_borders, 4)) {
-                                        soul.collision.x -= 2;
-                                    }
-                                }
-                                if (keys[SDL_SCANCODE_D]) {
-                                    SDL_Rect test = soul.collision;
-                                    test.x += 2;
-                                    if (!check_collision(&test, box_borders, 4)) {
-                                        soul.collision.x += 2;
-                                    }
-                                }
+                    double start_w = (double)battle_box->base_box.w;
+                    double new_w = start_w + (target_w - start_w) * t;
 
-                                if (game_timers.turn_timer >= 0.5) {
-                                    python_attacks(game.renderer, &soul, battle_box, &meneghetti.health, mr_python.strength, enemy_attack, python_props, dt, game_timers.turn_timer, battle_sounds, false); // ATAQUE SELECIONADO.
-                                    switch (random_dialogue) {
-                                        case 1: 
-                                            create_dialogue(&meneghetti, game.renderer, &bubble_speech_1, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, &bubble_speech);
-                                            break;
-                                        case 2:
-                                            create_dialogue(&meneghetti, game.renderer, &bubble_speech_2, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, &bubble_speech);
-                                            break;
-                                        case 3:
-                                            create_dialogue(&meneghetti, game.renderer, &bubble_speech_3, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, &bubble_speech);
-                                            break;
-                                        default:
-                                            break;
-                                    }   
+                    int center_x = battle_box->base_box.x + battle_box->base_box.w / 2;
+                    battle_box->animated_box.w = (int)(new_w + 0.5);
+                    battle_box->animated_box.x = center_x - battle_box->animated_box.w / 2;
+                    battle_box->animated_box.y = battle_box->base_box.y; 
+                    battle_box->animated_box.h = battle_box->base_box.h;
+
+                    soul->collision.x = (battle_box->animated_box.x + (battle_box->animated_box.w / 2)) - (soul->collision.w / 2);
+                    soul->collision.y = (battle_box->animated_box.y + (battle_box->animated_box.h / 2)) - (soul->collision.h / 2);
+                }
+                else if (!battle_box->should_retract) {
+                    game_timers->turn_timer += dt;
+
+                    // A alma anda 2 pixels por passo fixo e é desenhada entre os dois últimos.
+                    for (int step = 0; step < sim_clock->steps; step++) {
+                        motion_begin_step(soul_motion, &soul->collision);
+                        if (game_timers->turn_timer <= 10.0) {
+                            if (keys[SDL_SCANCODE_W]) {
+                                SDL_Rect test = soul->collision;
+                                test.y -= 2;
+                                if (!check_collision(&test, box_borders, 4)) {
+                                    soul->collision.y -= 2;
                                 }
                             }
-                            else {
-                                reset_dialogue(&bubble_speech_1);
-                                reset_dialogue(&bubble_speech_2);
-                                reset_dialogue(&bubble_speech_3);
-
-                                python_attacks(game.renderer, &soul, battle_box, &meneghetti.health, mr_python.base_strength, enemy_attack, python_props, dt, game_timers.turn_timer, battle_sounds, true);
-                                python_props[2][0].texture = python_mother_animation.frames[0];
-                                battle_box.should_retract = true;
-                                battle_box.animation_timer = 0.0;
-                                game_timers.turn_timer = 0.0;
+                            if (keys[SDL_SCANCODE_S]) {
+                                SDL_Rect test = soul->collision;
+                                test.y += 2;
+                                if (!check_collision(&test, box_borders, 4)) {
+                                    soul->collision.y += 2;
+                                }   
                             }
-                        }
-                        else if (battle_box.should_retract) {
-                            battle_box.animation_timer += dt;
-                            if (battle_box.animation_timer > 0.8) battle_box.animation_timer = 0.8;
-
-                            double t = battle_box.animation_timer / 0.8;
-                            t = 1.0 - pow(1.0 - t, 3.0);
-
-                            double start_w = (double)battle_box.base_box.h;
-                            double target_expand_w = (double)battle_box.base_box.w;
-                            double new_w = start_w + (target_expand_w - start_w) * t;
-
-                            int center_x = battle_box.base_box.x + battle_box.base_box.w / 2;
-                            battle_box.animated_box.w = (int)(new_w + 0.5);
-                            battle_box.animated_box.x = center_x - battle_box.animated_box.w / 2;
-                            battle_box.animated_box.y = battle_box.base_box.y;
-                            battle_box.animated_box.h = battle_box.base_box.h;
-
-                            if (battle_box.animation_timer >= 0.8) {
-                                meneghetti.input_timer = 0.0;
-                                battle_box.animation_timer = 0.0;
-                                battle_box.should_retract = false;
-                                battle_flags.battle_turn = CHOICE_TURN;
-                                battle_flags.battle_state = BATTLE_MENU;
-                                battle_flags.random_attack_selected = false;
-                                battle_flags.turn_counter++;
-
-                                if (mr_python.strength != mr_python.base_strength) mr_python.strength = mr_python.base_strength;
-
-                                battle_box.animated_box = battle_box.base_box;
+                            if (keys[SDL_SCANCODE_A]) {
+                                SDL_Rect test = soul->collision;
+                                test.x -= 2;
+                                if (!check_collision(&test, box_borders, 4)) {
+                                    soul->collision.x -= 2;
+                                }
+                            }
+                            if (keys[SDL_SCANCODE_D]) {
+                                SDL_Rect test = soul->collision;
+                                test.x += 2;
+                                if (!check_collision(&test, box_borders, 4)) {
+                                    soul->collision.x += 2;
+                                }
                             }
                         }
+                        motion_end_step(soul_motion, &soul->collision);
                     }
-                }
+                    SDL_FRect soul_rect = motion_rect(soul_motion, &soul->collision, sim_clock->alpha);
+                    SDL_RenderCopyF(game->renderer, soul->texture, NULL, &soul_rect);
 
-                if (battle_flags.battle_state == BATTLE_ACT) {
-                    if (meneghetti.player_state == PLAYER_IDLE && battle_flags.battle_turn != ACT_TURN) {
-                        battle_flags.turn_counter++;
+                    if (game_timers->turn_timer <= 10.0) {
 
-                        battle_flags.battle_state = BATTLE_MENU;
-                        battle_flags.battle_turn = CHOICE_TURN;
-                        meneghetti.player_state = PLAYER_ON_BATTLE;
-                        battle_flags.reading_text = false;
-                        meneghetti.input_timer = 0.0;
-                        battle_flags.menu_position = (MenuPosition){1, 1};
+                        if (game_timers->turn_timer >= 0.5) {
+                            python_attacks(game->renderer, soul, *battle_box, &meneghetti->health, mr_python->strength, enemy_attack, python_props, dt, sim_clock->steps / SIM_RATE, game_timers->turn_timer, battle_sounds, false); // ATAQUE SELECIONADO.
+                            switch (random_dialogue) {
+                                case 1: 
+                                    create_dialogue(meneghetti, game->renderer, bubble_typewriter, bubble_speech_1, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, bubble_speech);
+                                    break;
+                                case 2:
+                                    create_dialogue(meneghetti, game->renderer, bubble_typewriter, bubble_speech_2, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, bubble_speech);
+                                    break;
+                                case 3:
+                                    create_dialogue(meneghetti, game->renderer, bubble_typewriter, bubble_speech_3, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, bubble_speech);
+                                    break;
+                                default:
+                                    break;
+                            }   
+                        }
                     }
                     else {
-                        if (battle_flags.battle_turn == CHOICE_TURN) {
-                            soul.collision.x = text_attack_act.collision.x - soul.collision.w - 11;
-                            soul.collision.y = text_attack_act.collision.y + 2;
+                        reset_typewriter(bubble_typewriter);
+
+                        python_attacks(game->renderer, soul, *battle_box, &meneghetti->health, mr_python->base_strength, enemy_attack, python_props, dt, 0.0, game_timers->turn_timer, battle_sounds, true);
+                        python_props[2][0].texture = python_mother_animation->frames[0];
+                        battle_box->should_retract = true;
+                        battle_box->animation_timer = 0.0;
+                        game_timers->turn_timer = 0.0;
+                    }
+                }
+                else if (battle_box->should_retract) {
+                    battle_box->animation_timer += dt;
+                    if (battle_box->animation_timer > 0.8) battle_box->animation_timer = 0.8;
+
+                    double t = battle_box->animation_timer / 0.8;
+                    t = 1.0 - pow(1.0 - t, 3.0);
+
+                    double start_w = (double)battle_box->base_box.h;
+                    double target_expand_w = (double)battle_box->base_box.w;
+                    double new_w = start_w + (target_expand_w - start_w) * t;
+
+                    int center_x = battle_box->base_box.x + battle_box->base_box.w / 2;
+                    battle_box->animated_box.w = (int)(new_w + 0.5);
+                    battle_box->animated_box.x = center_x - battle_box->animated_box.w / 2;
+                    battle_box->animated_box.y = battle_box->base_box.y;
+                    battle_box->animated_box.h = battle_box->base_box.h;
+
+                    if (battle_box->animation_timer >= 0.8) {
+                        meneghetti->input_timer = 0.0;
+                        battle_box->animation_timer = 0.0;
+                        battle_box->should_retract = false;
+                        battle_flags->battle_turn = CHOICE_TURN;
+                        battle_flags->battle_state = BATTLE_MENU;
+                        battle_flags->random_attack_selected = false;
+                        battle_flags->turn_counter++;
+
+                        if (mr_python->strength != mr_python->base_strength) mr_python->strength = mr_python->base_strength;
+
+                        battle_box->animated_box = battle_box->base_box;
+                    }
+                }
+            }
+        }
 
-                            SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                            SDL_RenderCopy(game.renderer, text_attack_act.texture, NULL, &text_attack_act.collision);
+        if (battle_flags->battle_state == BATTLE_ACT) {
+            if (meneghetti->player_state == PLAYER_IDLE && battle_flags->battle_turn != ACT_TURN) {
+                battle_flags->turn_counter++;
 
-                            if (keys[SDL_SCANCODE_TAB] && meneghetti.input_timer >= INPUT_DELAY) {
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                battle_flags.battle_state = BATTLE_MENU;
-                                meneghetti.input_timer = 0.0;
-                            }
-                            if (keys[SDL_SCANCODE_E] && meneghetti.input_timer >= INPUT_DELAY) {
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                battle_flags.battle_turn = ACT_TURN;
-                                meneghetti.input_timer = 0.0;
-                            }
-                        }
-                        if (battle_flags.battle_turn == ACT_TURN) {
-                            if (!battle_flags.reading_text) {
-                                if (battle_flags.menu_position.column > 2) battle_flags.menu_position.column = 1;
-                                if (battle_flags.menu_position.column < 1)  battle_flags.menu_position.column = 2;
-                                if (battle_flags.menu_position.line > 2) battle_flags.menu_position.line = 1;
-                                if (battle_flags.menu_position.line < 1) battle_flags.menu_position.line = 2;
-
-                                switch(battle_flags.menu_position.column) {
+                battle_flags->battle_state = BATTLE_MENU;
+                battle_flags->battle_turn = CHOICE_TURN;
+                meneghetti->player_state = PLAYER_ON_BATTLE;
+                battle_flags->reading_text = false;
+                meneghetti->input_timer = 0.0;
+                battle_flags->menu_position = (MenuPosition){1, 1};
+            }
+            else {
+                if (battle_flags->battle_turn == CHOICE_TURN) {
+                    soul->collision.x = text_attack_act->collision.x - soul->collision.w - 11;
+                    soul->collision.y = text_attack_act->collision.y + 2;
+
+                    SDL_RenderCopy(game->renderer, soul->texture, NULL, &soul->collision);
+                    SDL_RenderCopy(game->renderer, text_attack_act->texture, NULL, &text_attack_act->collision);
+
+                    if (keys[SDL_SCANCODE_TAB] && meneghetti->input_timer >= INPUT_DELAY) {
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        battle_flags->battle_state = BATTLE_MENU;
+                        meneghetti->input_timer = 0.0;
+                    }
+                    if (keys[SDL_SCANCODE_E] && meneghetti->input_timer >= INPUT_DELAY) {
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        battle_flags->battle_turn = ACT_TURN;
+                        meneghetti->input_timer = 0.0;
+                    }
+                }
+                if (battle_flags->battle_turn == ACT_TURN) {
+                    if (!battle_flags->reading_text) {
+                        if (battle_flags->menu_position.column > 2) battle_flags->menu_position.column = 1;
+                        if (battle_flags->menu_position.column < 1)  battle_flags->menu_position.column = 2;
+                        if (battle_flags->menu_position.line > 2) battle_flags->menu_position.line = 1;
+                        if (battle_flags->menu_position.line < 1) battle_flags->menu_position.line = 2;
+
+                        switch(battle_flags->menu_position.column) {
+                            case 1:
+                                switch(battle_flags->menu_position.line) {
                                     case 1:
-                                        switch(battle_flags.menu_position.line) {
-                                            case 1:
-                                                soul.collision.x = text_act[0].collision.x - soul.collision.w - 11;
-                                                soul.collision.y = text_act[0].collision.y + 2;
-                                                break;
-                                            case 2:
-                                                soul.collision.x = text_act[1].collision.x - soul.collision.w - 11;
-                                                soul.collision.y = text_act[1].collision.y + 2;
-                                                break;
-                                        }
+                                        soul->collision.x = text_act[0].collision.x - soul->collision.w - 11;
+                                        soul->collision.y = text_act[0].collision.y + 2;
                                         break;
                                     case 2:
-                                        soul.collision.x = text_act[2].collision.x - soul.collision.w - 11;
-                                        soul.collision.y = text_act[2].collision.y + 2;
+                                        soul->collision.x = text_act[1].collision.x - soul->collision.w - 11;
+                                        soul->collision.y = text_act[1].collision.y + 2;
                                         break;
-                                    default:
-                                    break;
                                 }
+                                break;
+                            case 2:
+                                soul->collision.x = text_act[2].collision.x - soul->collision.w - 11;
+                                soul->collision.y = text_act[2].collision.y + 2;
+                                break;
+                            default:
+                            break;
+                        }
 
-                                SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                                SDL_RenderCopy(game.renderer, text_act[0].texture, NULL, &text_act[0].collision);
-                                SDL_RenderCopy(game.renderer, text_act[1].texture, NULL, &text_act[1].collision);
-                                SDL_RenderCopy(game.renderer, text_act[2].texture, NULL, &text_act[2].collision);
+                        SDL_RenderCopy(game->renderer, soul->texture, NULL, &soul->collision);
+                        SDL_RenderCopy(game->renderer, text_act[0].texture, NULL, &text_act[0].collision);
+                        SDL_RenderCopy(game->renderer, text_act[1].texture, NULL, &text_act[1].collision);
+                        SDL_RenderCopy(game->renderer, text_act[2].texture, NULL, &text_act[2].collision);
 
-                                if (keys[SDL_SCANCODE_TAB] && meneghetti.input_timer >= INPUT_DELAY) {
-                                    Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                    battle_flags.battle_turn = CHOICE_TURN;
-                                    meneghetti.input_timer = 0.0;
-                                }
-                                if (keys[SDL_SCANCODE_E] && meneghetti.input_timer >= INPUT_DELAY) {
-                                    Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                    switch(battle_flags.menu_position.column) {
-                                        case 1:
-                                            switch(battle_flags.menu_position.line) {
-                                                case 2:
-                                                    mr_python.strength += 2;
-                                                    break;
-                                            }
-                                            break;
-                                        case 2:
-                                            switch(battle_flags.menu_position.line) {
-                                                case 1:
-                                                    mr_python.strength -= 1;
-                                                    break;
-                                            }
-                                            break;
-                                        default:
-                                            break;
-                                    }
-                                    battle_flags.reading_text = true;
-                                    meneghetti.input_timer = 0.0;
-                                }
-                                if (keys[SDL_SCANCODE_S] && meneghetti.input_timer >= INPUT_DELAY) {
-                                    Mix_PlayChannel(DEFAULT_CHANNEL, move_button.sound, 0);
-                                    battle_flags.menu_position.line++;
-                                    meneghetti.input_timer = 0.0;
-                                }
-                                if (keys[SDL_SCANCODE_W] && meneghetti.input_timer >= INPUT_DELAY) {
-                                    Mix_PlayChannel(DEFAULT_CHANNEL, move_button.sound, 0);
-                                    battle_flags.menu_position.line--;
-                                    meneghetti.input_timer = 0.0;
-                                }
-                                if (keys[SDL_SCANCODE_D] && meneghetti.input_timer >= INPUT_DELAY) {
-                                    Mix_PlayChannel(DEFAULT_CHANNEL, move_button.sound, 0);
-                                    battle_flags.menu_position.column++;
-                                    meneghetti.input_timer = 0.0;
-                                }
-                                if (keys[SDL_SCANCODE_A] && meneghetti.input_timer >= INPUT_DELAY) {
-                                    Mix_PlayChannel(DEFAULT_CHANNEL, move_button.sound, 0);
-                                    battle_flags.menu_position.column--;
-                                    meneghetti.input_timer = 0.0;
-                                }
-                            }
-                            else {
-                                switch(battle_flags.menu_position.column) {
+                        if (keys[SDL_SCANCODE_TAB] && meneghetti->input_timer >= INPUT_DELAY) {
+                            Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                            battle_flags->battle_turn = CHOICE_TURN;
+                            meneghetti->input_timer = 0.0;
+                        }
+                        if (keys[SDL_SCANCODE_E] && meneghetti->input_timer >= INPUT_DELAY) {
+                            Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                            switch(battle_flags->menu_position.column) {
                                 case 1:
-                                    switch(battle_flags.menu_position.line) {
-                                        case 1:
-                                            create_dialogue(&meneghetti, game.renderer, &fight_act_txt, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
-                                            break;
+                                    switch(battle_flags->menu_position.line) {
                                         case 2:
-                                            create_dialogue(&meneghetti, game.renderer, &insult_txt, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
+                                            mr_python->strength += 2;
                                             break;
                                     }
                                     break;
                                 case 2:
-                                    create_dialogue(&meneghetti, game.renderer, &explain_txt, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
+                                    switch(battle_flags->menu_position.line) {
+                                        case 1:
+                                            mr_python->strength -= 1;
+                                            break;
+                                    }
                                     break;
                                 default:
                                     break;
-                                }
-
-                                if (meneghetti.player_state == PLAYER_IDLE) {
-                                    battle_flags.reading_text = false;
-                                    if (battle_flags.menu_position.column == 1 && battle_flags.menu_position.line == 1) {
-                                        battle_flags.battle_turn = ACT_TURN;
-                                        meneghetti.player_state = PLAYER_ON_BATTLE;
-                                    }
-                                    else {
-                                        battle_flags.battle_turn = SOUL_TURN;
-                                        battle_flags.battle_state = BATTLE_FIGHT;
-                                        meneghetti.player_state = PLAYER_ON_BATTLE;
-                                    }
-
-                                    meneghetti.input_timer = 0.0;
-                                    battle_flags.menu_position = (MenuPosition){1, 1};
-                                }
                             }
+                            battle_flags->reading_text = true;
+                            meneghetti->input_timer = 0.0;
                         }
-                    }
-                }
-
-                if (battle_flags.battle_state == BATTLE_ITEM) {
-                    if (meneghetti.player_state == PLAYER_IDLE) {
-                        battle_flags.reading_text = false;
-                        meneghetti.input_timer = 0.0;
-                        battle_flags.menu_position = (MenuPosition){1, 1};
-
-                        if (eat_sound.has_played) {
-                            battle_flags.battle_turn = SOUL_TURN;
-                            battle_flags.battle_state = BATTLE_FIGHT;
-                            meneghetti.player_state = PLAYER_ON_BATTLE;
+                        if (keys[SDL_SCANCODE_S] && meneghetti->input_timer >= INPUT_DELAY) {
+                            Mix_PlayChannel(DEFAULT_CHANNEL, move_button->sound, 0);
+                            battle_flags->menu_position.line++;
+                            meneghetti->input_timer = 0.0;
                         }
-                        else {
-                            battle_flags.battle_turn = CHOICE_TURN;
-                            battle_flags.battle_state = BATTLE_MENU;
-                            meneghetti.player_state = PLAYER_ON_BATTLE;
+                        if (keys[SDL_SCANCODE_W] && meneghetti->input_timer >= INPUT_DELAY) {
+                            Mix_PlayChannel(DEFAULT_CHANNEL, move_button->sound, 0);
+                            battle_flags->menu_position.line--;
+                            meneghetti->input_timer = 0.0;
                         }
-                        battle_flags.turn_counter++;
-
-                        eat_sound.has_played = false;
-                    }
-                    else {
-                        if (!battle_flags.reading_text && meneghetti.inventory_counter > 0) {
-                            soul.collision.x = text_item.collision.x - soul.collision.w - 11;
-                            soul.collision.y = text_item.collision.y + 2;
-                            food_amount_text.collision.x = text_item.collision.x + text_item.collision.w + 5;
-                            food_amount_text.collision.y = text_item.collision.y;
-
-                            SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                            SDL_RenderCopy(game.renderer, text_item.texture, NULL, &text_item.collision);
-                            SDL_RenderCopy(game.renderer, food_amount_text.texture, NULL, &food_amount_text.collision);
-
-                            if (keys[SDL_SCANCODE_TAB] && meneghetti.input_timer >= INPUT_DELAY) {
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                battle_flags.battle_state = BATTLE_MENU;
-                                meneghetti.input_timer = 0.0;
-                            }
-                            if (keys[SDL_SCANCODE_E] && meneghetti.input_timer >= INPUT_DELAY) {
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                meneghetti.health += 20;
-                                battle_flags.reading_text = true;
-                                meneghetti.input_timer = 0.0;
-                            }
+                        if (keys[SDL_SCANCODE_D] && meneghetti->input_timer >= INPUT_DELAY) {
+                            Mix_PlayChannel(DEFAULT_CHANNEL, move_button->sound, 0);
+                            battle_flags->menu_position.column++;
+                            meneghetti->input_timer = 0.0;
+                        }
+                        if (keys[SDL_SCANCODE_A] && meneghetti->input_timer >= INPUT_DELAY) {
+                            Mix_PlayChannel(DEFAULT_CHANNEL, move_button->sound, 0);
+                            battle_flags->menu_position.column--;
+                            meneghetti->input_timer = 0.0;
                         }
-                        else {
-                            if (!eat_sound.has_played && meneghetti.inventory_counter > 0) {
-                                Mix_PlayChannel(SFX_CHANNEL, eat_sound.sound, 0);
-                                eat_sound.has_played = true;
-                            }
-                            if (meneghetti.inventory_counter > 0) {
-                                create_dialogue(&meneghetti, game.renderer, &picanha_txt, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
-                            }
-                            else {
-                                create_dialogue(&meneghetti, game.renderer, &no_food_txt, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
-                            }
-                        }   
-                    }
-                }
-
-                if (battle_flags.battle_state == BATTLE_LEAVE) {
-                    if (meneghetti.player_state == PLAYER_IDLE) {
-                        battle_flags.battle_state = BATTLE_MENU;
-                        meneghetti.player_state = PLAYER_ON_BATTLE;
-                        battle_flags.reading_text = false;
-                        meneghetti.input_timer = 0.0;
-                        battle_flags.turn_counter++;
-                        battle_flags.menu_position = (MenuPosition){1, 1};
                     }
                     else {
-                        if (!battle_flags.reading_text) {
-                            if (battle_flags.menu_position.line > 2) battle_flags.menu_position.line = 1;
-                            if (battle_flags.menu_position.line < 1) battle_flags.menu_position.line = 2;
-
-                            switch(battle_flags.menu_position.line) {
+                        switch(battle_flags->menu_position.column) {
+                        case 1:
+                            switch(battle_flags->menu_position.line) {
                                 case 1:
-                                    soul.collision.x = text_leave[0].collision.x - soul.collision.w - 11;
-                                    soul.collision.y = text_leave[0].collision.y + 2;
+                                    create_dialogue(meneghetti, game->renderer, dialogue_typewriter, fight_act_txt, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
                                     break;
                                 case 2:
-                                    soul.collision.x = text_leave[1].collision.x - soul.collision.w - 11;
-                                    soul.collision.y = text_leave[1].collision.y + 2;
-                                    break;
-                                default:
+                                    create_dialogue(meneghetti, game->renderer, dialogue_typewriter, insult_txt, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
                                     break;
                             }
+                            break;
+                        case 2:
+                            create_dialogue(meneghetti, game->renderer, dialogue_typewriter, explain_txt, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
+                            break;
+                        default:
+                            break;
+                        }
 
-                            SDL_RenderCopy(game.renderer, soul.texture, NULL, &soul.collision);
-                            SDL_RenderCopy(game.renderer, text_leave[0].texture, NULL, &text_leave[0].collision);
-                            SDL_RenderCopy(game.renderer, text_leave[1].texture, NULL, &text_leave[1].collision);
-
-                            if (keys[SDL_SCANCODE_TAB] && meneghetti.input_timer >= INPUT_DELAY) {
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                battle_flags.battle_state = BATTLE_MENU;
-                                meneghetti.input_timer = 0.0;
+                        if (meneghetti->player_state == PLAYER_IDLE) {
+                            battle_flags->reading_text = false;
+                            if (battle_flags->menu_position.column == 1 && battle_flags->menu_position.line == 1) {
+                                battle_flags->battle_turn = ACT_TURN;
+                                meneghetti->player_state = PLAYER_ON_BATTLE;
                             }
-                            if (keys[SDL_SCANCODE_E] && meneghetti.input_timer >= INPUT_DELAY) {
-                                Mix_PlayChannel(DEFAULT_CHANNEL, click_button.sound, 0);
-                                battle_flags.reading_text = true;
-                                meneghetti.input_timer = 0.0;
-                            }
-                            if (keys[SDL_SCANCODE_S] && meneghetti.input_timer >= INPUT_DELAY) {
-                                Mix_PlayChannel(DEFAULT_CHANNEL, move_button.sound, 0);
-                                battle_flags.menu_position.line++;
-                                meneghetti.input_timer = 0.0;
-                            }
-                            if (keys[SDL_SCANCODE_W] && meneghetti.input_timer >= INPUT_DELAY) {
-                                Mix_PlayChannel(DEFAULT_CHANNEL, move_button.sound, 0);
-                                battle_flags.menu_position.line--;
-                                meneghetti.input_timer = 0.0;
-                            }
-                        }
-                        else {
-                            switch(battle_flags.menu_position.line) {
-                                case 1:
-                                    create_dialogue(&meneghetti, game.renderer, &fight_spare_txt, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
-                                    break;
-                                case 2:
-                                    create_dialogue(&meneghetti, game.renderer, &fight_leave_txt, NULL, &meneghetti.player_state, &game.game_state, dt, NULL, dialogue_voices, false);
-                                    break;
-                                default:
-                                    break;
+                            else {
+                                battle_flags->battle_turn = SOUL_TURN;
+                                battle_flags->battle_state = BATTLE_FIGHT;
+                                meneghetti->player_state = PLAYER_ON_BATTLE;
                             }
-                        }
-                    }
-                }
-                if (mr_python.health <= 0) {
-                    mr_python.health = 0;
-                    battle_flags.battle_state = BATTLE_MENU;
-                    battle_flags.battle_turn = CHOICE_TURN;
-
-                    mr_python.animation_status = ENEMY_HURT;
-                    for (int i = 0; i < ENEMY_PARTS; i++) {
-                        mr_python.collision[i].x = ((SCREEN_WIDTH / 2) - 102) + 4 * sin(game_timers.senoidal_timer * 40.0);
-                    }
 
-                    if (end_scene_fade.fading_in) {
-                        end_scene_fade.timer += dt;
-                        end_scene_fade.alpha = 0 + (Uint8)((end_scene_fade.timer / 5.0) * 255);
-
-                        if (end_scene_fade.timer >= 5.0) {
-                            end_scene_fade.alpha = 255;
-                            end_scene_fade.fading_in = false;
+                            meneghetti->input_timer = 0.0;
+                            battle_flags->menu_position = (MenuPosition){1, 1};
                         }
                     }
-                    else {
-                        end_scene_fade.timer = 0.0;
-                        battle_flags.enemy_dead = true;
-                    }
-
-                    if (end_scene_fade.alpha < 255) {
-                        SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, end_scene_fade.alpha);
-                        SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
-
-                        SDL_Rect screen_fade = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-                        SDL_RenderFillRect(game.renderer, &screen_fade);
-                    }
-                }
-            }
-
-            if (meneghetti.player_state == PLAYER_DEAD || battle_flags.enemy_dead) {
-                Mix_HaltChannel(MUSIC_CHANNEL);
-
-                python_props[2][0].texture = python_mother_animation.frames[0];
-
-                python_attacks(game.renderer, &soul, battle_box, &meneghetti.health, mr_python.strength, 0, python_props, dt, game_timers.turn_timer, battle_sounds, true);
-
-                int attack_widths, attack_heights;
-                SDL_QueryTexture(command_rain[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[4].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[4].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(command_rain[5].texture, NULL, NULL, &attack_widths, &attack_heights);
-                command_rain[5].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-
-                SDL_QueryTexture(parenthesis_enclosure[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[4].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[4].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                SDL_QueryTexture(parenthesis_enclosure[5].texture, NULL, NULL, &attack_widths, &attack_heights);
-                parenthesis_enclosure[5].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-
-                python_mother[0].texture = python_mother_animation.frames[0];
-                SDL_QueryTexture(python_mother[0].texture, NULL, NULL, &attack_widths, &attack_heights);
-                python_mother[0].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                python_mother[1].texture = python_mother_animation.frames[1];
-                SDL_QueryTexture(python_mother[1].texture, NULL, NULL, &attack_widths, &attack_heights);
-                python_mother[1].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                python_mother[2].texture = python_baby_animation.frames[0];
-                SDL_QueryTexture(python_mother[2].texture, NULL, NULL, &attack_widths, &attack_heights);
-                python_mother[2].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-                python_mother[3].texture = python_baby_animation.frames[1];
-                SDL_QueryTexture(python_mother[3].texture, NULL, NULL, &attack_widths, &attack_heights);
-                python_mother[3].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
-
-                python_props[0] = command_rain;
-                python_props[1] = parenthesis_enclosure;
-                python_props[2] = python_mother;
-
-                soul_animation.counter = 0;
-                slash_animation.counter = 0;
-                bar_attack.collision.x = bar_target.collision.x + 20;
-
-                if (meneghetti.player_state == PLAYER_DEAD) {
-                    game.game_state = DEATH_SCREEN;
-                    meneghetti.death_count++;
-                }
-                else if (battle_flags.enemy_dead) {
-                    game.game_state = FINAL_SCREEN;
-                    end_scene_fade.timer = 0.0;
-                    end_scene_fade.alpha = 255;
-                    end_scene_fade.fading_in = true;
                 }
             }
         }
 
-        if (game.game_state == DEATH_SCREEN) {
-            game_timers.death_timer += dt;
+        if (battle_flags->battle_state == BATTLE_ITEM) {
+            if (meneghetti->player_state == PLAYER_IDLE) {
+                battle_flags->reading_text = false;
+                meneghetti->input_timer = 0.0;
+                battle_flags->menu_position = (MenuPosition){1, 1};
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer);
-
-            if (game_timers.death_timer <= 2.0) {
-                if (!soul_break_sound.has_played) {
-                    Mix_PlayChannel(SFX_CHANNEL, soul_break_sound.sound, 0);
-                    soul_break_sound.has_played = true;
+                if (eat_sound->has_played) {
+                    battle_flags->battle_turn = SOUL_TURN;
+                    battle_flags->battle_state = BATTLE_FIGHT;
+                    meneghetti->player_state = PLAYER_ON_BATTLE;
                 }
-                SDL_RenderCopy(game.renderer, soul_shattered.texture, NULL, &soul.collision);
-            }
-            else {
-                game_reset(NULL, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, dialogue_cache, sound_cache);
-                open_world_fade.alpha = (Uint8)255;
-                open_world_fade.fading_in = true;
-                open_world_fade.timer = 0.0;
-
-                meneghetti.player_state = PLAYER_MOVABLE;
-                game.game_state = OPEN_WORLD_SCREEN;
-                game.player_on_scene = false;
+                else {
+                    battle_flags->battle_turn = CHOICE_TURN;
+                    battle_flags->battle_state = BATTLE_MENU;
+                    meneghetti->player_state = PLAYER_ON_BATTLE;
+                }
+                battle_flags->turn_counter++;
 
-                scenario.collision = (SDL_Rect){0, -SCREEN_HEIGHT, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2};
-                meneghetti.collision = (SDL_Rect){(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) - 16, 19, 32};
-                meneghetti.interact_collision = (SDL_Rect){(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) + 16, 19, 25};
-                meneghetti_civic.collision = (SDL_Rect){scenario.collision.x + scenario.collision.w, scenario.collision.y + 731, 64, 42};
+                eat_sound->has_played = false;
+            }
+            else {
+                if (!battle_flags->reading_text && meneghetti->inventory_counter > 0) {
+                    soul->collision.x = text_item->collision.x - soul->collision.w - 11;
+                    soul->collision.y = text_item->collision.y + 2;
+                    food_amount_text->collision.x = text_item->collision.x + text_item->collision.w + 5;
+                    food_amount_text->collision.y = text_item->collision.y;
+
+                    SDL_RenderCopy(game->renderer, soul->texture, NULL, &soul->collision);
+                    SDL_RenderCopy(game->renderer, text_item->texture, NULL, &text_item->collision);
+                    SDL_RenderCopy(game->renderer, food_amount_text->texture, NULL, &food_amount_text->collision);
+
+                    if (keys[SDL_SCANCODE_TAB] && meneghetti->input_timer >= INPUT_DELAY) {
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        battle_flags->battle_state = BATTLE_MENU;
+                        meneghetti->input_timer = 0.0;
+                    }
+                    if (keys[SDL_SCANCODE_E] && meneghetti->input_timer >= INPUT_DELAY) {
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        meneghetti->health += 20;
+                        battle_flags->reading_text = true;
+                        meneghetti->input_timer = 0.0;
+                    }
+                }
+                else {
+                    if (!eat_sound->has_played && meneghetti->inventory_counter > 0) {
+                        Mix_PlayChannel(SFX_CHANNEL, eat_sound->sound, 0);
+                        eat_sound->has_played = true;
+                    }
+                    if (meneghetti->inventory_counter > 0) {
+                        create_dialogue(meneghetti, game->renderer, dialogue_typewriter, picanha_txt, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
+                    }
+                    else {
+                        create_dialogue(meneghetti, game->renderer, dialogue_typewriter, no_food_txt, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
+                    }
+                }   
             }
         }
 
-        if (game.game_state == FINAL_SCREEN) {
-            if (end_scene_fade.alpha > 0) {
-                end_scene_fade.timer += dt;
-                end_scene_fade.alpha = 255 - (Uint8)((end_scene_fade.timer / 3.0) * 255);
-                if (end_scene_fade.timer >= 3.0) {
-                    end_scene_fade.alpha = 0;
+        if (battle_flags->battle_state == BATTLE_LEAVE) {
+            if (meneghetti->player_state == PLAYER_IDLE) {
+                battle_flags->battle_state = BATTLE_MENU;
+                meneghetti->player_state = PLAYER_ON_BATTLE;
+                battle_flags->reading_text = false;
+                meneghetti->input_timer = 0.0;
+                battle_flags->turn_counter++;
+                battle_flags->menu_position = (MenuPosition){1, 1};
+            }
+            else {
+                if (!battle_flags->reading_text) {
+                    if (battle_flags->menu_position.line > 2) battle_flags->menu_position.line = 1;
+                    if (battle_flags->menu_position.line < 1) battle_flags->menu_position.line = 2;
+
+                    switch(battle_flags->menu_position.line) {
+                        case 1:
+                            soul->collision.x = text_leave[0].collision.x - soul->collision.w - 11;
+                            soul->collision.y = text_leave[0].collision.y + 2;
+                            break;
+                        case 2:
+                            soul->collision.x = text_leave[1].collision.x - soul->collision.w - 11;
+                            soul->collision.y = text_leave[1].collision.y + 2;
+                            break;
+                        default:
+                            break;
+                    }
+
+                    SDL_RenderCopy(game->renderer, soul->texture, NULL, &soul->collision);
+                    SDL_RenderCopy(game->renderer, text_leave[0].texture, NULL, &text_leave[0].collision);
+                    SDL_RenderCopy(game->renderer, text_leave[1].texture, NULL, &text_leave[1].collision);
+
+                    if (keys[SDL_SCANCODE_TAB] && meneghetti->input_timer >= INPUT_DELAY) {
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        battle_flags->battle_state = BATTLE_MENU;
+                        meneghetti->input_timer = 0.0;
+                    }
+                    if (keys[SDL_SCANCODE_E] && meneghetti->input_timer >= INPUT_DELAY) {
+                        Mix_PlayChannel(DEFAULT_CHANNEL, click_button->sound, 0);
+                        battle_flags->reading_text = true;
+                        meneghetti->input_timer = 0.0;
+                    }
+                    if (keys[SDL_SCANCODE_S] && meneghetti->input_timer >= INPUT_DELAY) {
+                        Mix_PlayChannel(DEFAULT_CHANNEL, move_button->sound, 0);
+                        battle_flags->menu_position.line++;
+                        meneghetti->input_timer = 0.0;
+                    }
+                    if (keys[SDL_SCANCODE_W] && meneghetti->input_timer >= INPUT_DELAY) {
+                        Mix_PlayChannel(DEFAULT_CHANNEL, move_button->sound, 0);
+                        battle_flags->menu_position.line--;
+                        meneghetti->input_timer = 0.0;
+                    }
+                }
+                else {
+                    switch(battle_flags->menu_position.line) {
+                        case 1:
+                            create_dialogue(meneghetti, game->renderer, dialogue_typewriter, fight_spare_txt, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
+                            break;
+                        case 2:
+                            create_dialogue(meneghetti, game->renderer, dialogue_typewriter, fight_leave_txt, NULL, &meneghetti->player_state, &game->game_state, dt, NULL, dialogue_voices, false);
+                            break;
+                        default:
+                            break;
+                    }
                 }
             }
+        }
+        if (mr_python->health <= 0) {
+            mr_python->health = 0;
+            battle_flags->battle_state = BATTLE_MENU;
+            battle_flags->battle_turn = CHOICE_TURN;
+
+            mr_python->animation_status = ENEMY_HURT;
+            for (int i = 0; i < ENEMY_PARTS; i++) {
+                mr_python->collision[i].x = ((SCREEN_WIDTH / 2) - 102) + 4 * sin(game_timers->senoidal_timer * 40.0);
+            }
 
-            SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, 255);
-            SDL_RenderClear(game.renderer);
+            if (end_scene_fade->fading_in) {
+                end_scene_fade->timer += dt;
+                end_scene_fade->alpha = 0 + (Uint8)((end_scene_fade->timer / 5.0) * 255);
 
-            create_dialogue(&meneghetti, game.renderer, &end_dialogue, NULL, &meneghetti.player_state, &game.game_state, dt, dialogue_faces, dialogue_voices, false);
+                if (end_scene_fade->timer >= 5.0) {
+                    end_scene_fade->alpha = 255;
+                    end_scene_fade->fading_in = false;
+                }
+            }
+            else {
+                end_scene_fade->timer = 0.0;
+                battle_flags->enemy_dead = true;
+            }
 
-            if (end_scene_fade.alpha > 0) {
-                SDL_SetRenderDrawColor(game.renderer, 0, 0, 0, end_scene_fade.alpha);
-                SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
+            if (end_scene_fade->alpha < 255) {
+                SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, end_scene_fade->alpha);
+                SDL_SetRenderDrawBlendMode(game->renderer, SDL_BLENDMODE_BLEND);
 
                 SDL_Rect screen_fade = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-                SDL_RenderFillRect(game.renderer, &screen_fade);
+                SDL_RenderFillRect(game->renderer, &screen_fade);
             }
-            if (meneghetti.player_state == PLAYER_MOVABLE) {
-                game_reset(NULL, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, dialogue_cache, sound_cache);
-
-                open_world_fade.alpha = (Uint8)255;
-                open_world_fade.fading_in = true;
-                open_world_fade.timer = 0.0;
+        }
+    }
 
-                game.game_state = TITLE_SCREEN;
+    if (meneghetti->player_state == PLAYER_DEAD || battle_flags->enemy_dead) {
+        Mix_HaltChannel(MUSIC_CHANNEL);
 
-                scenario.collision = (SDL_Rect){0, -SCREEN_HEIGHT, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2};
-                meneghetti.collision = (SDL_Rect){(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) - 16, 19, 32};
-                meneghetti.interact_collision = (SDL_Rect){(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) + 16, 19, 25};
-                meneghetti_civic.collision = (SDL_Rect){scenario.collision.x + scenario.collision.w, scenario.collision.y + 731, 64, 42};
+        soul_animation->counter = 0;
+        slash_animation->counter = 0;
+        bar_attack->collision.x = bar_target->collision.x + 20;
 
-                SDL_RenderClear(game.renderer);
-            }
+        if (meneghetti->player_state == PLAYER_DEAD) {
+            game->game_state = DEATH_SCREEN;
+            meneghetti->death_count++;
+        }
+        else if (battle_flags->enemy_dead) {
+            game->game_state = FINAL_SCREEN;
+            end_scene_fade->timer = 0.0;
+            end_scene_fade->alpha = 255;
+            end_scene_fade->fading_in = true;
         }
+    }
+}
 
-        if (game.debug_mode) {
-            for (int i = 0; i < 6; i++) {
-                SDL_RenderCopy(game.renderer, debug_buttons[i].texture, NULL, &debug_buttons[i].collision);
-            }
+void battle_scene_enter(void *data) {
+    BattleScene *scene = data;
+    SDL_Renderer *render = scene->game->renderer;
 
-            if (keys[SDL_SCANCODE_1] && meneghetti.input_timer >= INPUT_DELAY) {
-                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, dialogue_cache, sound_cache);
-                meneghetti.input_timer = 0.0;
-            }
-            if (keys[SDL_SCANCODE_2] && meneghetti.input_timer >= INPUT_DELAY) {
-                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, dialogue_cache, sound_cache);
-                meneghetti.input_timer = 0.0;
+    const char *python_files[8] = {
+        "assets/sprites/battle/python-1.png", "assets/sprites/battle/python-2.png",
+        "assets/sprites/battle/python-baby-1.png", "assets/sprites/battle/python-baby-2.png",
+        "assets/sprites/battle/python-barrier-left-1.png", "assets/sprites/battle/python-barrier-left-2.png",
+        "assets/sprites/battle/python-barrier-right-1.png", "assets/sprites/battle/python-barrier-right-2.png"
+    };
+    for (int i = 0; i < 8; i++) {
+        scene->python_frames[i] = create_texture(render, python_files[i]);
+    }
+    scene->python_mother_animation = (Animation){.frames = &scene->python_frames[0], .count = 2};
+    scene->python_baby_animation = (Animation){.frames = &scene->python_frames[2], .count = 2};
 
-                game.game_state = TITLE_SCREEN;
-            }
-            if (keys[SDL_SCANCODE_3] && meneghetti.input_timer >= INPUT_DELAY) {
-                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, dialogue_cache, sound_cache);
-                meneghetti.input_timer = 0.0;
+    const char *command_files[6] = {"if", "else", "elif", "input", "print", "in"};
+    const char *enclosure_files[6] = {"brackets-1", "brackets-2", "key-1", "key-2", "parenthesis-1", "parenthesis-2"};
+    char path[64];
+    int attack_widths, attack_heights;
+    for (int i = 0; i < 6; i++) {
+        snprintf(path, sizeof(path), "assets/sprites/battle/%s.png", command_files[i]);
+        scene->command_rain[i] = (Projectile){.texture = create_texture(render, path)};
+        SDL_QueryTexture(scene->command_rain[i].texture, NULL, NULL, &attack_widths, &attack_heights);
+        scene->command_rain[i].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
+
+        snprintf(path, sizeof(path), "assets/sprites/battle/%s.png", enclosure_files[i]);
+        scene->parenthesis_enclosure[i] = (Projectile){.texture = create_texture(render, path)};
+        SDL_QueryTexture(scene->parenthesis_enclosure[i].texture, NULL, NULL, &attack_widths, &attack_heights);
+        scene->parenthesis_enclosure[i].collision = (SDL_FRect){0, 0, attack_widths, attack_heights * 2};
+    }
 
-                game.game_state = OPEN_WORLD_SCREEN;
-                game.player_on_scene = false;
-                meneghetti.player_state = PLAYER_MOVABLE;
-            }
-            if (keys[SDL_SCANCODE_4] && meneghetti.input_timer >= INPUT_DELAY) {
-                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, dialogue_cache, sound_cache);
-                meneghetti.input_timer = 0.0;
+    Projectile *python_mother = scene->python_mother;
+    Projectile *python_barrier = scene->python_barrier;
+    python_mother[0] = (Projectile){.texture = scene->python_frames[0]};
+    python_mother[1] = (Projectile){.texture = scene->python_frames[1]};
+    python_mother[2] = (Projectile){.texture = scene->python_frames[2], .animation = scene->python_baby_animation};
+    python_barrier[0] = (Projectile){.texture = scene->python_frames[4], .animation = {.frames = &scene->python_frames[4], .count = 2}};
+    python_barrier[1] = (Projectile){.texture = scene->python_frames[7], .animation = {.frames = &scene->python_frames[6], .count = 2}};
+    for (int i = 0; i < 3; i++) {
+        SDL_QueryTexture(python_mother[i].texture, NULL, NULL, &attack_widths, &attack_heights);
+        python_mother[i].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
+    }
+    for (int i = 0; i < 2; i++) {
+        SDL_QueryTexture(python_barrier[i].texture, NULL, NULL, &attack_widths, &attack_heights);
+        python_barrier[i].collision = (SDL_FRect){0, 0, attack_widths, attack_heights};
+    }
 
-                game.game_state = BATTLE_SCREEN;
-            }
-            if (keys[SDL_SCANCODE_5] && meneghetti.input_timer >= INPUT_DELAY) {
-                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, dialogue_cache, sound_cache);
-                meneghetti.input_timer = 0.0;
+    scene->python_props[0] = scene->command_rain;
+    scene->python_props[1] = scene->parenthesis_enclosure;
+    scene->python_props[2] = python_mother;
+    scene->python_props[3] = python_barrier;
+
+    // Golpe fora do alvo: o número dá lugar ao sprite de erro.
+    scene->damage = (Prop){.texture = create_texture(render, "assets/sprites/battle/miss.png")};
+
+    scene->battle_music = (Sound){.sound = create_chunk("assets/sounds/soundtracks/battle_against_abstraction.wav", MUSIC_VOLUME), .has_played = false};
+    scene->battle_appears = (Sound){.sound = create_chunk("assets/sounds/sound_effects/battle-sounds/battle_appears.wav", SFX_VOLUME), .has_played = false};
+    scene->move_button = (Sound){.sound = create_chunk("assets/sounds/sound_effects/battle-sounds/move_selection.wav", SFX_VOLUME), .has_played = false};
+    scene->click_button = (Sound){.sound = create_chunk("assets/sounds/sound_effects/battle-sounds/select_sound.wav", SFX_VOLUME), .has_played = false};
+    scene->slash_sound = (Sound){.sound = create_chunk("assets/sounds/sound_effects/battle-sounds/slash.wav", SFX_VOLUME), .has_played = false};
+    scene->enemy_hit_sound = (Sound){.sound = create_chunk("assets/sounds/sound_effects/battle-sounds/enemy_hit.wav", SFX_VOLUME), .has_played = false};
+    scene->eat_sound = (Sound){.sound = create_chunk("assets/sounds/sound_effects/battle-sounds/heal_sound.wav", SFX_VOLUME), .has_played = false};
+
+    const char *battle_sound_files[5] = {"damage_taken", "object_appears", "python_ejects", "slam", "strike_sound"};
+    for (int i = 0; i < 5; i++) {
+        snprintf(path, sizeof(path), "assets/sounds/sound_effects/battle-sounds/%s.wav", battle_sound_files[i]);
+        scene->battle_sounds[i] = (Sound){.sound = create_chunk(path, SFX_VOLUME), .has_played = false};
+    }
+}
 
-                game.game_state = DEATH_SCREEN;
-            }
-            if (keys[SDL_SCANCODE_6] && meneghetti.input_timer >= INPUT_DELAY) {
-                game_reset(&game, &game_timers, &battle_flags, &battle_box, &soul, &meneghetti, enemy_cache, npc_cache, dialogue_cache, sound_cache);
-                meneghetti.input_timer = 0.0;
+void battle_scene_exit(void *data) {
+    BattleScene *scene = data;
 
-                game.game_state = FINAL_SCREEN;
-            }
-        }
+    // O HUD em cache pode ter ficado com a vida ou a caixa da batalha que acabou.
+    scene->battle_hud->valid = false;
 
-        SDL_RenderPresent(game.renderer);
+    // Os ataques guardam cópias dos projéteis; esquecê-las antes de liberar as texturas.
+    python_attacks(scene->game->renderer, scene->soul, *scene->battle_box, &scene->meneghetti->health, scene->mr_python->strength, 0, scene->python_props, 0.0, 0.0, scene->game_timers->turn_timer, scene->battle_sounds, true);
 
-        SDL_Delay(1);
+    for (int i = 0; i < 8; i++) {
+        release_texture(scene->python_frames[i]);
+        scene->python_frames[i] = NULL;
     }
+    for (int i = 0; i < 6; i++) {
+        release_texture(scene->command_rain[i].texture);
+        release_texture(scene->parenthesis_enclosure[i].texture);
+        scene->command_rain[i].texture = scene->parenthesis_enclosure[i].texture = NULL;
+    }
+    release_texture(scene->damage.texture);
+    scene->damage.texture = NULL;
 
-    for (int i = 0; i < DIRECTION_AMOUNT; i++) {
-        free(anim_pack[i].frames);
-        free(anim_pack_reflex[i].frames);
-        free(mr_python_animation[i].frames);
+    Sound *sounds[] = {
+        &scene->battle_music, &scene->battle_appears, &scene->move_button, &scene->click_button,
+        &scene->slash_sound, &scene->enemy_hit_sound, &scene->eat_sound, &scene->battle_sounds[0],
+        &scene->battle_sounds[1], &scene->battle_sounds[2], &scene->battle_sounds[3], &scene->battle_sounds[4]
+    };
+    for (int i = 0; i < (int)(sizeof(sounds) / sizeof(sounds[0])); i++) {
+        release_chunk(sounds[i]->sound);
+        sounds[i]->sound = NULL;
     }
-    for (int i = 0; i < 4; i++) {
-        free(dialogue_faces[i].frames);
+}
+
+void death_scene_frame(void *data, double dt, const Uint8 *keys) {
+    DeathScene *scene = data;
+    Game *game = scene->game;
+    FadeState *open_world_fade = scene->open_world_fade;
+    Player *meneghetti = scene->meneghetti;
+    Soul *soul = scene->soul;
+    Prop *scenario = scene->scenario;
+    Prop *meneghetti_civic = scene->meneghetti_civic;
+    Prop *soul_shattered = &scene->soul_shattered;
+    int soul_shards = scene->soul_shards;
+    Sound *soul_break_sound = &scene->soul_break_sound;
+    Enemy **enemy_cache = scene->enemy_cache;
+    NPC **npc_cache = scene->npc_cache;
+    Typewriter **typewriter_cache = scene->typewriter_cache;
+    Sound **sound_cache = scene->sound_cache;
+    BattleBox *battle_box = scene->battle_box;
+    BattleState *battle_flags = scene->battle_flags;
+    GameTimers *game_timers = scene->game_timers;
+    (void)keys;
+
+    game_timers->death_timer += dt;
+
+    SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(game->renderer);
+
+    if (game_timers->death_timer <= 2.0) {
+        if (!soul_break_sound->has_played) {
+            Mix_PlayChannel(SFX_CHANNEL, soul_break_sound->sound, 0);
+            soul_break_sound->has_played = true;
+            emit_particles(&particle_system, soul_shards, soul->collision.x + soul->collision.w / 2.0f, soul->collision.y + soul->collision.h / 2.0f, 0);
+        }
+        SDL_RenderCopy(game->renderer, soul_shattered->texture, NULL, &soul->collision);
+        schedule_frame_wake(2.0 - game_timers->death_timer + 0.001);
+    }
+    else {
+        game_reset(NULL, game_timers, battle_flags, battle_box, soul, meneghetti, enemy_cache, npc_cache, typewriter_cache, sound_cache);
+        open_world_fade->alpha = (Uint8)255;
+        open_world_fade->fading_in = true;
+        open_world_fade->timer = 0.0;
+
+        meneghetti->player_state = PLAYER_MOVABLE;
+        game->game_state = OPEN_WORLD_SCREEN;
+        game->player_on_scene = false;
+
+        scenario->collision = (SDL_Rect){0, -SCREEN_HEIGHT, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2};
+        meneghetti->collision = (SDL_Rect){(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) - 16, 19, 32};
+        meneghetti->interact_collision = (SDL_Rect){(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) + 16, 19, 25};
+        meneghetti_civic->collision = (SDL_Rect){scenario->collision.x + scenario->collision.w, scenario->collision.y + 731, 64, 42};
     }
+}
 
-    game_cleanup(&game, EXIT_SUCCESS);
-    return 0;
+void death_scene_enter(void *data) {
+    DeathScene *scene = data;
+
+    scene->soul_shattered = (Prop){.texture = create_texture(scene->game->renderer, "assets/sprites/battle/soul-broken.png")};
+    scene->soul_break_sound = (Sound){.sound = create_chunk("assets/sounds/sound_effects/battle-sounds/soul_shatter.wav", SFX_VOLUME), .has_played = false};
+}
+
+void death_scene_exit(void *data) {
+    DeathScene *scene = data;
+
+    release_texture(scene->soul_shattered.texture);
+    scene->soul_shattered.texture = NULL;
+    release_chunk(scene->soul_break_sound.sound);
+    scene->soul_break_sound.sound = NULL;
+}
+
+void final_scene_frame(void *data, double dt, const Uint8 *keys) {
+    FinalScene *scene = data;
+    Game *game = scene->game;
+    FadeState *open_world_fade = scene->open_world_fade;
+    FadeState *end_scene_fade = scene->end_scene_fade;
+    Animation *dialogue_faces = scene->dialogue_faces;
+    Player *meneghetti = scene->meneghetti;
+    Soul *soul = scene->soul;
+    Prop *scenario = scene->scenario;
+    Prop *meneghetti_civic = scene->meneghetti_civic;
+    Sound *dialogue_voices = scene->dialogue_voices;
+    Dialogue *end_dialogue = &scene->end_dialogue;
+    Typewriter *dialogue_typewriter = scene->dialogue_typewriter;
+    Enemy **enemy_cache = scene->enemy_cache;
+    NPC **npc_cache = scene->npc_cache;
+    Typewriter **typewriter_cache = scene->typewriter_cache;
+    Sound **sound_cache = scene->sound_cache;
+    BattleBox *battle_box = scene->battle_box;
+    BattleState *battle_flags = scene->battle_flags;
+    GameTimers *game_timers = scene->game_timers;
+    (void)keys;
+
+    if (end_scene_fade->alpha > 0) {
+        mark_frame_dirty();
+        end_scene_fade->timer += dt;
+        end_scene_fade->alpha = 255 - (Uint8)((end_scene_fade->timer / 3.0) * 255);
+        if (end_scene_fade->timer >= 3.0) {
+            end_scene_fade->alpha = 0;
+        }
+    }
+
+    SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(game->renderer);
+
+    create_dialogue(meneghetti, game->renderer, dialogue_typewriter, end_dialogue, NULL, &meneghetti->player_state, &game->game_state, dt, dialogue_faces, dialogue_voices, false);
+
+    if (end_scene_fade->alpha > 0) {
+        SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, end_scene_fade->alpha);
+        SDL_SetRenderDrawBlendMode(game->renderer, SDL_BLENDMODE_BLEND);
+
+        SDL_Rect screen_fade = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+        SDL_RenderFillRect(game->renderer, &screen_fade);
+    }
+    if (meneghetti->player_state == PLAYER_MOVABLE) {
+        game_reset(NULL, game_timers, battle_flags, battle_box, soul, meneghetti, enemy_cache, npc_cache, typewriter_cache, sound_cache);
+
+        open_world_fade->alpha = (Uint8)255;
+        open_world_fade->fading_in = true;
+        open_world_fade->timer = 0.0;
+
+        game->game_state = TITLE_SCREEN;
+
+        scenario->collision = (SDL_Rect){0, -SCREEN_HEIGHT, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2};
+        meneghetti->collision = (SDL_Rect){(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) - 16, 19, 32};
+        meneghetti->interact_collision = (SDL_Rect){(SCREEN_WIDTH / 2) - 10, (SCREEN_HEIGHT / 2) + 16, 19, 25};
+        meneghetti_civic->collision = (SDL_Rect){scenario->collision.x + scenario->collision.w, scenario->collision.y + 731, 64, 42};
+
+        SDL_RenderClear(game->renderer);
+    }
 }
 
 bool sdl_initialize(Game *game) {
@@ -2896,12 +3941,40 @@ bool sdl_initialize(Game *game) {
         return true;
     }
 
-    game->renderer = SDL_CreateRenderer(game->window, -1, RENDERER_FLAGS);
+    // O backend calibrado pode ser o software, que não aceita SDL_RENDERER_ACCELERATED.
+    int renderer_index = choose_render_driver(game->window, game->calibrate);
+    Uint32 renderer_flags = RENDERER_FLAGS;
+    SDL_RendererInfo driver_info;
+    if (renderer_index >= 0 && SDL_GetRenderDriverInfo(renderer_index, &driver_info) == 0 && !(driver_info.flags & SDL_RENDERER_ACCELERATED)) {
+        renderer_flags &= ~SDL_RENDERER_ACCELERATED;
+    }
+    if (game->pacer.mode == PACER_VSYNC) renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+
+    game->renderer = SDL_CreateRenderer(game->window, renderer_index, renderer_flags);
+    if (!game->renderer && renderer_index >= 0) {
+        fprintf(stderr, "Warning: calibrated renderer unavailable (%s), using default.\n", SDL_GetError());
+        renderer_flags = RENDERER_FLAGS | (game->pacer.mode == PACER_VSYNC ? SDL_RENDERER_PRESENTVSYNC : 0);
+        game->renderer = SDL_CreateRenderer(game->window, -1, renderer_flags);
+    }
     if (!game->renderer) {
         fprintf(stderr, "Error creating renderer: %s\n", SDL_GetError());
         return true;
     }
-    SDL_RenderSetLogicalSize(game->renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    // Sem vsync disponível o ritmo cai para o limite fixo padrão.
+    SDL_RendererInfo renderer_info;
+    if (game->pacer.mode == PACER_VSYNC && (SDL_GetRendererInfo(game->renderer, &renderer_info) || !(renderer_info.flags & SDL_RENDERER_PRESENTVSYNC))) {
+        fprintf(stderr, "Warning: vsync unavailable, capping at %.0f FPS.\n", DEFAULT_FPS_CAP);
+        pacer_init(&game->pacer, PACER_FIXED, DEFAULT_FPS_CAP);
+    }
+
+    // Sem render targets, o SDL escala cada desenho para a janela como antes.
+    bool pipeline = create_render_pipeline(game->renderer, pacer_budget(&game->pacer, game->window));
+    render_stats_set_frame_target(render_pipeline.scene, SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!pipeline) {
+        SDL_RenderSetLogicalSize(game->renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+        SDL_RenderSetIntegerScale(game->renderer, SDL_TRUE);
+    }
 
     SDL_Surface* icon = SDL_LoadBMP("assets/sprites/hud/icon.bmp");
     if(!icon) {
@@ -2914,7 +3987,51 @@ bool sdl_initialize(Game *game) {
     return false;
 }
 
-void game_reset(Game *game, GameTimers *timers, BattleState *battle, BattleBox *battle_box, Soul *soul, Player *player, Enemy *enemies[], NPC *npcs[], Dialogue *dialogues[], Sound *sounds[]) {
+bool parse_arguments(int argc, char *argv[], Game *game) {
+    FramePacer *pacer = &game->pacer;
+    game->cpu_compositor = false;
+    game->calibrate = false;
+    game->capture_format = CAPTURE_PNG;
+    pacer_init(pacer, PACER_VSYNC, DEFAULT_FPS_CAP);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--vsync") == 0) {
+            pacer_init(pacer, PACER_VSYNC, DEFAULT_FPS_CAP);
+        }
+        else if (strcmp(argv[i], "--uncapped") == 0) {
+            pacer_init(pacer, PACER_UNCAPPED, 0.0);
+        }
+        else if (strcmp(argv[i], "--cpu-compositor") == 0) {
+            game->cpu_compositor = true;
+        }
+        else if (strcmp(argv[i], "--calibrate") == 0) {
+            game->calibrate = true;
+        }
+        else if (strcmp(argv[i], "--capture=png") == 0) {
+            game->capture_format = CAPTURE_PNG;
+        }
+        else if (strcmp(argv[i], "--capture=y4m") == 0) {
+            game->capture_format = CAPTURE_Y4M;
+        }
+        else if (strncmp(argv[i], "--fps=", 6) == 0) {
+            char *end = NULL;
+            double fps = strtod(argv[i] + 6, &end);
+            if (end == argv[i] + 6 || *end != '\0' || fps < 1.0) {
+                fprintf(stderr, "Invalid frame cap: %s\n", argv[i]);
+                return true;
+            }
+            pacer_init(pacer, PACER_FIXED, fps);
+        }
+        else {
+            fprintf(stderr, "Unknown option: %s\nUsage: %s [--vsync | --fps=N | --uncapped] [--cpu-compositor] [--calibrate] [--capture=png|y4m]\n", argv[i], argv[0]);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void game_reset(Game *game, GameTimers *timers, BattleState *battle, BattleBox *battle_box, Soul *soul, Player *player, Enemy *enemies[], NPC *npcs[], Typewriter *typewriters[], Sound *sounds[]) {
     Mix_HaltChannel(-1);
 
     if (game) {
@@ -2943,6 +4060,7 @@ void game_reset(Game *game, GameTimers *timers, BattleState *battle, BattleBox *
         battle->reading_text = false;
         battle->selected_button = BUTTON_FIGHT;
         battle->turn_counter = 0;
+        battle->attack_damage = 0;
     }
 
     if (battle_box) {
@@ -2989,9 +4107,9 @@ void game_reset(Game *game, GameTimers *timers, BattleState *battle, BattleBox *
         }
     }
 
-    if (dialogues) {
-        for (int i = 0; i < DIALOGUE_AMOUNT; i++) {
-            reset_dialogue(dialogues[i]);
+    if (typewriters) {
+        for (int i = 0; i < TYPEWRITER_AMOUNT; i++) {
+            reset_typewriter(typewriters[i]);
         }
     }
 
@@ -3009,14 +4127,18 @@ SDL_Texture* create_texture(SDL_Renderer *render, const char *dir) {
         return NULL;
     }
 
+    SDL_Texture *texture = texture_from_surface(render, surface);
+    SDL_FreeSurface(surface);
+    return texture;
+}
+
+SDL_Texture *texture_from_surface(SDL_Renderer *render, SDL_Surface *surface) {
     SDL_Texture *texture = SDL_CreateTextureFromSurface(render, surface);
     if (!texture) {
         fprintf(stderr, "Error creating texture: %s", SDL_GetError());
-        SDL_FreeSurface(surface);
         return NULL;
     }
 
-    SDL_FreeSurface(surface);
     track_texture(texture);
     return texture;
 }
@@ -3067,25 +4189,244 @@ SDL_Texture* create_text(SDL_Renderer *render, const char *utf8_text, TTF_Font *
     return texture;
 }
 
-void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *npc, int *player_state, int *game_state, double dt, Animation *dialogue_faces, Sound *sound, Prop *bubble_speech) {
+bool create_number_font(SDL_Renderer *render, NumberFont *number_font, const char *digit_pattern, int spacing) {
+    memset(number_font, 0, sizeof(*number_font));
+    number_font->spacing = spacing;
+
+    for (int i = 0; i < 10; i++) {
+        char dir[256];
+        snprintf(dir, sizeof(dir), digit_pattern, i);
+
+        number_font->glyphs[i] = create_texture(render, dir);
+        if (!number_font->glyphs[i]) {
+            return false;
+        }
+
+        int h;
+        SDL_QueryTexture(number_font->glyphs[i], NULL, NULL, &number_font->widths[i], &h);
+        if (h > number_font->height) number_font->height = h;
+    }
+
+    return true;
+}
+
+bool bake_number_font(SDL_Renderer *render, NumberFont *number_font, TTF_Font *font, SDL_Color color) {
+    const char *characters = "0123456789/";
+
+    memset(number_font, 0, sizeof(*number_font));
+    for (int i = 0; i < NUMBER_FONT_GLYPHS; i++) {
+        char glyph[2] = {characters[i], '\0'};
+
+        number_font->glyphs[i] = create_text(render, glyph, font, color);
+        if (!number_font->glyphs[i]) {
+            return false;
+        }
+
+        int h;
+        SDL_QueryTexture(number_font->glyphs[i], NULL, NULL, &number_font->widths[i], &h);
+        if (h > number_font->height) number_font->height = h;
+    }
+
+    return true;
+}
+
+bool create_background_cache(SDL_Renderer *render, BackgroundCache *cache) {
+    memset(cache, 0, sizeof(*cache));
+
+    if (!SDL_RenderTargetSupported(render)) {
+        return false;
+    }
+
+    cache->target = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!cache->target) {
+        fprintf(stderr, "Error creating background target: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // O cache é opaco (fundo preto como o clear da tela), então é copiado sem blending.
+    SDL_SetTextureBlendMode(cache->target, SDL_BLENDMODE_NONE);
+    track_texture(cache->target);
+    return true;
+}
+
+SDL_Texture *compose_background_cache(SDL_Renderer *render, BackgroundCache *cache, SDL_Texture *textures[], const SDL_Rect srcs[], const SDL_Rect rects[], int count) {
+    if (!cache->target || count > BACKGROUND_CACHE_PIECES) return NULL;
+
+    bool stale = !cache->valid || cache->count != count;
+    for (int i = 0; i < count && !stale; i++) {
+        const SDL_Rect *a = &cache->rects[i];
+        const SDL_Rect *b = &rects[i];
+        const SDL_Rect *sa = &cache->srcs[i];
+        const SDL_Rect *sb = &srcs[i];
+        if (cache->textures[i] != textures[i] || a->x != b->x || a->y != b->y || a->w != b->w || a->h != b->h ||
+            sa->x != sb->x || sa->y != sb->y || sa->w != sb->w || sa->h != sb->h) {
+            stale = true;
+        }
+    }
+    if (!stale) return cache->target;
+
+    SDL_Texture *previous = SDL_GetRenderTarget(render);
+    if (SDL_SetRenderTarget(render, cache->target) != 0) {
+        fprintf(stderr, "Error binding background target: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    SDL_SetRenderDrawColor(render, 0, 0, 0, 255);
+    SDL_RenderClear(render);
+    for (int i = 0; i < count; i++) {
+        if (textures[i]) {
+            SDL_Rect src = srcs[i];
+            bool has_src = true;
+            SDL_FRect dst = {rects[i].x, rects[i].y, rects[i].w, rects[i].h};
+            if (clip_to_view(textures[i], &src, &has_src, &dst, SDL_FLIP_NONE)) {
+                SDL_RenderCopyF(render, textures[i], has_src ? &src : NULL, &dst);
+            }
+        }
+        cache->textures[i] = textures[i];
+        cache->srcs[i] = srcs[i];
+        cache->rects[i] = rects[i];
+    }
+    cache->count = count;
+    cache->valid = true;
+
+    SDL_SetRenderTarget(render, previous);
+    return cache->target;
+}
+
+bool create_battle_hud(SDL_Renderer *render, BattleHudCache *hud) {
+    memset(hud, 0, sizeof(*hud));
+
+    if (!SDL_RenderTargetSupported(render)) {
+        return false;
+    }
+
+    hud->target = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!hud->target) {
+        fprintf(stderr, "Error creating HUD target: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // Montado sobre transparente: as cores saem pré-multiplicadas e a cópia respeita isso.
+    SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                                             SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    if (SDL_SetTextureBlendMode(hud->target, premultiplied) != 0) {
+        SDL_SetTextureBlendMode(hud->target, SDL_BLENDMODE_BLEND);
+    }
+    track_texture(hud->target);
+    return true;
+}
+
+bool battle_hud_current(const BattleHudCache *hud, const SDL_Rect *box, int health, SDL_Texture *buttons[BATTLE_BUTTONS]) {
+    if (!hud->target || !hud->valid || hud->health != health) return false;
+    if (hud->box.x != box->x || hud->box.y != box->y || hud->box.w != box->w || hud->box.h != box->h) return false;
+
+    for (int i = 0; i < BATTLE_BUTTONS; i++) {
+        if (hud->buttons[i] != buttons[i]) return false;
+    }
+
+    return true;
+}
+
+bool begin_battle_hud(SDL_Renderer *render, BattleHudCache *hud, const SDL_Rect *box, int health, SDL_Texture *buttons[BATTLE_BUTTONS], const SDL_Rect *bounds) {
+    if (!hud->target) return false;
+
+    // O que já estava na fila pertence à tela, não ao HUD.
+    flush_render_queue(render);
+
+    hud->valid = false;
+    hud->previous = SDL_GetRenderTarget(render);
+    if (SDL_SetRenderTarget(render, hud->target) != 0) {
+        fprintf(stderr, "Error binding HUD target: %s\n", SDL_GetError());
+        return false;
+    }
+
+    Uint8 old_r, old_g, old_b, old_a;
+    SDL_GetRenderDrawColor(render, &old_r, &old_g, &old_b, &old_a);
+    SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
+    SDL_RenderClear(render);
+    SDL_SetRenderDrawColor(render, old_r, old_g, old_b, old_a);
+
+    hud->box = *box;
+    hud->health = health;
+    hud->bounds = *bounds;
+    for (int i = 0; i < BATTLE_BUTTONS; i++) {
+        hud->buttons[i] = buttons[i];
+    }
+
+    return true;
+}
+
+void end_battle_hud(SDL_Renderer *render, BattleHudCache *hud) {
+    SDL_SetRenderTarget(render, hud->previous);
+    hud->valid = true;
+}
+
+static int number_glyph_index(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c == '/') return 10;
+
+    return -1;
+}
+
+int number_text_width(const NumberFont *number_font, const char *digits) {
+    int width = 0;
+    for (const char *c = digits; *c != '\0'; c++) {
+        int index = number_glyph_index(*c);
+        if (index < 0 || !number_font->glyphs[index]) continue;
+
+        if (width > 0) width += number_font->spacing;
+        width += number_font->widths[index];
+    }
+
+    return width;
+}
+
+int render_number(SDL_Renderer *render, const NumberFont *number_font, const char *digits, int x, int y) {
+    int start_x = x;
+    for (const char *c = digits; *c != '\0'; c++) {
+        int index = number_glyph_index(*c);
+        if (index < 0 || !number_font->glyphs[index]) continue;
+
+        if (x > start_x) x += number_font->spacing;
+
+        // Dígitos mais baixos que a fonte ficam alinhados pela base.
+        int h;
+        SDL_QueryTexture(number_font->glyphs[index], NULL, NULL, NULL, &h);
+        SDL_Rect dst = {x, y + number_font->height - h, number_font->widths[index], h};
+        SDL_RenderCopy(render, number_font->glyphs[index], NULL, &dst);
+        x += number_font->widths[index];
+    }
+
+    return x - start_x;
+}
+
+void create_dialogue(Player *player, SDL_Renderer *render, Typewriter *tw, const Dialogue *text, NPC *npc, int *player_state, int *game_state, double dt, Animation *dialogue_faces, Sound *sound, Prop *bubble_speech) {
+    if (!tw || !text || !text->scripts) return;
+
+    // O runtime é compartilhado: ao trocar de diálogo, recomeça do início.
+    if (tw->dialogue != text) {
+        reset_typewriter(tw);
+        tw->dialogue = text;
+        start_typewriter_line(tw, text);
+    }
+
     const Uint8 *keys = player->keystate ? player->keystate : SDL_GetKeyboardState(NULL);
     
     bool has_faces = (dialogue_faces != NULL);
-    bool bubble;
+    bool bubble = (bubble_speech != NULL);
     
     double anim_cooldown = 0.2;
 
-    static bool prev_e_pressed = false;
     player->dialogue_input_timer += dt;
     bool e_now = keys[SDL_SCANCODE_E];
     
     bool e_pressed = false;
-    if (e_now && !prev_e_pressed && player->dialogue_input_timer >= INPUT_DELAY) {
+    if (e_now && !tw->prev_e_pressed && player->dialogue_input_timer >= INPUT_DELAY) {
         e_pressed = true;
         player->dialogue_input_timer = 0.0;
     }
 
-    prev_e_pressed = e_now;
+    tw->prev_e_pressed = e_now;
     
     int text_amount = 0;
     for (int i = 0; i < MAX_DIALOGUE_STR; i++) {
@@ -3094,46 +4435,14 @@ void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *
     }
     const double timer_delay = 0.04;
     
-    SDL_Rect dialogue_box = {0, 0, 0, 0};
-    if (bubble_speech) {
+    SDL_Rect dialogue_box = dialogue_box_rect(*game_state, player, bubble_speech);
+    if (bubble) {
         bubble_speech->collision = dialogue_box;
-        bubble = true;
     }
-    else {
-        bubble = false;
-    }
-    switch(*game_state) {
-        case CUTSCENE_SCREEN:
-            dialogue_box = (SDL_Rect){20, SCREEN_HEIGHT - 200, SCREEN_WIDTH - 40, 180};
-            break;
-        case OPEN_WORLD_SCREEN:
-            if (player->collision.y + player->collision.h < SCREEN_HEIGHT / 2) {
-                dialogue_box = (SDL_Rect){25, SCREEN_HEIGHT - 175, SCREEN_WIDTH - 50, 150};
-            }
-            else {
-                dialogue_box = (SDL_Rect){25, 25, SCREEN_WIDTH - 50, 150};
-            }
-            break;
-        case BATTLE_SCREEN:
-            if (bubble) {
-                int w, h;
-                SDL_QueryTexture(bubble_speech->texture, NULL, NULL, &w, &h);
-                dialogue_box = (SDL_Rect){380, 40, w * 1.5, h * 1.5};
-            }
-            else {
-                dialogue_box = (SDL_Rect){20, SCREEN_HEIGHT / 2, SCREEN_WIDTH - 40, 132};
-            }
-            break;
-        case FINAL_SCREEN:
-            dialogue_box = (SDL_Rect){25, SCREEN_HEIGHT - 175, SCREEN_WIDTH - 50, 150};
-            break;
-        default:
-            break;
-    }
-
-    if (*game_state != BATTLE_SCREEN) {
-        SDL_SetRenderDrawColor(render, 0, 0, 0, 255);
-        SDL_RenderFillRect(render, &dialogue_box);
+
+    if (*game_state != BATTLE_SCREEN) {
+        SDL_SetRenderDrawColor(render, 0, 0, 0, 255);
+        SDL_RenderFillRect(render, &dialogue_box);
     }
     if (bubble) {
         SDL_RenderCopy(render, bubble_speech->texture, NULL, &dialogue_box);
@@ -3150,105 +4459,101 @@ void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *
     SDL_Rect python_frame = {dialogue_box.x + 27, dialogue_box.y + 27, 96, 96};
     SDL_Rect gpt_frame = {dialogue_box.x + 27, dialogue_box.y + 27, 80, 96};
 
-    if (text->on_frame[text->cur_str] != FACE_NONE && text->on_frame[text->cur_str] != FACE_BUBBLE) {
-        text->text_box.x = dialogue_box.x + 130;
-        text->text_box.y = dialogue_box.y + 27;
+    // A área segue o rosto exibido, que uma tag {f=...} pode trocar no meio da fala.
+    SDL_Rect text_area = dialogue_text_area(dialogue_box, *game_state, tw->speaker, bubble);
+    tw->text_box.x = text_area.x;
+    tw->text_box.y = text_area.y;
+
+    // A linha atual normalmente já foi preparada no quadro anterior; só é rasterizada aqui se não houver pré-carga.
+    DialogueLine *line = &tw->lines[tw->front_line];
+    if (!line->ready || line->source_str != tw->cur_str) {
+        prepare_dialogue_line(render, text, line, tw->cur_str, text_area, -1);
     }
-    else {
-        if (bubble) {
-            text->text_box.x = dialogue_box.x + 35;
-            text->text_box.y = dialogue_box.y + 5;
-        }
-        else {
-            text->text_box.x = dialogue_box.x + 27;
-            text->text_box.y = dialogue_box.y + 27;
-        }
+    else if (line->wrap_w != text_area.w || line->wrap_h != text_area.h) {
+        layout_dialogue_line(line, text_area, text->text_font ? TTF_FontHeight(text->text_font) : 16);
     }
 
-    static double sfx_timer = 0.0;
     const double sfx_cooldown = 0.03;
-    sfx_timer += dt;
+    tw->sfx_timer += dt;
 
-    if (!text->waiting_for_input) {
+    if (!tw->waiting_for_input) {
+        mark_frame_dirty();
         if (has_faces) dialogue_faces->timer += dt;
-        text->timer += dt;
+        tw->timer += dt;
+        const TextScript *script = &text->scripts[tw->cur_str];
+
         if (e_pressed && *game_state != BATTLE_SCREEN && !bubble) {
-            const char *current = text->writings[text->cur_str];
-            while (current[text->cur_byte] != '\0' && text->char_count < MAX_DIALOGUE_CHAR) {
-                char utf8_buffer[5];
-                int n = utf8_copy_char(&current[text->cur_byte], utf8_buffer);
-                SDL_Texture* t = create_text(render, utf8_buffer, text->text_font, text->text_color);
-                if (t) {
-                    text->chars[text->char_count] = t;
-                    strcpy(text->chars_string[text->char_count], utf8_buffer);
-                    text->char_count++;
+            // Pula a digitação: executa as operações restantes sem pausas.
+            while (tw->char_count < line->fit_count && tw->op_cursor < script->count) {
+                run_text_ops(tw, script);
+                if (tw->op_cursor < script->count && script->ops[tw->op_cursor].type <= TEXT_OP_NEWLINE) {
+                    tw->op_cursor++;
+                    tw->char_count++;
                 }
-                text->cur_byte += n;
             }
-            if(!bubble) text->waiting_for_input = true;
+            tw->pause_timer = 0.0;
+            tw->char_count = line->fit_count;
+            tw->waiting_for_input = true;
+        }
+        else if (tw->pause_timer > 0.0) {
+            tw->pause_timer -= dt;
+            tw->timer = 0.0;
         }
-        else if (text->timer >= timer_delay) {
-            text->timer = 0.0;
-            const char *current = text->writings[text->cur_str];
+        else if (tw->timer >= timer_delay / tw->speed) {
+            tw->timer = 0.0;
+            run_text_ops(tw, script);
             
-            if (current[text->cur_byte] == '\0') {
-               if (!bubble) text->waiting_for_input = true;
+            // Uma pausa recém-lida segura o próximo caractere.
+            if (tw->pause_timer > 0.0) {
+                tw->timer = 0.0;
             }
-            else {
-                if (text->char_count < MAX_DIALOGUE_CHAR) {
-                    char utf8_buffer[5];
-                    int n = utf8_copy_char(&current[text->cur_byte], utf8_buffer);
-                    SDL_Texture* t = create_text(render, utf8_buffer, text->text_font, text->text_color);
-                    if (t) {
-                        if (sound && sfx_timer >= sfx_cooldown) {
-                            int speaker = text->on_frame[text->cur_str];
-                            Mix_Chunk* chunk = NULL;
-                            
-                            if (speaker == FACE_MENEGHETTI || speaker == FACE_MENEGHETTI_ANGRY || speaker ==  FACE_MENEGHETTI_SAD) {
-                                chunk = sound[0].sound;
-                            }
-                            if (speaker == FACE_PYTHON) {
-                                chunk = sound[1].sound;
-                            }
-                            if (speaker == FACE_NONE) {
-                                chunk = sound[2].sound;
-                            }
-                            if (speaker == FACE_BUBBLE) {
-                                chunk = sound[3].sound;
-                            }
-                            if (speaker == FACE_CHATGPT) {
-                                chunk = sound[4].sound;
-                            }
+            else if (tw->char_count >= line->count) {
+               if (!bubble) tw->waiting_for_input = true;
+            }
+            else if (tw->char_count < line->fit_count) {
+                if (sound && tw->sfx_timer >= sfx_cooldown) {
+                    int speaker = tw->speaker;
+                    Mix_Chunk* chunk = NULL;
+                    
+                    if (speaker == FACE_MENEGHETTI || speaker == FACE_MENEGHETTI_ANGRY || speaker ==  FACE_MENEGHETTI_SAD) {
+                        chunk = sound[0].sound;
+                    }
+                    if (speaker == FACE_PYTHON) {
+                        chunk = sound[1].sound;
+                    }
+                    if (speaker == FACE_NONE) {
+                        chunk = sound[2].sound;
+                    }
+                    if (speaker == FACE_BUBBLE) {
+                        chunk = sound[3].sound;
+                    }
+                    if (speaker == FACE_CHATGPT) {
+                        chunk = sound[4].sound;
+                    }
 
-                            if (chunk) {
-                                Mix_PlayChannel(DIALOGUE_CHANNEL, chunk, 0);
-                            }
-                            sfx_timer = 0.0;
-                        }
-                        text->chars[text->char_count] = t;
-                        strcpy(text->chars_string[text->char_count], utf8_buffer);
-                        text->char_count++;
+                    if (chunk) {
+                        Mix_PlayChannel(DIALOGUE_CHANNEL, chunk, 0);
                     }
-                    text->cur_byte += n;
+                    tw->sfx_timer = 0.0;
                 }
+                tw->op_cursor++;
+                tw->char_count++;
+            }
+
+            // Texto maior que a caixa: o restante é descartado, como ao estourar a altura.
+            if (tw->char_count >= line->fit_count && line->fit_count < line->count) {
+                if (!bubble) tw->waiting_for_input = true;
             }
         }
     }
     else {
         if (e_pressed && !bubble) {
-            for (int i = 0; i < text->char_count; i++) {
-                if (text->chars[i]) {
-                    SDL_DestroyTexture(text->chars[i]);
-                    text->chars[i] = NULL;
-                }
-            }
-            text->char_count = 0;
-            text->cur_byte = 0;
-            text->cur_str++;
+            tw->char_count = 0;
+            tw->cur_str++;
 
-            text->waiting_for_input = false;
-            if (text->cur_str >= text_amount) {
-                reset_dialogue(text);
+            tw->waiting_for_input = false;
+            if (tw->cur_str >= text_amount) {
+                reset_typewriter(tw);
                 
                 if (npc) {
                     if (npc->times_interacted < npc->dialogue_amount - 1) {
@@ -3260,129 +4565,47 @@ void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *
 
                 return;
             }
-        }
-    }
-
-    int pos_x = text->text_box.x;
-    int pos_y = text->text_box.y;
-
-    int max_x;
-    if (bubble) max_x = dialogue_box.x + dialogue_box.w - 2;
-    else max_x = dialogue_box.x + dialogue_box.w - 50;
-
-    int max_y;
-    if (*game_state != BATTLE_SCREEN) max_y = dialogue_box.y + dialogue_box.h - 27;
-    else if (bubble) max_y = dialogue_box.y + dialogue_box.h - 2;
-    else max_y = dialogue_box.y + dialogue_box.h;
-
-    int default_line_height = 16;
-    if (text->text_font) {
-        default_line_height = TTF_FontHeight(text->text_font);
-    } 
-    int line_height = 0;
-
-    for (int i = 0; i < text->char_count; i++) {
-        SDL_Texture* ct = text->chars[i];
-        if (!ct) continue;
-
-        int w, h;
-        SDL_QueryTexture(ct, NULL, NULL, &w, &h);
-        if (h > line_height) line_height = h;
-    }
-
-    int current_x = pos_x;
-    int current_y = pos_y;
-    int word_width = 0;
-    int word_start = -1;
+            start_typewriter_line(tw, text);
 
-    for (int i = 0; i < text->char_count; i++) {
-        SDL_Texture* ct = text->chars[i];
-        if (!ct) continue;
-
-        int w, h;
-        SDL_QueryTexture(ct, NULL, NULL, &w, &h);
-        if (w == 0) w = 8;
-        if (h == 0) h = 16;
-
-        const char *chstr = text->chars_string[i];
-        bool is_space = (strcmp(chstr, " ") == 0);
-        bool is_newline = (strcmp(chstr, "|") == 0);
-
-        if (is_newline) {
-            word_start = -1;
-            word_width = 0;
-
-            current_x = pos_x;
-            current_y += (line_height > 0) ? line_height : default_line_height;
-            line_height = 0;
-            continue;
-        }
-
-        if (!is_space && word_start == -1) {
-            word_start = i;
-            word_width = 0;
-        }
-
-        if (!is_space) {
-            word_width += w;
-        }
-
-        if (is_space || i == text->char_count - 1) {
-            if (word_start != -1) {
-                if (current_x + word_width > max_x) {
-                    current_x = pos_x;
-                    current_y += (line_height > 0) ? line_height : default_line_height;
-                    line_height = 0;
-
-                    for (int j = word_start; j <= i; j++) {
-                        SDL_Texture* char_tex = text->chars[j];
-                        if (!char_tex) continue;
-
-                        int ch;
-                        SDL_QueryTexture(char_tex, NULL, NULL, NULL, &ch);
-                        if (ch > line_height) line_height = ch;
-                    }
-                }
-
-                for (int j = word_start; j <= i; j++) {
-                    SDL_Texture* char_tex = text->chars[j];
-                    if (!char_tex) continue;
-
-                    int cw, ch;
-                    SDL_QueryTexture(char_tex, NULL, NULL, &cw, &ch);
-                    SDL_Rect dst = {current_x, current_y, cw, ch};
-                    SDL_RenderCopy(render, char_tex, NULL, &dst);
-                    current_x += cw;
-                }
-
-                word_start = -1;
-                word_width = 0;
+            // Troca de buffers: a próxima linha foi preparada enquanto a atual era digitada.
+            DialogueLine *next = &tw->lines[!tw->front_line];
+            if (next->ready && next->source_str == tw->cur_str) {
+                tw->front_line = !tw->front_line;
             }
 
-            if (is_space) {
-                if (current_x + w > max_x) {
-                    current_x = pos_x;
-                    current_y += (line_height > 0) ? line_height : default_line_height;
-                    line_height = h;
-                }
+            text_area = dialogue_text_area(dialogue_box, *game_state, tw->speaker, bubble);
+            tw->text_box.x = text_area.x;
+            tw->text_box.y = text_area.y;
 
-                SDL_Rect dst = {current_x, current_y, w, h};
-                SDL_RenderCopy(render, ct, NULL, &dst);
-                current_x += w;
+            line = &tw->lines[tw->front_line];
+            if (!line->ready || line->source_str != tw->cur_str) {
+                prepare_dialogue_line(render, text, line, tw->cur_str, text_area, -1);
+            }
+            else if (line->wrap_w != text_area.w || line->wrap_h != text_area.h) {
+                layout_dialogue_line(line, text_area, text->text_font ? TTF_FontHeight(text->text_font) : 16);
             }
         }
+    }
 
-        if (current_y + line_height > max_y) {
-            if (!bubble) text->waiting_for_input = true;
-            break;
-        }
+    tw->effect_timer += dt;
+
+    GlyphCache *cache = get_glyph_cache(text->text_font);
+    if (cache) {
+        int visible = SDL_min(tw->char_count, line->fit_count);
+        render_dialogue_line(render, line, visible, cache->atlas, tw->text_box.x, tw->text_box.y, tw->effect_timer);
     }
 
-    if (text->on_frame[text->cur_str] != FACE_NONE) {
-        switch(text->on_frame[text->cur_str]) {
+    if (tw->cur_str + 1 < text_amount) {
+        SDL_Rect next_area = dialogue_text_area(dialogue_box, *game_state, text->on_frame[tw->cur_str + 1], bubble);
+        if (!prepare_dialogue_line(render, text, &tw->lines[!tw->front_line], tw->cur_str + 1, next_area, DIALOGUE_PREPARE_BUDGET)) {
+            mark_frame_dirty();
+        }
+    }
+    if (tw->speaker != FACE_NONE) {
+        switch(tw->speaker) {
             case FACE_MENEGHETTI:
                 if (has_faces) {
-                    if (!text->waiting_for_input) {
+                    if (!tw->waiting_for_input) {
                         while (dialogue_faces->timer >= anim_cooldown) {
                             dialogue_faces[FACE_MENEGHETTI].counter = (dialogue_faces[FACE_MENEGHETTI].counter + 1) % dialogue_faces[FACE_MENEGHETTI].count;
                             dialogue_faces->timer = 0.0;
@@ -3398,7 +4621,7 @@ void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *
                 break;
             case FACE_MENEGHETTI_ANGRY:
                 if (has_faces) {
-                    if (!text->waiting_for_input) {
+                    if (!tw->waiting_for_input) {
                         while (dialogue_faces->timer >= anim_cooldown) {
                             
                             dialogue_faces[FACE_MENEGHETTI_ANGRY].counter = (dialogue_faces[FACE_MENEGHETTI_ANGRY].counter + 1) % dialogue_faces[FACE_MENEGHETTI_ANGRY].count;
@@ -3415,7 +4638,7 @@ void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *
                 break;
             case FACE_MENEGHETTI_SAD:
                 if (has_faces) {
-                    if (!text->waiting_for_input) {
+                    if (!tw->waiting_for_input) {
                         while (dialogue_faces->timer >= anim_cooldown) {
                             
                             dialogue_faces[FACE_MENEGHETTI_SAD].counter = (dialogue_faces[FACE_MENEGHETTI_SAD].counter + 1) % dialogue_faces[FACE_MENEGHETTI_SAD].count;
@@ -3432,7 +4655,7 @@ void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *
                 break;
             case FACE_PYTHON:
                 if (has_faces) {
-                    if (!text->waiting_for_input) {
+                    if (!tw->waiting_for_input) {
                         while (dialogue_faces->timer >= anim_cooldown) {
                             
                             dialogue_faces[FACE_PYTHON].counter = (dialogue_faces[FACE_PYTHON].counter + 1) % dialogue_faces[FACE_PYTHON].count;
@@ -3449,7 +4672,7 @@ void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *
                 break;
             case FACE_CHATGPT:
                 if (has_faces) {
-                    if (!text->waiting_for_input) {
+                    if (!tw->waiting_for_input) {
                         while (dialogue_faces->timer >= anim_cooldown) {
                             
                             dialogue_faces[FACE_CHATGPT].counter = (dialogue_faces[FACE_CHATGPT].counter + 1) % dialogue_faces[FACE_CHATGPT].count;
@@ -3467,21 +4690,345 @@ void create_dialogue(Player *player, SDL_Renderer *render, Dialogue *text, NPC *
     }
 }
 
-void reset_dialogue(Dialogue *text) {
-    for (int i = 0; i < text->char_count; i++) {
-        if (text->chars[i]) {
-            SDL_DestroyTexture(text->chars[i]);
-            text->chars[i] = NULL;
+void reset_typewriter(Typewriter *tw) {
+    tw->dialogue = NULL;
+    for (int i = 0; i < 2; i++) {
+        tw->lines[i].ready = false;
+        tw->lines[i].source_str = -1;
+    }
+    tw->front_line = 0;
+    tw->char_count = 0;
+    tw->cur_str = 0;
+    tw->op_cursor = 0;
+    tw->speaker = FACE_NONE;
+    tw->speed = 1.0;
+    tw->pause_timer = 0.0;
+    tw->timer = 0.0;
+    tw->waiting_for_input = false;
+}
+
+static void start_typewriter_line(Typewriter *tw, const Dialogue *text) {
+    tw->op_cursor = 0;
+    tw->speaker = text->on_frame[tw->cur_str];
+    tw->speed = 1.0;
+    tw->pause_timer = 0.0;
+}
+
+static void run_text_ops(Typewriter *tw, const TextScript *script) {
+    // Executa as operações de controle até o próximo glifo; uma pausa interrompe a sequência.
+    while (tw->op_cursor < script->count) {
+        const TextOp *op = &script->ops[tw->op_cursor];
+
+        switch (op->type) {
+            case TEXT_OP_PAUSE:
+                tw->pause_timer += op->value;
+                tw->op_cursor++;
+                return;
+            case TEXT_OP_SPEED:
+                tw->speed = op->value;
+                break;
+            case TEXT_OP_SPEAKER:
+                tw->speaker = (int)op->value;
+                break;
+            case TEXT_OP_COLOR:
+            case TEXT_OP_COLOR_RESET:
+                break;
+            default:
+                return;
+        }
+        tw->op_cursor++;
+    }
+}
+
+void prefetch_dialogue(SDL_Renderer *render, const Dialogue *text) {
+    if (!text) return;
+
+    GlyphCache *cache = get_glyph_cache(text->text_font);
+    if (!cache) return;
+
+    // Aquece o cache com a primeira fala; o layout em si é barato e é feito quando o diálogo abre.
+    if (!text->scripts) return;
+    const TextScript *script = &text->scripts[0];
+    int budget = DIALOGUE_PREPARE_BUDGET;
+
+    for (int i = 0; i < script->count && budget > 0; i++) {
+        const TextOp *op = &script->ops[i];
+        if (op->type != TEXT_OP_CHAR && op->type != TEXT_OP_SPACE) continue;
+
+        Glyph *cached = find_glyph(cache, op->codepoint, false);
+        if (!cached || !cached->loaded) {
+            cache_glyph(render, cache, op->codepoint, op->utf8);
+            budget--;
+        }
+    }
+}
+
+static SDL_Rect dialogue_box_rect(int game_state, Player *player, Prop *bubble_speech) {
+    SDL_Rect dialogue_box = {0, 0, 0, 0};
+
+    switch(game_state) {
+        case CUTSCENE_SCREEN:
+            dialogue_box = (SDL_Rect){20, SCREEN_HEIGHT - 200, SCREEN_WIDTH - 40, 180};
+            break;
+        case OPEN_WORLD_SCREEN:
+            if (player->collision.y + player->collision.h < SCREEN_HEIGHT / 2) {
+                dialogue_box = (SDL_Rect){25, SCREEN_HEIGHT - 175, SCREEN_WIDTH - 50, 150};
+            }
+            else {
+                dialogue_box = (SDL_Rect){25, 25, SCREEN_WIDTH - 50, 150};
+            }
+            break;
+        case BATTLE_SCREEN:
+            if (bubble_speech) {
+                int w, h;
+                SDL_QueryTexture(bubble_speech->texture, NULL, NULL, &w, &h);
+                dialogue_box = (SDL_Rect){380, 40, w * 1.5, h * 1.5};
+            }
+            else {
+                dialogue_box = (SDL_Rect){20, SCREEN_HEIGHT / 2, SCREEN_WIDTH - 40, 132};
+            }
+            break;
+        case FINAL_SCREEN:
+            dialogue_box = (SDL_Rect){25, SCREEN_HEIGHT - 175, SCREEN_WIDTH - 50, 150};
+            break;
+        default:
+            break;
+    }
+
+    return dialogue_box;
+}
+
+static SDL_Rect dialogue_text_area(SDL_Rect dialogue_box, int game_state, int face, bool bubble) {
+    SDL_Rect area;
+
+    if (face != FACE_NONE && face != FACE_BUBBLE) {
+        area.x = dialogue_box.x + 130;
+        area.y = dialogue_box.y + 27;
+    }
+    else if (bubble) {
+        area.x = dialogue_box.x + 35;
+        area.y = dialogue_box.y + 5;
+    }
+    else {
+        area.x = dialogue_box.x + 27;
+        area.y = dialogue_box.y + 27;
+    }
+
+    int max_x;
+    if (bubble) max_x = dialogue_box.x + dialogue_box.w - 2;
+    else max_x = dialogue_box.x + dialogue_box.w - 50;
+
+    int max_y;
+    if (game_state != BATTLE_SCREEN) max_y = dialogue_box.y + dialogue_box.h - 27;
+    else if (bubble) max_y = dialogue_box.y + dialogue_box.h - 2;
+    else max_y = dialogue_box.y + dialogue_box.h;
+
+    area.w = max_x - area.x;
+    area.h = max_y - area.y;
+    return area;
+}
+
+static bool prepare_dialogue_line(SDL_Renderer *render, const Dialogue *text, DialogueLine *line, int str_index, SDL_Rect area, int budget) {
+    if (line->source_str != str_index) {
+        line->source_str = str_index;
+        line->count = 0;
+        line->fit_count = 0;
+        line->cursor = 0;
+        line->pen_color = text->text_color;
+        line->pen_speaker = text->on_frame[str_index];
+        line->ready = false;
+    }
+    if (line->ready) return true;
+
+    if (!text->scripts || !text->writings[str_index]) return false;
+    const TextScript *script = &text->scripts[str_index];
+
+    GlyphCache *cache = get_glyph_cache(text->text_font);
+
+    while (line->cursor < script->count && line->count < MAX_DIALOGUE_CHAR) {
+        const TextOp *op = &script->ops[line->cursor];
+
+        // Cor e falante mudam a "caneta"; pausa e velocidade ficam para o typewriter.
+        if (op->type > TEXT_OP_NEWLINE) {
+            if (op->type == TEXT_OP_COLOR) line->pen_color = op->color;
+            else if (op->type == TEXT_OP_COLOR_RESET) line->pen_color = text->text_color;
+            else if (op->type == TEXT_OP_SPEAKER) line->pen_speaker = (int)op->value;
+            line->cursor++;
+            continue;
+        }
+
+        // Orçamento por quadro: glifos já em cache não custam nada, só a rasterização conta.
+        Glyph *cached = (cache && op->type != TEXT_OP_NEWLINE) ? find_glyph(cache, op->codepoint, false) : NULL;
+        bool needs_raster = (op->type != TEXT_OP_NEWLINE) && (!cached || !cached->loaded);
+        if (budget == 0 && needs_raster) return false;
+
+        if (op->type == TEXT_OP_NEWLINE) {
+            line->glyphs[line->count] = NULL;
+            line->kinds[line->count] = GLYPH_NEWLINE;
+        }
+        else {
+            if (budget > 0 && needs_raster) budget--;
+            line->glyphs[line->count] = cache ? cache_glyph(render, cache, op->codepoint, op->utf8) : NULL;
+            line->kinds[line->count] = (op->type == TEXT_OP_SPACE) ? GLYPH_SPACE : GLYPH_CHAR;
+        }
+
+        Uint8 effect = TEXT_EFFECT_NONE;
+        if (line->pen_speaker == FACE_MENEGHETTI_ANGRY) effect = TEXT_EFFECT_SHAKE;
+        else if (line->pen_speaker == FACE_BUBBLE) effect = TEXT_EFFECT_WAVE;
+
+        line->effects[line->count] = effect;
+        line->colors[line->count] = line->pen_color;
+        line->count++;
+        line->cursor++;
+    }
+
+    layout_dialogue_line(line, area, text->text_font ? TTF_FontHeight(text->text_font) : 16);
+    line->ready = true;
+    return true;
+}
+
+static void layout_dialogue_line(DialogueLine *line, SDL_Rect area, int line_height) {
+    int current_x = 0;
+    int current_y = 0;
+    int word_width = 0;
+    int word_start = -1;
+
+    line->wrap_w = area.w;
+    line->wrap_h = area.h;
+    line->fit_count = line->count;
+
+    for (int i = 0; i < line->count; i++) {
+        const Glyph *glyph = line->glyphs[i];
+        int w = (glyph && glyph->w > 0) ? glyph->w : 8;
+
+        if (line->kinds[i] == GLYPH_NEWLINE) {
+            if (word_start != -1) {
+                if (current_x + word_width > area.w) {
+                    current_x = 0;
+                    current_y += line_height;
+                }
+                for (int j = word_start; j < i; j++) {
+                    line->offset_x[j] = current_x;
+                    line->offset_y[j] = current_y;
+                    current_x += (line->glyphs[j] && line->glyphs[j]->w > 0) ? line->glyphs[j]->w : 8;
+                }
+                word_start = -1;
+                word_width = 0;
+            }
+
+            line->offset_x[i] = current_x;
+            line->offset_y[i] = current_y;
+            current_x = 0;
+            current_y += line_height;
+            continue;
+        }
+
+        if (line->kinds[i] == GLYPH_CHAR) {
+            if (word_start == -1) {
+                word_start = i;
+                word_width = 0;
+            }
+            word_width += w;
+        }
+
+        if (line->kinds[i] == GLYPH_SPACE || i == line->count - 1) {
+            if (word_start != -1) {
+                if (current_x + word_width > area.w) {
+                    current_x = 0;
+                    current_y += line_height;
+                }
+
+                int word_end = (line->kinds[i] == GLYPH_SPACE) ? i - 1 : i;
+                for (int j = word_start; j <= word_end; j++) {
+                    line->offset_x[j] = current_x;
+                    line->offset_y[j] = current_y;
+                    current_x += (line->glyphs[j] && line->glyphs[j]->w > 0) ? line->glyphs[j]->w : 8;
+                }
+
+                word_start = -1;
+                word_width = 0;
+            }
+
+            if (line->kinds[i] == GLYPH_SPACE) {
+                if (current_x + w > area.w) {
+                    current_x = 0;
+                    current_y += line_height;
+                }
+
+                line->offset_x[i] = current_x;
+                line->offset_y[i] = current_y;
+                current_x += w;
+            }
+        }
+    }
+
+    for (int i = 0; i < line->count; i++) {
+        if (line->offset_y[i] + line_height > area.h) {
+            line->fit_count = i;
+            break;
         }
     }
-    text->char_count = 0;
-    text->cur_str = 0;
-    text->cur_byte = 0;
-    text->timer = 0.0;
-    text->waiting_for_input = false;
 }
 
-void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int *player_health, int damage, int attack_index, Projectile **props, double dt, double turn_timer, Sound *sound, bool clear) {
+static void render_dialogue_line(SDL_Renderer *render, const DialogueLine *line, int visible, SDL_Texture *atlas, int x, int y, double time) {
+    if (!atlas || visible <= 0) return;
+
+    // Todos os glifos da caixa saem do mesmo atlas: um único lote de geometria por quadro.
+    SDL_Vertex vertices[MAX_DIALOGUE_CHAR * 4];
+    int indices[MAX_DIALOGUE_CHAR * 6];
+    int vertex_count = 0;
+    int index_count = 0;
+
+    float inv_size = 1.0f / GLYPH_ATLAS_SIZE;
+    int shake_step = (int)(time * 20.0);
+
+    for (int i = 0; i < visible; i++) {
+        const Glyph *glyph = line->glyphs[i];
+        if (!glyph || glyph->w <= 0 || line->kinds[i] != GLYPH_CHAR) continue;
+
+        float gx = (float)(x + line->offset_x[i]);
+        float gy = (float)(y + line->offset_y[i]);
+
+        // Glifos com efeito mudam a cada quadro, então a caixa nunca fica estática.
+        if (line->effects[i] != TEXT_EFFECT_NONE) mark_frame_dirty();
+
+        if (line->effects[i] & TEXT_EFFECT_SHAKE) {
+            Uint32 seed = (Uint32)i * 73856093u ^ (Uint32)shake_step * 19349663u;
+            seed ^= seed >> 13;
+            seed *= 0x5bd1e995u;
+            seed ^= seed >> 15;
+            gx += (float)((int)(seed % 3) - 1);
+            gy += (float)((int)((seed >> 8) % 3) - 1);
+        }
+        if (line->effects[i] & TEXT_EFFECT_WAVE) {
+            gy += 2.0f * (float)sin(time * 6.0 + i * 0.6);
+        }
+
+        float u0 = glyph->src.x * inv_size;
+        float v0 = glyph->src.y * inv_size;
+        float u1 = (glyph->src.x + glyph->src.w) * inv_size;
+        float v1 = (glyph->src.y + glyph->src.h) * inv_size;
+        SDL_Color color = line->colors[i];
+
+        vertices[vertex_count + 0] = (SDL_Vertex){{gx, gy}, color, {u0, v0}};
+        vertices[vertex_count + 1] = (SDL_Vertex){{gx + glyph->w, gy}, color, {u1, v0}};
+        vertices[vertex_count + 2] = (SDL_Vertex){{gx + glyph->w, gy + glyph->h}, color, {u1, v1}};
+        vertices[vertex_count + 3] = (SDL_Vertex){{gx, gy + glyph->h}, color, {u0, v1}};
+
+        indices[index_count++] = vertex_count + 0;
+        indices[index_count++] = vertex_count + 1;
+        indices[index_count++] = vertex_count + 2;
+        indices[index_count++] = vertex_count + 0;
+        indices[index_count++] = vertex_count + 2;
+        indices[index_count++] = vertex_count + 3;
+        vertex_count += 4;
+    }
+
+    if (index_count > 0) {
+        SDL_RenderGeometry(render, atlas, vertices, vertex_count, indices, index_count);
+    }
+}
+void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int *player_health, int damage, int attack_index, Projectile **props, double dt, double step_time, double turn_timer, Sound *sound, bool clear) {
     static double spawn_timer = 0.0;
     static int objects_spawned = 0;
     static bool attack_active = false;
@@ -3504,6 +5051,7 @@ void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int
     Mix_Chunk* slam_sound = sound[3].sound;
     Mix_Chunk* strike_sound = sound[4].sound;
 
+    // Os projéteis andam no passo fixo, como a alma: os testes de acerto usam as mesmas posições em qualquer taxa de quadros.
     if (!clear) {    
         switch(attack_index) {
             case 1:
@@ -3528,8 +5076,8 @@ void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int
                         }
 
                         if (props[3][0].collision.x >= battle_box.animated_box.x - 10 || props[3][1].collision.x <= battle_box.animated_box.x - 10) {
-                            if (props[3][0].collision.x >= battle_box.animated_box.x - 10) props[3][0].collision.x -= 80.0 * dt;
-                            if (props[3][1].collision.x <= battle_box.animated_box.x - 10) props[3][1].collision.x += 80.0 * dt;
+                            if (props[3][0].collision.x >= battle_box.animated_box.x - 10) props[3][0].collision.x -= 80.0 * step_time;
+                            if (props[3][1].collision.x <= battle_box.animated_box.x - 10) props[3][1].collision.x += 80.0 * step_time;
                         }
                         else {
                             attack_active = true;
@@ -3591,7 +5139,7 @@ void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int
 
                 for (int i = 0; i < 15; i++) {
                     if (created_object[i]) {
-                        active_objects[i].collision.y += objects_speed[i] * dt;
+                        active_objects[i].collision.y += objects_speed[i] * step_time;
 
                         if ((active_objects[i].collision.y + active_objects[i].collision.h) >= (battle_box.animated_box.y + battle_box.animated_box.h)) {
                             Mix_PlayChannel(DEFAULT_CHANNEL, slam_sound, 0);
@@ -3672,7 +5220,7 @@ void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int
 
                 for (int i = 0; i < 6; i++) {
                     if (created_object[i]) {
-                        active_objects[i].collision.x += objects_speed[i] * dt;
+                        active_objects[i].collision.x += objects_speed[i] * step_time;
 
                         if (i % 2 == 0) {
                             if (created_object[i] && created_object[i + 1]) {
@@ -3793,8 +5341,8 @@ void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int
 
                         active_objects[i].texture = animate_sprite(&active_objects->animation, dt, 0.2, false);
                             
-                        active_objects[i].collision.x += vel_x[i] * dt;
-                        active_objects[i].collision.y += vel_y[i] * dt;
+                        active_objects[i].collision.x += vel_x[i] * step_time;
+                        active_objects[i].collision.y += vel_y[i] * step_time;
 
                         if (active_objects[i].collision.x < battle_box.animated_box.x + 5 || active_objects[i].collision.x + active_objects[i].collision.w > battle_box.animated_box.x + battle_box.animated_box.w || active_objects[i].collision.y < battle_box.animated_box.y || active_objects[i].collision.y + active_objects[i].collision.h > battle_box.animated_box.y + battle_box.animated_box.h) {
                             Mix_PlayChannel(DEFAULT_CHANNEL, slam_sound, 0);
@@ -3854,9 +5402,13 @@ void python_attacks(SDL_Renderer *render, Soul *soul, BattleBox battle_box, int
     }
 }
 
-void sprite_update(Prop *scenario, Player *player, Animation *animation, double dt, SDL_Rect boxes[], SDL_Rect surfaces[], Sound *sound) {
+void sprite_update(Prop *scenario, Player *player, Animation *animation, double dt, const Tilemap *map, SDL_Rect boxes[], Sound *sound) {
     const Uint8 *keys = player->keystate ? player->keystate : SDL_GetKeyboardState(NULL);
 
+    // As caixas de entidades são do início do quadro; o terreno usa a mesma origem.
+    int origin_x = scenario->collision.x;
+    int origin_y = scenario->collision.y;
+
     SDL_Rect feet = {player->collision.x, player->collision.y + 29, player->collision.w, 3};
     
     bool raw_up = keys[SDL_SCANCODE_W];
@@ -3896,7 +5448,7 @@ void sprite_update(Prop *scenario, Player *player, Animation *animation, double
         if (scenario->collision.y < 0 && player->collision.y < (SCREEN_HEIGHT / 2) - 16) {
             SDL_Rect test = feet;
             test.y -= move;
-            if (!check_collision(&test, boxes, COLLISION_QUANTITY)) {
+            if (!movement_blocked(map, &test, origin_x, origin_y, boxes)) {
                 scenario->collision.y += move;
                 moving_up = true;
             }
@@ -3905,7 +5457,7 @@ void sprite_update(Prop *scenario, Player *player, Animation *animation, double
         } else {
             SDL_Rect test = feet;
             test.y -= move;
-            if (!check_collision(&test, boxes, COLLISION_QUANTITY) && player->collision.y > 0) {
+            if (!movement_blocked(map, &test, origin_x, origin_y, boxes) && player->collision.y > 0) {
                 player->collision.y -= move;
                 moving_up = true;
             }
@@ -3918,7 +5470,7 @@ void sprite_update(Prop *scenario, Player *player, Animation *animation, double
         if (scenario->collision.y > -SCREEN_HEIGHT && player->collision.y > (SCREEN_HEIGHT / 2) - 16) {
             SDL_Rect test = feet;
             test.y += move;
-            if (!check_collision(&test, boxes, COLLISION_QUANTITY)) {
+            if (!movement_blocked(map, &test, origin_x, origin_y, boxes)) {
                 scenario->collision.y -= move;
                 moving_down = true;
             }
@@ -3927,7 +5479,7 @@ void sprite_update(Prop *scenario, Player *player, Animation *animation, double
         } else {
             SDL_Rect test = feet;
             test.y += move;
-            if (!check_collision(&test, boxes, COLLISION_QUANTITY) && player->collision.y < SCREEN_HEIGHT - player->collision.h) {
+            if (!movement_blocked(map, &test, origin_x, origin_y, boxes) && player->collision.y < SCREEN_HEIGHT - player->collision.h) {
                 player->collision.y += move;
                 moving_down = true;
             }
@@ -3940,7 +5492,7 @@ void sprite_update(Prop *scenario, Player *player, Animation *animation, double
         if (scenario->collision.x < 0 && player->collision.x < (SCREEN_WIDTH / 2) - 10) {
             SDL_Rect test = feet;
             test.x -= move;
-            if (!check_collision(&test, boxes, COLLISION_QUANTITY)) {
+            if (!movement_blocked(map, &test, origin_x, origin_y, boxes)) {
                 scenario->collision.x += move;
                 moving_left = true;
             }
@@ -3949,7 +5501,7 @@ void sprite_update(Prop *scenario, Player *player, Animation *animation, double
         } else {
             SDL_Rect test = feet;
             test.x -= move;
-            if (!check_collision(&test, boxes, COLLISION_QUANTITY) && player->collision.x > 0) {
+            if (!movement_blocked(map, &test, origin_x, origin_y, boxes) && player->collision.x > 0) {
                 player->collision.x -= move;
                 moving_left = true;
             }
@@ -3962,7 +5514,7 @@ void sprite_update(Prop *scenario, Player *player, Animation *animation, double
         if (scenario->collision.x > -SCREEN_WIDTH && player->collision.x > (SCREEN_WIDTH / 2) - 10) {
             SDL_Rect test = feet;
             test.x += move;
-            if (!check_collision(&test, boxes, COLLISION_QUANTITY)) {
+            if (!movement_blocked(map, &test, origin_x, origin_y, boxes)) {
                 scenario->collision.x -= move;
                 moving_right = true;
             }
@@ -3971,7 +5523,7 @@ void sprite_update(Prop *scenario, Player *player, Animation *animation, double
         } else {
             SDL_Rect test = feet;
             test.x += move;
-            if (!check_collision(&test, boxes, COLLISION_QUANTITY) && player->collision.x < SCREEN_WIDTH - player->collision.w) {
+            if (!movement_blocked(map, &test, origin_x, origin_y, boxes) && player->collision.x < SCREEN_WIDTH - player->collision.w) {
                 player->collision.x += move;
                 moving_right = true;
             }
@@ -4019,7 +5571,8 @@ void sprite_update(Prop *scenario, Player *player, Animation *animation, double
     static int current_walk_sound = -1;
 
     if (moving_up || moving_down || moving_left || moving_right) {
-        int surface_index = detect_surface(&player->collision, surfaces, SURFACE_QUANTITY);
+        SDL_Rect feet_now = {player->collision.x, player->collision.y + 29, player->collision.w, 3};
+        int surface_index = tilemap_material(map, &feet_now, scenario->collision.x, scenario->collision.y);
         int new_sound_index = surface_to_sound_index(surface_index);
 
         if (new_sound_index != current_walk_sound) {
@@ -4048,9 +5601,12 @@ SDL_Texture *animate_sprite(Animation *anim, double dt, double cooldown, bool bl
     if (cooldown <= 0.0) {
         anim->counter = (anim->counter + 1) % anim->count;
         anim->timer = 0.0;
+        mark_frame_dirty();
         return anim->frames[anim->counter];
     }
 
+    int previous_counter = anim->counter;
+
     anim->timer += dt;
 
     int steps = (int)(anim->timer / cooldown);
@@ -4059,275 +5615,2567 @@ SDL_Texture *animate_sprite(Animation *anim, double dt, double cooldown, bool bl
         anim->timer -= (double)steps * cooldown;
     }
 
-    if (blink && anim->count == 2) {
-        if (anim->counter == 1) {
-            double blink_duration = cooldown / 7.0;
-            if (anim->timer >= blink_duration) {
-                anim->counter = 0;
-            }
+    if (blink && anim->count == 2) {
+        if (anim->counter == 1) {
+            double blink_duration = cooldown / 7.0;
+            if (anim->timer >= blink_duration) {
+                anim->counter = 0;
+            }
+        }
+        else {
+            anim->counter = 0;
+        }
+    }
+
+    anim->counter %= anim->count;
+
+    // Troca de quadro pede redesenho; o próximo passo da animação vira o prazo de espera.
+    if (anim->counter != previous_counter) mark_frame_dirty();
+    if (blink && anim->count == 2 && anim->counter == 1) {
+        schedule_frame_wake(cooldown / 7.0 - anim->timer);
+    }
+    else {
+        schedule_frame_wake(cooldown - anim->timer);
+    }
+
+    return anim->frames[anim->counter];
+}
+
+bool rects_intersect(SDL_Rect *a, SDL_Rect *b, SDL_FRect *c) {
+    if (b) {
+        int leftX_A, leftX_B;
+        int topY_A, topY_B;
+        int rightX_A, rightX_B;
+        int bottomY_A, bottomY_B;
+
+        leftX_A = a->x;
+        topY_A = a->y;
+        rightX_A = a->x + a->w;
+        bottomY_A = a->y + a->h;
+
+        leftX_B = b->x;
+        topY_B = b->y;
+        rightX_B = b->x + b->w;
+        bottomY_B = b->y + b->h;
+
+        if (leftX_A >= rightX_B)
+            return false;
+
+        if (topY_A >= bottomY_B)
+            return false;
+
+        if (rightX_A <= leftX_B)
+            return false;
+
+        if (bottomY_A <= topY_B)
+            return false;
+
+        return true;
+    }
+    else if (c) {
+        int leftX_A, leftX_C;
+        int topY_A, topY_C;
+        int rightX_A, rightX_C;
+        int bottomY_A, bottomY_C;
+
+        leftX_A = a->x;
+        topY_A = a->y;
+        rightX_A = a->x + a->w;
+        bottomY_A = a->y + a->h;
+
+        leftX_C = c->x;
+        topY_C = c->y;
+        rightX_C = c->x + c->w;
+        bottomY_C = c->y + c->h;
+
+        if (leftX_A >= rightX_C)
+            return false;
+
+        if (topY_A >= bottomY_C)
+            return false;
+
+        if (rightX_A <= leftX_C)
+            return false;
+
+        if (bottomY_A <= topY_C)
+            return false;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool check_collision(SDL_Rect *player, SDL_Rect boxes[], int box_count) {
+    for (int i = 0; i < box_count; i++) {
+        if (rects_intersect(player, &boxes[i], NULL)) return true;
+    }
+
+    return false;
+}
+
+static int surface_to_sound_index(int surface_index) {
+    if (surface_index < 0 || surface_index > 12) return -1;
+    if (surface_index == 0 || surface_index == 1 || surface_index == 2) return 0;
+    if (surface_index == 3  || surface_index == 4 || surface_index == 5) return 1;
+    if (surface_index == 6) return 2;
+    if (surface_index == 7) return 3;
+    if (surface_index == 8) return 4;
+    if (surface_index == 9 || surface_index == 10 || surface_index == 11 || surface_index == 12) return 5;
+
+    return -1;
+}
+
+static bool movement_blocked(const Tilemap *map, SDL_Rect *test, int origin_x, int origin_y, SDL_Rect boxes[]) {
+    return tilemap_collides(map, test, origin_x, origin_y) || check_collision(test, boxes, COLLISION_QUANTITY);
+}
+
+void update_reflection(Player *original, Player* reflection, Animation *animation) {
+    reflection->facing = original->facing;
+
+    int current_frame = original->counters[original->facing];
+
+    reflection->texture = animation[reflection->facing].frames[current_frame];
+
+    reflection->collision.x = original->collision.x;
+    reflection->collision.y = original->collision.y + original->collision.h;
+    reflection->collision.w = original->collision.w;
+    reflection->collision.h = original->collision.h;
+}
+
+void create_water_reflection(WaterReflection *water, Uint8 alpha) {
+    memset(water, 0, sizeof(*water));
+    water->alpha = alpha;
+
+    // Uma volta de seno tabelada: em jogo o deslocamento de cada faixa é só uma consulta.
+    for (int i = 0; i < RIPPLE_TABLE_SIZE; i++) {
+        water->ripple[i] = (Sint8)lround(RIPPLE_AMPLITUDE * sin(2.0 * M_PI * i / RIPPLE_TABLE_SIZE));
+    }
+}
+
+void update_water_reflection(WaterReflection *water, const SDL_Rect *rect, double dt) {
+    water->timer = fmod(water->timer + dt, RIPPLE_TABLE_SIZE / RIPPLE_SPEED);
+
+    int phase = (int)(water->timer * RIPPLE_SPEED) % RIPPLE_TABLE_SIZE;
+    bool on_screen = rect->x + rect->w > 0 && rect->y + rect->h > 0 && rect->x < SCREEN_WIDTH && rect->y < SCREEN_HEIGHT;
+    if (!on_screen) return;
+
+    // A onda anda em passos da tabela: só pede quadro quando o passo muda.
+    if (phase != water->phase) mark_frame_dirty();
+    water->phase = phase;
+    schedule_frame_wake((phase + 1) / RIPPLE_SPEED - water->timer);
+}
+
+void queue_water_reflection(SDL_Renderer *render, WaterReflection *water, SDL_Texture *sprite, const SDL_Rect *dst, int layer, int depth) {
+    if (!sprite) return;
+
+    if (!bake_water_reflection(render, water, sprite, dst->w, dst->h)) {
+        SDL_SetTextureAlphaMod(sprite, water->alpha);
+        queue_copy_ex(sprite, NULL, dst, 0, SDL_FLIP_VERTICAL, layer, depth);
+        return;
+    }
+
+    // Faixas de poucas linhas, cada uma deslocada na horizontal conforme a tabela.
+    for (int y = 0, row = 0; y < dst->h; y += RIPPLE_STRIP, row++) {
+        int strip_h = SDL_min(RIPPLE_STRIP, dst->h - y);
+        int offset = water->ripple[(row * RIPPLE_ROW_STEP + water->phase) % RIPPLE_TABLE_SIZE];
+        SDL_Rect src = {0, y, dst->w, strip_h};
+        SDL_Rect strip = {dst->x + offset, dst->y + y, dst->w, strip_h};
+        queue_copy(water->target, &src, &strip, layer, depth);
+    }
+}
+
+static bool bake_water_reflection(SDL_Renderer *render, WaterReflection *water, SDL_Texture *sprite, int w, int h) {
+    if (water->target && water->source == sprite && water->w == w && water->h == h) return true;
+    if (!SDL_RenderTargetSupported(render)) return false;
+
+    if (!water->target || water->w != w || water->h != h) {
+        // O alvo do tamanho antigo sai do registro em vez de ficar preso até o fim do jogo.
+        release_texture(water->target);
+        water->target = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        if (!water->target) {
+            fprintf(stderr, "Error creating reflection target: %s\n", SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureBlendMode(water->target, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureAlphaMod(water->target, water->alpha);
+        track_texture(water->target);
+        water->w = w;
+        water->h = h;
+    }
+
+    SDL_Texture *previous = SDL_GetRenderTarget(render);
+    if (SDL_SetRenderTarget(render, water->target) != 0) {
+        fprintf(stderr, "Error binding reflection target: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // Cópia sem mistura: o alvo recebe os pixels do sprite como estão, sem pré-multiplicar.
+    SDL_BlendMode old_blend;
+    Uint8 old_alpha;
+    SDL_GetTextureBlendMode(sprite, &old_blend);
+    SDL_GetTextureAlphaMod(sprite, &old_alpha);
+    SDL_SetTextureBlendMode(sprite, SDL_BLENDMODE_NONE);
+    SDL_SetTextureAlphaMod(sprite, 255);
+    SDL_RenderCopyEx(render, sprite, NULL, NULL, 0.0, NULL, SDL_FLIP_VERTICAL);
+    SDL_SetTextureBlendMode(sprite, old_blend);
+    SDL_SetTextureAlphaMod(sprite, old_alpha);
+
+    SDL_SetRenderTarget(render, previous);
+    water->source = sprite;
+    return true;
+}
+
+bool load_particle_system(SDL_Renderer *render, ParticleSystem *system, const char *dir) {
+    memset(system, 0, sizeof(*system));
+
+    FILE *file = fopen(dir, "r");
+    if (!file) {
+        fprintf(stderr, "Error opening emitter file '%s'.\n", dir);
+        return false;
+    }
+
+    char line[512];
+    int line_number = 0;
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+
+        char *start = line;
+        while (*start == ' ' || *start == '\t') start++;
+        if (*start == '#' || *start == '\n' || *start == '\r' || *start == '\0') continue;
+
+        if (system->emitter_count >= MAX_EMITTERS) {
+            fprintf(stderr, "%s:%d: too many emitters (max %d).\n", dir, line_number, MAX_EMITTERS);
+            ok = false;
+            break;
+        }
+
+        ParticleEmitter *emitter = &system->emitters[system->emitter_count];
+        memset(emitter, 0, sizeof(*emitter));
+        char image[256], color_start[16], color_end[16];
+
+        if (sscanf(start, "%31s %255s %d %lf %f %f %f %f %f %f %f %f %f %15s %15s", emitter->name, image, &emitter->burst, &emitter->rate,
+                   &emitter->life_min, &emitter->life_max, &emitter->speed_min, &emitter->speed_max, &emitter->direction, &emitter->spread,
+                   &emitter->gravity, &emitter->size_start, &emitter->size_end, color_start, color_end) != 15) {
+            fprintf(stderr, "%s:%d: expected 15 columns.\n", dir, line_number);
+            ok = false;
+            break;
+        }
+
+        if (emitter->burst < 0 || emitter->rate < 0.0 || emitter->life_min <= 0.0f || emitter->life_max < emitter->life_min) {
+            fprintf(stderr, "%s:%d: invalid burst, rate or lifetime.\n", dir, line_number);
+            ok = false;
+            break;
+        }
+        if (!parse_particle_color(color_start, &emitter->color_start) || !parse_particle_color(color_end, &emitter->color_end)) {
+            fprintf(stderr, "%s:%d: colors must be RRGGBBAA.\n", dir, line_number);
+            ok = false;
+            break;
+        }
+
+        emitter->pool = particle_pool_for(render, system, image);
+        if (emitter->pool < 0) {
+            fprintf(stderr, "%s:%d: could not create particle pool for '%s'.\n", dir, line_number, image);
+            ok = false;
+            break;
+        }
+        system->emitter_count++;
+    }
+
+    fclose(file);
+    if (!ok) destroy_particle_system(system);
+    return ok;
+}
+
+int find_emitter(const ParticleSystem *system, const char *name) {
+    for (int i = 0; i < system->emitter_count; i++) {
+        if (strcmp(system->emitters[i].name, name) == 0) return i;
+    }
+
+    fprintf(stderr, "Unknown particle emitter '%s'.\n", name);
+    return -1;
+}
+
+void emit_particles(ParticleSystem *system, int emitter, float x, float y, int count) {
+    if (emitter < 0 || emitter >= system->emitter_count) return;
+
+    const ParticleEmitter *def = &system->emitters[emitter];
+    ParticlePool *pool = &system->pools[def->pool];
+    if (count <= 0) count = def->burst;
+
+    // Pool cheio: as partículas novas são descartadas, nunca alocadas.
+    for (int i = 0; i < count && pool->count < PARTICLE_CAPACITY; i++) {
+        int p = pool->count++;
+        float angle = (def->direction + random_float(-def->spread, def->spread) * 0.5f) * (float)M_PI / 180.0f;
+        float speed = random_float(def->speed_min, def->speed_max);
+
+        pool->x[p] = x;
+        pool->y[p] = y;
+        pool->vx[p] = cosf(angle) * speed;
+        pool->vy[p] = sinf(angle) * speed;
+        pool->age[p] = 0.0f;
+        pool->life[p] = random_float(def->life_min, def->life_max);
+        pool->emitter[p] = (Uint8)emitter;
+    }
+    mark_frame_dirty();
+}
+
+void stream_particles(ParticleSystem *system, int emitter, float x, float y, double dt) {
+    if (emitter < 0 || emitter >= system->emitter_count) return;
+
+    // A fração que sobra de um quadro passa para o próximo, então a taxa independe do FPS.
+    ParticleEmitter *def = &system->emitters[emitter];
+    def->accumulator += def->rate * dt;
+    int count = (int)def->accumulator;
+    if (count > 0) {
+        def->accumulator -= count;
+        emit_particles(system, emitter, x, y, count);
+    }
+}
+
+void update_particles(ParticleSystem *system, double dt) {
+    bool alive = false;
+
+    for (int k = 0; k < system->pool_count; k++) {
+        ParticlePool *pool = &system->pools[k];
+
+        int i = 0;
+        while (i < pool->count) {
+            pool->age[i] += (float)dt;
+            if (pool->age[i] >= pool->life[i]) {
+                // Troca com a última: os arrays continuam densos e a ordem não importa.
+                int last = --pool->count;
+                pool->x[i] = pool->x[last];
+                pool->y[i] = pool->y[last];
+                pool->vx[i] = pool->vx[last];
+                pool->vy[i] = pool->vy[last];
+                pool->age[i] = pool->age[last];
+                pool->life[i] = pool->life[last];
+                pool->emitter[i] = pool->emitter[last];
+                continue;
+            }
+            i++;
+        }
+
+        for (i = 0; i < pool->count; i++) {
+            pool->vy[i] += system->emitters[pool->emitter[i]].gravity * (float)dt;
+            pool->x[i] += pool->vx[i] * (float)dt;
+            pool->y[i] += pool->vy[i] * (float)dt;
+        }
+
+        if (pool->count > 0) alive = true;
+    }
+
+    if (alive) mark_frame_dirty();
+}
+
+void queue_particles(ParticleSystem *system, int layer, int depth) {
+    for (int k = 0; k < system->pool_count; k++) {
+        ParticlePool *pool = &system->pools[k];
+        if (pool->count == 0 || !pool->texture) continue;
+
+        for (int i = 0; i < pool->count; i++) {
+            const ParticleEmitter *def = &system->emitters[pool->emitter[i]];
+            float t = pool->age[i] / pool->life[i];
+            float half = (def->size_start + (def->size_end - def->size_start) * t) * 0.5f;
+            SDL_Color color = {
+                (Uint8)(def->color_start.r + (def->color_end.r - def->color_start.r) * t),
+                (Uint8)(def->color_start.g + (def->color_end.g - def->color_start.g) * t),
+                (Uint8)(def->color_start.b + (def->color_end.b - def->color_start.b) * t),
+                (Uint8)(def->color_start.a + (def->color_end.a - def->color_start.a) * t)
+            };
+
+            SDL_Vertex *v = &pool->vertices[i * 4];
+            v[0] = (SDL_Vertex){{pool->x[i] - half, pool->y[i] - half}, color, {0.0f, 0.0f}};
+            v[1] = (SDL_Vertex){{pool->x[i] + half, pool->y[i] - half}, color, {1.0f, 0.0f}};
+            v[2] = (SDL_Vertex){{pool->x[i] + half, pool->y[i] + half}, color, {1.0f, 1.0f}};
+            v[3] = (SDL_Vertex){{pool->x[i] - half, pool->y[i] + half}, color, {0.0f, 1.0f}};
+        }
+
+        // Um único comando de geometria por textura, não importa quantas partículas vivas.
+        queue_geometry(pool->texture, pool->vertices, pool->count * 4, pool->indices, pool->count * 6, layer, depth);
+    }
+}
+
+void clear_particles(ParticleSystem *system) {
+    for (int k = 0; k < system->pool_count; k++) {
+        system->pools[k].count = 0;
+    }
+    for (int i = 0; i < system->emitter_count; i++) {
+        system->emitters[i].accumulator = 0.0;
+    }
+}
+
+void destroy_particle_system(ParticleSystem *system) {
+    for (int k = 0; k < system->pool_count; k++) {
+        if (system->pools[k].owned && system->pools[k].texture) SDL_DestroyTexture(system->pools[k].texture);
+    }
+    memset(system, 0, sizeof(*system));
+}
+
+static int particle_pool_for(SDL_Renderer *render, ParticleSystem *system, const char *image) {
+    for (int k = 0; k < system->pool_count; k++) {
+        if (strcmp(system->pools[k].image, image) == 0) return k;
+    }
+    if (system->pool_count >= MAX_PARTICLE_POOLS) return -1;
+
+    ParticlePool *pool = &system->pools[system->pool_count];
+    snprintf(pool->image, sizeof(pool->image), "%s", image);
+
+    if (strcmp(image, "-") == 0) {
+        // Pixel branco: a cor de cada vértice vira a cor da partícula.
+        Uint32 white = 0xFFFFFFFF;
+        pool->texture = SDL_CreateTexture(render, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, 1, 1);
+        if (pool->texture) SDL_UpdateTexture(pool->texture, NULL, &white, sizeof(white));
+        pool->owned = true;
+    }
+    else {
+        pool->texture = create_texture(render, image);
+    }
+    if (!pool->texture) return -1;
+    SDL_SetTextureBlendMode(pool->texture, SDL_BLENDMODE_BLEND);
+
+    // Os índices dos quads nunca mudam; só os vértices são refeitos a cada quadro.
+    for (int i = 0; i < PARTICLE_CAPACITY; i++) {
+        int *idx = &pool->indices[i * 6];
+        idx[0] = i * 4 + 0;
+        idx[1] = i * 4 + 1;
+        idx[2] = i * 4 + 2;
+        idx[3] = i * 4 + 0;
+        idx[4] = i * 4 + 2;
+        idx[5] = i * 4 + 3;
+    }
+
+    return system->pool_count++;
+}
+
+static bool parse_particle_color(const char *hex, SDL_Color *color) {
+    if (strlen(hex) != 8) return false;
+
+    char *end = NULL;
+    unsigned long value = strtoul(hex, &end, 16);
+    if (*end != '\0') return false;
+
+    *color = (SDL_Color){(Uint8)(value >> 24), (Uint8)(value >> 16), (Uint8)(value >> 8), (Uint8)value};
+    return true;
+}
+
+static float random_float(float min, float max) {
+    return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+static void track_texture(SDL_Texture *texture) {
+    if (!texture || already_tracked_texture(texture)) {
+        return;
+    }
+
+    if (guarded_textures_count >= guarded_textures_capacity) {
+        guarded_textures_capacity = guarded_textures_capacity ? guarded_textures_capacity * 2 : 64;
+        guarded_textures = realloc(guarded_textures, guarded_textures_capacity * sizeof(*guarded_textures));
+    }
+
+    guarded_textures[guarded_textures_count++] = texture;
+}
+
+static bool already_tracked_texture(SDL_Texture *texture) {
+    for (int i = 0; i < guarded_textures_count; i++) {
+        if (guarded_textures[i] == texture) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void release_texture(SDL_Texture *texture) {
+    if (!texture) return;
+
+    for (int i = 0; i < guarded_textures_count; i++) {
+        if (guarded_textures[i] == texture) {
+            guarded_textures[i] = guarded_textures[--guarded_textures_count];
+            break;
+        }
+    }
+    SDL_DestroyTexture(texture);
+}
+
+static void track_chunk(Mix_Chunk *chunk) {
+    if (!chunk || already_tracked_chunk(chunk)) {
+        return;
+    }
+
+    if (guarded_chunks_count >= guarded_chunks_capacity) {
+        guarded_chunks_capacity = guarded_chunks_capacity ? guarded_chunks_capacity * 2 : 64;
+        guarded_chunks = realloc(guarded_chunks, guarded_chunks_capacity * sizeof(*guarded_chunks));
+    }
+
+    guarded_chunks[guarded_chunks_count++] = chunk;
+}
+
+static bool already_tracked_chunk(Mix_Chunk *chunk) {
+    for (int i = 0; i < guarded_chunks_count; i++) {
+        if (guarded_chunks[i] == chunk) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void release_chunk(Mix_Chunk *chunk) {
+    if (!chunk) return;
+
+    for (int i = 0; i < guarded_chunks_count; i++) {
+        if (guarded_chunks[i] == chunk) {
+            guarded_chunks[i] = guarded_chunks[--guarded_chunks_count];
+            break;
+        }
+    }
+    Mix_FreeChunk(chunk);
+}
+
+static void track_font(TTF_Font *font) {
+    if (!font || already_tracked_font(font)) {
+        return;
+    }
+
+    if (guarded_fonts_count >= guarded_fonts_capacity) {
+        guarded_fonts_capacity = guarded_fonts_capacity ? guarded_fonts_capacity * 2 : 32;
+        guarded_fonts = realloc(guarded_fonts, guarded_fonts_capacity * sizeof(*guarded_fonts));
+    }
+
+    guarded_fonts[guarded_fonts_count++] = font;
+}
+
+static bool already_tracked_font(TTF_Font *font) {
+    for (int i = 0; i < guarded_fonts_count; i++) {
+        if (guarded_fonts[i] == font) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void game_cleanup(Game *game, int exit_status) {
+    Mix_HaltMusic();
+    
+    for (int i = -1; i <= MIX_CHANNELS; i++) {
+        Mix_HaltChannel(i);
+    }
+
+    Mix_CloseAudio();
+
+    clean_tracked_resources();
+    SDL_DestroyRenderer(game->renderer);
+    SDL_DestroyWindow(game->window);
+
+    TTF_Quit();
+    Mix_Quit();
+    IMG_Quit();
+    SDL_Quit();
+
+    exit(exit_status);
+}
+
+void clean_tracked_resources(void) {
+    for (int i = 0; i < guarded_textures_count; i++) {
+        if (guarded_textures[i]) {
+            SDL_DestroyTexture(guarded_textures[i]);
+        }
+    }
+    free(guarded_textures);
+    guarded_textures = NULL;
+    guarded_textures_count = guarded_textures_capacity = 0;
+
+    for (int i = 0; i < guarded_chunks_count; i++) {
+        if (guarded_chunks[i]) {
+            Mix_FreeChunk(guarded_chunks[i]);
+        }
+    }
+    free(guarded_chunks);
+    guarded_chunks = NULL;
+    guarded_chunks_count = guarded_chunks_capacity = 0;
+
+    for (int i = 0; i < guarded_fonts_count; i++) {
+        if (guarded_fonts[i]) {
+            TTF_CloseFont(guarded_fonts[i]);
+        }
+    }
+    free(guarded_fonts);
+    guarded_fonts = NULL;
+    guarded_fonts_count = guarded_fonts_capacity = 0;
+
+    // Os glifos em cache apontam para texturas já destruídas acima.
+    memset(glyph_caches, 0, sizeof(glyph_caches));
+    glyph_caches_count = 0;
+}
+
+void pacer_init(FramePacer *pacer, int mode, double target_fps) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->mode = mode;
+    pacer->target_fps = target_fps;
+    pacer->frequency = SDL_GetPerformanceFrequency();
+    if (mode == PACER_FIXED && target_fps > 0.0) {
+        pacer->period = (Uint64)((double)pacer->frequency / target_fps);
+    }
+    pacer->frame_min = 1e9;
+}
+
+double pacer_frame_time(FramePacer *pacer, bool sample) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (pacer->last_counter == 0) pacer->last_counter = now;
+
+    double dt = (double)(now - pacer->last_counter) / (double)pacer->frequency;
+    pacer->last_counter = now;
+
+    // Quadros que saíram de uma espera ociosa não representam o ritmo real.
+    if (sample && dt > 0.0) {
+        if (dt < pacer->frame_min) pacer->frame_min = dt;
+        if (dt > pacer->frame_max) pacer->frame_max = dt;
+        pacer->frame_sum += dt;
+        pacer->frame_sum_sq += dt * dt;
+        pacer->frame_samples++;
+    }
+
+    return dt;
+}
+
+void pacer_wait(FramePacer *pacer) {
+    if (pacer->mode != PACER_FIXED || pacer->period == 0) return;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (pacer->next_deadline == 0 || now > pacer->next_deadline + pacer->period) {
+        // Primeiro quadro ou atraso de mais de um período: realinha em vez de acumular dívida.
+        pacer->next_deadline = now + pacer->period;
+        return;
+    }
+
+    if (now < pacer->next_deadline) {
+        // Dorme quase tudo e gira só a margem final, onde o SDL_Delay perde precisão.
+        double remaining = (double)(pacer->next_deadline - now) / (double)pacer->frequency;
+        if (remaining > PACER_SPIN_MARGIN) {
+            SDL_Delay((Uint32)((remaining - PACER_SPIN_MARGIN) * 1000.0));
+        }
+        while (SDL_GetPerformanceCounter() < pacer->next_deadline) {
+        }
+    }
+
+    pacer->next_deadline += pacer->period;
+}
+
+void pacer_report(FramePacer *pacer, double dt) {
+    pacer->report_timer += dt;
+    if (pacer->report_timer < PACER_REPORT_INTERVAL) return;
+
+    if (pacer->frame_samples > 0) {
+        double mean = pacer->frame_sum / pacer->frame_samples;
+        double variance = pacer->frame_sum_sq / pacer->frame_samples - mean * mean;
+        double jitter = variance > 0.0 ? sqrt(variance) : 0.0;
+
+        printf("Frame pacing: %.1f FPS, avg %.2f ms, min %.2f ms, max %.2f ms, jitter %.2f ms\n",
+               1.0 / mean, mean * 1000.0, pacer->frame_min * 1000.0, pacer->frame_max * 1000.0, jitter * 1000.0);
+    }
+
+    pacer->report_timer = 0.0;
+    pacer->frame_min = 1e9;
+    pacer->frame_max = 0.0;
+    pacer->frame_sum = 0.0;
+    pacer->frame_sum_sq = 0.0;
+    pacer->frame_samples = 0;
+}
+
+void sim_clock_advance(SimClock *clock, double dt) {
+    const double step = 1.0 / SIM_RATE;
+
+    clock->accumulator += dt;
+    clock->steps = (int)(clock->accumulator / step);
+    if (clock->steps > SIM_MAX_STEPS) {
+        // Atraso grande demais (janela arrastada, depurador): descarta em vez de correr para alcançar.
+        clock->steps = SIM_MAX_STEPS;
+        clock->accumulator = 0.0;
+    }
+    else {
+        clock->accumulator -= clock->steps * step;
+    }
+    clock->alpha = clock->accumulator / step;
+}
+
+void motion_begin_step(Motion *motion, const SDL_Rect *rect) {
+    // Posição mudada fora dos passos (reinício, teleporte): começa dela, sem interpolar.
+    if (!motion->placed || (int)motion->x != rect->x || (int)motion->y != rect->y) {
+        motion->x = rect->x;
+        motion->y = rect->y;
+        motion->placed = true;
+    }
+    motion->prev_x = motion->x;
+    motion->prev_y = motion->y;
+}
+
+void motion_end_step(Motion *motion, const SDL_Rect *rect) {
+    motion->x = rect->x;
+    motion->y = rect->y;
+}
+
+SDL_FRect motion_rect(const Motion *motion, const SDL_Rect *rect, double alpha) {
+    if (!motion->placed || (int)motion->x != rect->x || (int)motion->y != rect->y) {
+        return (SDL_FRect){rect->x, rect->y, rect->w, rect->h};
+    }
+
+    // Desenha entre o penúltimo e o último passo; o atraso de um passo deixa o movimento contínuo.
+    float t = (float)alpha;
+    return (SDL_FRect){motion->prev_x + (motion->x - motion->prev_x) * t, motion->prev_y + (motion->y - motion->prev_y) * t, rect->w, rect->h};
+}
+
+double pacer_budget(const FramePacer *pacer, SDL_Window *window) {
+    if (pacer->mode == PACER_FIXED && pacer->target_fps > 0.0) return 1.0 / pacer->target_fps;
+
+    SDL_DisplayMode mode;
+    if (pacer->mode == PACER_VSYNC && SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0) {
+        return 1.0 / mode.refresh_rate;
+    }
+
+    return 1.0 / DEFAULT_FPS_CAP;
+}
+
+int choose_render_driver(SDL_Window *window, bool calibrate) {
+    const char *video = SDL_GetCurrentVideoDriver();
+    char *path = renderer_cache_path();
+    if (!video || !path) {
+        free(path);
+        return -1;
+    }
+
+    // Sem calibração, reaproveita a escolha salva se ela foi feita no mesmo driver de vídeo.
+    if (!calibrate) {
+        int index = -1;
+        char cached_video[64], cached_renderer[64];
+        FILE *file = fopen(path, "r");
+        if (file) {
+            if (fscanf(file, "%63s %63s", cached_video, cached_renderer) == 2 && strcmp(cached_video, video) == 0) {
+                index = find_render_driver(cached_renderer);
+            }
+            fclose(file);
+        }
+        free(path);
+        return index;
+    }
+
+    int best = -1;
+    double best_fps = 0.0;
+    SDL_RendererInfo info;
+    for (int i = 0; i < SDL_GetNumRenderDrivers(); i++) {
+        if (SDL_GetRenderDriverInfo(i, &info)) continue;
+
+        double fps = benchmark_render_driver(window, i);
+        if (fps <= 0.0) {
+            printf("Renderer %s: unavailable\n", info.name);
+            continue;
+        }
+        printf("Renderer %s: %.1f FPS\n", info.name, fps);
+        if (fps > best_fps) {
+            best_fps = fps;
+            best = i;
+        }
+    }
+
+    if (best >= 0 && SDL_GetRenderDriverInfo(best, &info) == 0) {
+        FILE *file = fopen(path, "w");
+        if (file) {
+            fprintf(file, "%s %s\n", video, info.name);
+            fclose(file);
+            printf("Using renderer %s (saved to %s)\n", info.name, path);
+        }
+        else {
+            fprintf(stderr, "Error saving renderer choice to %s\n", path);
+        }
+    }
+
+    free(path);
+    return best;
+}
+
+static double benchmark_render_driver(SDL_Window *window, int index) {
+    static const char *layer_files[] = {
+        "assets/sprites/scenario/sky-1.png", "assets/sprites/scenario/sun-1.png", "assets/sprites/scenario/clouds.png",
+        "assets/sprites/scenario/mountains-back.png", "assets/sprites/scenario/ocean-1.png", "assets/sprites/scenario/lake-1.png",
+    };
+    static const char *sprite_files[] = {
+        "assets/sprites/characters/meneghetti-front.png", "assets/sprites/characters/mr-python-front-1.png",
+        "assets/sprites/characters/chatgpt-front-1.png", "assets/sprites/scenario/palm-left.png",
+    };
+    const int layer_count = sizeof(layer_files) / sizeof(layer_files[0]);
+    const int sprite_count = sizeof(sprite_files) / sizeof(sprite_files[0]);
+
+    SDL_Renderer *render = SDL_CreateRenderer(window, index, SDL_RENDERER_TARGETTEXTURE);
+    if (!render) return 0.0;
+
+    // As texturas não passam pelo registro global porque morrem junto com este renderizador.
+    SDL_Texture *layers[sizeof(layer_files) / sizeof(layer_files[0])];
+    SDL_Texture *sprites[sizeof(sprite_files) / sizeof(sprite_files[0])];
+    for (int i = 0; i < layer_count; i++) layers[i] = IMG_LoadTexture(render, layer_files[i]);
+    for (int i = 0; i < sprite_count; i++) sprites[i] = IMG_LoadTexture(render, sprite_files[i]);
+
+    // Um quadro representativo: a pilha de camadas em tela cheia rolando e uma leva de sprites com alfa.
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 end = start + (Uint64)(CALIBRATION_TIME * (double)frequency);
+    Uint32 seed = 12345;
+    int frames = 0;
+    while (SDL_GetPerformanceCounter() < end) {
+        SDL_SetRenderDrawColor(render, 0, 0, 0, 255);
+        SDL_RenderClear(render);
+
+        for (int i = 0; i < layer_count; i++) {
+            if (!layers[i]) continue;
+            int offset = (frames * (i + 1)) % SCREEN_WIDTH;
+            SDL_RenderCopy(render, layers[i], NULL, &(SDL_Rect){-offset, 0, SCREEN_WIDTH, SCREEN_HEIGHT});
+            SDL_RenderCopy(render, layers[i], NULL, &(SDL_Rect){SCREEN_WIDTH - offset, 0, SCREEN_WIDTH, SCREEN_HEIGHT});
+        }
+
+        for (int i = 0; i < CALIBRATION_SPRITES; i++) {
+            SDL_Texture *sprite = sprites[i % sprite_count];
+            if (!sprite) continue;
+            seed = seed * 1103515245u + 12345u;
+            int x = (int)((seed >> 8) % SCREEN_WIDTH);
+            int y = (int)((seed >> 20) % SCREEN_HEIGHT);
+            SDL_RenderCopy(render, sprite, NULL, &(SDL_Rect){x - 16, y - 24, 32, 48});
+        }
+
+        SDL_RenderPresent(render);
+        frames++;
+    }
+    double elapsed = (double)(SDL_GetPerformanceCounter() - start) / (double)frequency;
+
+    for (int i = 0; i < layer_count; i++) if (layers[i]) SDL_DestroyTexture(layers[i]);
+    for (int i = 0; i < sprite_count; i++) if (sprites[i]) SDL_DestroyTexture(sprites[i]);
+    SDL_DestroyRenderer(render);
+
+    return elapsed > 0.0 ? frames / elapsed : 0.0;
+}
+
+static int find_render_driver(const char *name) {
+    SDL_RendererInfo info;
+    for (int i = 0; i < SDL_GetNumRenderDrivers(); i++) {
+        if (SDL_GetRenderDriverInfo(i, &info) == 0 && strcmp(info.name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static char *renderer_cache_path(void) {
+    char *dir = SDL_GetPrefPath(PREF_ORGANIZATION, PREF_APPLICATION);
+    if (!dir) {
+        fprintf(stderr, "Error getting preferences path: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    size_t length = strlen(dir) + strlen(CALIBRATION_FILE) + 1;
+    char *path = malloc(length);
+    if (path) snprintf(path, length, "%s%s", dir, CALIBRATION_FILE);
+    SDL_free(dir);
+    return path;
+}
+
+bool create_render_pipeline(SDL_Renderer *render, double budget) {
+    render_pipeline = (RenderPipeline){.scale = 1.0, .budget = budget, .raise_delay = RENDER_SCALE_RAISE_TIME};
+
+    if (!SDL_RenderTargetSupported(render)) return false;
+
+    render_pipeline.scene = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!render_pipeline.scene) {
+        fprintf(stderr, "Error creating scene target: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(render_pipeline.scene, SDL_BLENDMODE_NONE);
+    SDL_SetTextureScaleMode(render_pipeline.scene, SDL_ScaleModeNearest);
+    track_texture(render_pipeline.scene);
+
+    // O fundo reduzido é limpo para transparente, então as cores já saem pré-multiplicadas.
+    render_pipeline.background = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (render_pipeline.background) {
+        SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                                                 SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+        if (SDL_SetTextureBlendMode(render_pipeline.background, premultiplied) != 0) {
+            SDL_SetTextureBlendMode(render_pipeline.background, SDL_BLENDMODE_BLEND);
+        }
+        SDL_SetTextureScaleMode(render_pipeline.background, SDL_ScaleModeLinear);
+        track_texture(render_pipeline.background);
+    }
+
+    return true;
+}
+
+void begin_render_frame(SDL_Renderer *render) {
+    if (render_pipeline.scene) SDL_SetRenderTarget(render, render_pipeline.scene);
+}
+
+void present_render_frame(SDL_Renderer *render) {
+    if (render_pipeline.scene) {
+        // A cena ainda é o alvo: a leitura sai na resolução interna, antes da ampliação.
+        if (frame_capture) frame_capture_grab(frame_capture, render);
+
+        SDL_SetRenderTarget(render, NULL);
+
+        // Maior múltiplo inteiro que cabe na janela, centralizado com bordas pretas.
+        int output_w = SCREEN_WIDTH, output_h = SCREEN_HEIGHT;
+        SDL_GetRendererOutputSize(render, &output_w, &output_h);
+        int zoom = SDL_min(output_w / SCREEN_WIDTH, output_h / SCREEN_HEIGHT);
+
+        SDL_Rect dst;
+        if (zoom >= 1) {
+            dst = (SDL_Rect){(output_w - SCREEN_WIDTH * zoom) / 2, (output_h - SCREEN_HEIGHT * zoom) / 2, SCREEN_WIDTH * zoom, SCREEN_HEIGHT * zoom};
+        }
+        else {
+            // Janela menor que a resolução interna: encolhe mantendo a proporção.
+            double fit = SDL_min((double)output_w / SCREEN_WIDTH, (double)output_h / SCREEN_HEIGHT);
+            dst.w = (int)(SCREEN_WIDTH * fit);
+            dst.h = (int)(SCREEN_HEIGHT * fit);
+            dst.x = (output_w - dst.w) / 2;
+            dst.y = (output_h - dst.h) / 2;
+        }
+
+        SDL_SetRenderDrawColor(render, 0, 0, 0, 255);
+        SDL_RenderClear(render);
+        SDL_RenderCopy(render, render_pipeline.scene, NULL, &dst);
+    }
+
+    SDL_RenderPresent(render);
+}
+
+bool update_render_scale(double frame_time) {
+    if (!render_pipeline.background || render_pipeline.budget <= 0.0) return false;
+
+    double before = render_pipeline.scale;
+
+    if (frame_time > render_pipeline.budget * 1.1) {
+        render_pipeline.under_budget = 0.0;
+        render_pipeline.over_budget += frame_time;
+        if (render_pipeline.over_budget >= RENDER_SCALE_DROP_TIME && render_pipeline.scale > RENDER_SCALE_MIN) {
+            render_pipeline.scale = SDL_max(render_pipeline.scale - RENDER_SCALE_STEP, RENDER_SCALE_MIN);
+            render_pipeline.over_budget = 0.0;
+            // Estourou logo depois de subir: espera mais antes de tentar de novo.
+            render_pipeline.raise_delay = SDL_min(render_pipeline.raise_delay * 2.0, RENDER_SCALE_RAISE_MAX);
+        }
+    }
+    else {
+        render_pipeline.over_budget = 0.0;
+        render_pipeline.under_budget += frame_time;
+        if (render_pipeline.under_budget >= render_pipeline.raise_delay && render_pipeline.scale < 1.0) {
+            render_pipeline.scale = SDL_min(render_pipeline.scale + RENDER_SCALE_STEP, 1.0);
+            render_pipeline.under_budget = 0.0;
+        }
+        else if (render_pipeline.scale >= 1.0) {
+            render_pipeline.raise_delay = RENDER_SCALE_RAISE_TIME;
+        }
+    }
+
+    return render_pipeline.scale != before;
+}
+
+void mark_frame_dirty(void) {
+    frame_dirty = true;
+}
+
+void schedule_frame_wake(double seconds) {
+    // Guarda só o prazo mais próximo entre todos os pedidos do quadro.
+    if (seconds < 0.0) seconds = 0.0;
+    if (seconds < frame_wake_in) frame_wake_in = seconds;
+}
+
+void queue_copy(SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst, int layer, int depth) {
+    queue_copy_ex(texture, src, dst, 0.0, SDL_FLIP_NONE, layer, depth);
+}
+
+void queue_copy_ex(SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst, double angle, SDL_RendererFlip flip, int layer, int depth) {
+    if (!dst) return;
+
+    SDL_FRect fdst = {dst->x, dst->y, dst->w, dst->h};
+    queue_copy_exf(texture, src, &fdst, angle, flip, layer, depth);
+}
+
+void queue_copy_f(SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst, int layer, int depth) {
+    queue_copy_exf(texture, src, dst, 0.0, SDL_FLIP_NONE, layer, depth);
+}
+
+static void queue_copy_exf(SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst, double angle, SDL_RendererFlip flip, int layer, int depth) {
+    if (!texture || !dst) return;
+
+    if (render_commands_count >= MAX_RENDER_COMMANDS) {
+        render_commands_dropped++;
+        return;
+    }
+
+    SDL_Rect clipped_src = src ? *src : (SDL_Rect){0, 0, 0, 0};
+    bool has_src = (src != NULL);
+    SDL_FRect clipped_dst = *dst;
+
+    if (angle == 0.0) {
+        if (!clip_to_view(texture, &clipped_src, &has_src, &clipped_dst, flip)) return;
+    }
+    else {
+        // Rotacionados só são descartados pelo círculo que os envolve.
+        float radius = SDL_max(clipped_dst.w, clipped_dst.h);
+        float cx = clipped_dst.x + clipped_dst.w * 0.5f;
+        float cy = clipped_dst.y + clipped_dst.h * 0.5f;
+        if (cx + radius < 0 || cy + radius < 0 || cx - radius > SCREEN_WIDTH || cy - radius > SCREEN_HEIGHT) return;
+    }
+
+    RenderCommand *cmd = &render_commands[render_commands_count++];
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->type = RENDER_CMD_COPY;
+    cmd->layer = layer;
+    cmd->depth = depth;
+    cmd->sequence = render_commands_sequence++;
+    cmd->texture = texture;
+    cmd->has_src = has_src;
+    cmd->src = clipped_src;
+    cmd->dst = clipped_dst;
+    cmd->angle = angle;
+    cmd->flip = flip;
+
+    // Os modificadores são capturados agora: o comando desenha como se fosse imediato.
+    SDL_GetTextureBlendMode(texture, &cmd->blend);
+    SDL_GetTextureColorMod(texture, &cmd->color.r, &cmd->color.g, &cmd->color.b);
+    SDL_GetTextureAlphaMod(texture, &cmd->color.a);
+}
+
+void queue_fill(const SDL_Rect *rect, SDL_Color color, SDL_BlendMode blend, int layer, int depth) {
+    if (!rect) return;
+    if (rect->x >= SCREEN_WIDTH || rect->y >= SCREEN_HEIGHT || rect->x + rect->w <= 0 || rect->y + rect->h <= 0) return;
+
+    if (render_commands_count >= MAX_RENDER_COMMANDS) {
+        render_commands_dropped++;
+        return;
+    }
+
+    RenderCommand *cmd = &render_commands[render_commands_count++];
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->type = RENDER_CMD_FILL;
+    cmd->layer = layer;
+    cmd->depth = depth;
+    cmd->sequence = render_commands_sequence++;
+    cmd->blend = blend;
+    cmd->color = color;
+    cmd->dst = (SDL_FRect){rect->x, rect->y, rect->w, rect->h};
+}
+
+bool load_layer_stack(SDL_Renderer *render, LayerStack *stack, const char *dir) {
+    memset(stack, 0, sizeof(*stack));
+
+    FILE *file = fopen(dir, "r");
+    if (!file) {
+        fprintf(stderr, "Error opening layer file '%s'.\n", dir);
+        return false;
+    }
+
+    char line[512];
+    int line_number = 0;
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+
+        char *start = line;
+        while (*start == ' ' || *start == '\t') start++;
+        if (*start == '#' || *start == '\n' || *start == '\r' || *start == '\0') continue;
+
+        if (stack->count >= MAX_PARALLAX_LAYERS) {
+            fprintf(stderr, "%s:%d: too many layers (max %d).\n", dir, line_number, MAX_PARALLAX_LAYERS);
+            ok = false;
+            break;
+        }
+
+        ParallaxLayer *parallax = &stack->layers[stack->count];
+        char pattern[256], wrap[8], cache_flag[8];
+        int frames, opacity;
+
+        if (sscanf(start, "%31s %255s %d %lf %lf %lf %lf %lf %7s %d %7s", parallax->name, pattern, &frames, &parallax->frame_time,
+                   &parallax->factor_x, &parallax->factor_y, &parallax->velocity_x, &parallax->velocity_y, wrap, &opacity, cache_flag) != 11) {
+            fprintf(stderr, "%s:%d: expected 11 columns.\n", dir, line_number);
+            ok = false;
+            break;
+        }
+
+        // O padrão vira formato do snprintf: só um %d é aceito.
+        int percent = 0;
+        for (const char *c = pattern; *c; c++) {
+            if (*c == '%') percent++;
+        }
+        const char *marker = strstr(pattern, "%d");
+        if (frames < 1 || percent > 1 || (percent == 1 && !marker) || (frames > 1 && !marker)) {
+            fprintf(stderr, "%s:%d: invalid frame pattern '%s'.\n", dir, line_number, pattern);
+            ok = false;
+            break;
+        }
+
+        if (strcmp(wrap, "none") == 0) parallax->wrap = WRAP_NONE;
+        else if (strcmp(wrap, "x") == 0) parallax->wrap = WRAP_X;
+        else if (strcmp(wrap, "y") == 0) parallax->wrap = WRAP_Y;
+        else if (strcmp(wrap, "xy") == 0) parallax->wrap = WRAP_X | WRAP_Y;
+        else {
+            fprintf(stderr, "%s:%d: unknown wrap mode '%s'.\n", dir, line_number, wrap);
+            ok = false;
+            break;
+        }
+        parallax->cached = strcmp(cache_flag, "cache") == 0;
+        parallax->opacity = (Uint8)SDL_clamp(opacity, 0, 255);
+        memcpy(parallax->pattern, pattern, sizeof(parallax->pattern));
+
+        parallax->animation.frames = malloc(frames * sizeof(SDL_Texture *));
+        if (!parallax->animation.frames) {
+            fprintf(stderr, "Out of memory loading layers.\n");
+            ok = false;
+            break;
+        }
+        parallax->animation.count = frames;
+        stack->count++;
+
+        for (int i = 0; i < frames; i++) {
+            char path[300];
+            if (marker) snprintf(path, sizeof(path), pattern, i + 1);
+            else snprintf(path, sizeof(path), "%s", pattern);
+
+            SDL_Surface *surface = IMG_Load(path);
+            if (!surface) {
+                fprintf(stderr, "Error loading image '%s': %s\n", path, IMG_GetError());
+                ok = false;
+                break;
+            }
+
+            // Só camadas sem transparência global podem esconder o que está atrás delas.
+            if (parallax->opacity == 255 && !accumulate_opaque_mask(parallax, surface, i == 0)) {
+                free(parallax->opaque);
+                parallax->opaque = NULL;
+            }
+
+            SDL_Texture *texture = texture_from_surface(render, surface);
+            SDL_FreeSurface(surface);
+            if (!texture) {
+                ok = false;
+                break;
+            }
+            SDL_SetTextureAlphaMod(texture, parallax->opacity);
+            parallax->animation.frames[i] = texture;
+        }
+        if (ok) SDL_QueryTexture(parallax->animation.frames[0], NULL, NULL, &parallax->w, &parallax->h);
+    }
+
+    fclose(file);
+    if (!ok) destroy_layer_stack(stack);
+    return ok;
+}
+
+void destroy_layer_stack(LayerStack *stack) {
+    // As texturas são registradas e liberadas no encerramento; aqui só os vetores de quadros.
+    for (int i = 0; i < stack->count; i++) {
+        ParallaxLayer *parallax = &stack->layers[i];
+        free(parallax->animation.frames);
+        free(parallax->opaque);
+
+        if (parallax->pixels) {
+            for (int f = 0; f < parallax->animation.count; f++) {
+                if (parallax->pixels[f]) SDL_FreeSurface(parallax->pixels[f]);
+            }
+            free(parallax->pixels);
+        }
+    }
+    memset(stack, 0, sizeof(*stack));
+}
+
+void update_layer_stack(LayerStack *stack, double dt) {
+    for (int i = 0; i < stack->count; i++) {
+        ParallaxLayer *parallax = &stack->layers[i];
+
+        if (parallax->animation.count > 1) {
+            animate_sprite(&parallax->animation, dt, parallax->frame_time, false);
+        }
+
+        // A rolagem anda em pixels inteiros: só pede redesenho quando o deslocamento visível muda.
+        double speeds[2] = {parallax->velocity_x, parallax->velocity_y};
+        double *scrolls[2] = {&parallax->scroll_x, &parallax->scroll_y};
+        int sizes[2] = {parallax->w, parallax->h};
+        for (int axis = 0; axis < 2; axis++) {
+            if (speeds[axis] == 0.0) continue;
+
+            double before = floor(*scrolls[axis]);
+            *scrolls[axis] += speeds[axis] * dt;
+            if (sizes[axis] > 0 && (parallax->wrap & (axis == 0 ? WRAP_X : WRAP_Y))) {
+                *scrolls[axis] = fmod(*scrolls[axis], sizes[axis]);
+                if (*scrolls[axis] < 0.0) *scrolls[axis] += sizes[axis];
+            }
+            if (floor(*scrolls[axis]) != before) mark_frame_dirty();
+
+            double fraction = *scrolls[axis] - floor(*scrolls[axis]);
+            double distance = speeds[axis] > 0.0 ? 1.0 - fraction : fraction;
+            schedule_frame_wake(distance / fabs(speeds[axis]));
+        }
+    }
+}
+
+bool load_layer_pixels(LayerStack *stack) {
+    for (int i = 0; i < stack->count; i++) {
+        ParallaxLayer *parallax = &stack->layers[i];
+        if (parallax->pixels) continue;
+
+        parallax->pixels = calloc(parallax->animation.count, sizeof(SDL_Surface *));
+        if (!parallax->pixels) {
+            fprintf(stderr, "Out of memory loading layer pixels.\n");
+            return false;
+        }
+
+        bool numbered = strstr(parallax->pattern, "%d") != NULL;
+        for (int f = 0; f < parallax->animation.count; f++) {
+            char path[300];
+            if (numbered) snprintf(path, sizeof(path), parallax->pattern, f + 1);
+            else snprintf(path, sizeof(path), "%s", parallax->pattern);
+
+            parallax->pixels[f] = cpu_compositor_load_image(path, parallax->opacity);
+            if (!parallax->pixels[f]) return false;
+        }
+    }
+
+    return true;
+}
+
+int queue_layer_stack(SDL_Renderer *render, LayerStack *stack, BackgroundCache *cache, CpuCompositor *compositor, OcclusionGrid *occlusion, int camera_x, int camera_y, int layer) {
+    static SDL_Rect run_srcs[MAX_PARALLAX_LAYERS][MAX_LAYER_RUNS * 4];
+    static SDL_Rect run_dsts[MAX_PARALLAX_LAYERS][MAX_LAYER_RUNS * 4];
+    int run_counts[MAX_PARALLAX_LAYERS];
+    SDL_Rect screen_rect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+
+    int cached_end = 0;
+    while (cached_end < stack->count && stack->layers[cached_end].cached) cached_end++;
+
+    // De cima para baixo: cada camada só desenha as faixas que as de cima ainda não cobriram.
+    OcclusionGrid above_cache = *occlusion;
+    for (int i = stack->count - 1; i >= 0; i--) {
+        const ParallaxLayer *parallax = &stack->layers[i];
+        SDL_Rect piece_srcs[4], piece_dsts[4];
+        int pieces = layer_pieces(parallax, camera_x, camera_y, piece_srcs, piece_dsts);
+
+        if (i == cached_end - 1) above_cache = *occlusion;
+
+        run_counts[i] = 0;
+        for (int p = 0; p < pieces; p++) {
+            run_counts[i] += occlusion_runs(occlusion, &piece_srcs[p], &piece_dsts[p], &run_srcs[i][run_counts[i]], &run_dsts[i][run_counts[i]], MAX_LAYER_RUNS);
+        }
+        for (int p = 0; p < pieces; p++) {
+            occlusion_cover(occlusion, parallax->opaque, parallax->opaque_w, parallax->opaque_h, &piece_srcs[p], &piece_dsts[p]);
+        }
+    }
+
+    // Caminho da CPU: todas as camadas viram uma única textura, copiada de uma vez.
+    if (compositor && stack->count > 0 && stack->layers[0].pixels) {
+        static CompositorBlit blits[MAX_PARALLAX_LAYERS * MAX_LAYER_RUNS * 4];
+        int blit_count = 0;
+
+        for (int i = 0; i < stack->count; i++) {
+            const ParallaxLayer *parallax = &stack->layers[i];
+            const SDL_Surface *surface = parallax->pixels[parallax->animation.counter];
+
+            for (int r = 0; r < run_counts[i]; r++) {
+                blits[blit_count++] = (CompositorBlit){surface->pixels, surface->pitch / (int)sizeof(Uint32), run_srcs[i][r], run_dsts[i][r].x, run_dsts[i][r].y};
+            }
+        }
+
+        SDL_Texture *frame = cpu_compositor_render(compositor, blits, blit_count);
+        if (frame) {
+            queue_copy(frame, NULL, &screen_rect, layer, 0);
+            return 1;
+        }
+    }
+
+    SDL_Texture *textures[BACKGROUND_CACHE_PIECES];
+    SDL_Rect srcs[BACKGROUND_CACHE_PIECES];
+    SDL_Rect rects[BACKGROUND_CACHE_PIECES];
+    int cached_count = 0;
+    int first_direct = 0;
+
+    // As primeiras camadas marcadas com cache vão juntas para o render target do fundo.
+    while (first_direct < cached_end && cached_count + run_counts[first_direct] <= BACKGROUND_CACHE_PIECES) {
+        const ParallaxLayer *parallax = &stack->layers[first_direct];
+        for (int r = 0; r < run_counts[first_direct]; r++) {
+            textures[cached_count] = parallax->animation.frames[parallax->animation.counter];
+            srcs[cached_count] = run_srcs[first_direct][r];
+            rects[cached_count] = run_dsts[first_direct][r];
+            cached_count++;
+        }
+        first_direct++;
+    }
+
+    int depth = 0;
+    SDL_Texture *background = cached_count > 0 ? compose_background_cache(render, cache, textures, srcs, rects, cached_count) : NULL;
+    if (background) {
+        // Do cache só saem as faixas que as camadas diretas deixam à mostra.
+        SDL_Rect cache_srcs[MAX_LAYER_RUNS], cache_dsts[MAX_LAYER_RUNS];
+        int cache_runs = occlusion_runs(&above_cache, &screen_rect, &screen_rect, cache_srcs, cache_dsts, MAX_LAYER_RUNS);
+        for (int r = 0; r < cache_runs; r++) {
+            queue_copy(background, &cache_srcs[r], &cache_dsts[r], layer, depth);
+        }
+        depth++;
+    }
+    else {
+        first_direct = 0;
+    }
+
+    for (int i = first_direct; i < stack->count; i++) {
+        const ParallaxLayer *parallax = &stack->layers[i];
+        for (int r = 0; r < run_counts[i]; r++) {
+            queue_copy(parallax->animation.frames[parallax->animation.counter], &run_srcs[i][r], &run_dsts[i][r], layer, depth);
+        }
+        depth++;
+    }
+
+    return depth;
+}
+
+static int layer_pieces(const ParallaxLayer *parallax, int camera_x, int camera_y, SDL_Rect srcs[4], SDL_Rect dsts[4]) {
+    int base_x = (int)(camera_x * parallax->factor_x);
+    int base_y = (int)(camera_y * parallax->factor_y);
+    int offset_x = (int)floor(parallax->scroll_x);
+    int offset_y = (int)floor(parallax->scroll_y);
+
+    int src_x[2] = {0}, dst_x[2] = {0}, len_x[2] = {parallax->w};
+    int src_y[2] = {0}, dst_y[2] = {0}, len_y[2] = {parallax->h};
+    int count_x = 1, count_y = 1;
+
+    // Camadas repetidas não se movem: o retângulo de origem é que rola dentro delas.
+    if (parallax->wrap & WRAP_X) count_x = wrap_spans(offset_x, parallax->w, src_x, dst_x, len_x);
+    else base_x += offset_x;
+    if (parallax->wrap & WRAP_Y) count_y = wrap_spans(offset_y, parallax->h, src_y, dst_y, len_y);
+    else base_y += offset_y;
+
+    int pieces = 0;
+    for (int y = 0; y < count_y; y++) {
+        for (int x = 0; x < count_x; x++) {
+            srcs[pieces] = (SDL_Rect){src_x[x], src_y[y], len_x[x], len_y[y]};
+            dsts[pieces] = (SDL_Rect){base_x + dst_x[x], base_y + dst_y[y], len_x[x], len_y[y]};
+            pieces++;
+        }
+    }
+
+    return pieces;
+}
+
+static int wrap_spans(int offset, int size, int src_start[2], int dst_start[2], int length[2]) {
+    if (size <= 0) return 0;
+
+    offset %= size;
+    if (offset < 0) offset += size;
+    if (offset == 0) {
+        src_start[0] = 0;
+        dst_start[0] = 0;
+        length[0] = size;
+        return 1;
+    }
+
+    // O fim da textura aparece no começo da camada e o começo dela é empurrado para a direita.
+    src_start[0] = size - offset;
+    dst_start[0] = 0;
+    length[0] = offset;
+    src_start[1] = 0;
+    dst_start[1] = offset;
+    length[1] = size - offset;
+    return 2;
+}
+
+static bool accumulate_opaque_mask(ParallaxLayer *parallax, SDL_Surface *surface, bool first_frame) {
+    SDL_Surface *image = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!image) return false;
+
+    int tiles_w = (image->w + TILE_SIZE - 1) / TILE_SIZE;
+    int tiles_h = (image->h + TILE_SIZE - 1) / TILE_SIZE;
+
+    if (first_frame) {
+        free(parallax->opaque);
+        parallax->opaque = malloc(tiles_w * tiles_h);
+        parallax->opaque_w = tiles_w;
+        parallax->opaque_h = tiles_h;
+        if (parallax->opaque) memset(parallax->opaque, 1, tiles_w * tiles_h);
+    }
+    if (!parallax->opaque || tiles_w != parallax->opaque_w || tiles_h != parallax->opaque_h) {
+        SDL_FreeSurface(image);
+        return false;
+    }
+
+    // Um tile é opaco se todos os seus pixels são, em todos os quadros da animação.
+    for (int ty = 0; ty < tiles_h; ty++) {
+        for (int tx = 0; tx < tiles_w; tx++) {
+            Uint8 *tile = &parallax->opaque[ty * tiles_w + tx];
+            if (!*tile) continue;
+
+            if ((tx + 1) * TILE_SIZE > image->w || (ty + 1) * TILE_SIZE > image->h) {
+                *tile = 0;
+                continue;
+            }
+            for (int y = 0; y < TILE_SIZE && *tile; y++) {
+                const Uint32 *row = (const Uint32 *)((const Uint8 *)image->pixels + (ty * TILE_SIZE + y) * image->pitch) + tx * TILE_SIZE;
+                for (int x = 0; x < TILE_SIZE; x++) {
+                    if ((row[x] >> 24) != 0xFF) {
+                        *tile = 0;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    SDL_FreeSurface(image);
+    return true;
+}
+
+void occlusion_reset(OcclusionGrid *grid) {
+    memset(grid, 0, sizeof(*grid));
+}
+
+void occlusion_cover(OcclusionGrid *grid, const Uint8 *opaque, int tiles_w, int tiles_h, const SDL_Rect *src, const SDL_Rect *dst) {
+    if (!opaque) return;
+
+    // Só células inteiramente dentro do pedaço desenhado podem ser cobertas por ele.
+    int right = dst->x + dst->w;
+    int bottom = dst->y + dst->h;
+    int col_start = dst->x <= 0 ? 0 : (dst->x + OCCLUSION_CELL - 1) / OCCLUSION_CELL;
+    int row_start = dst->y <= 0 ? 0 : (dst->y + OCCLUSION_CELL - 1) / OCCLUSION_CELL;
+    int col_end = right <= 0 ? 0 : SDL_min(right / OCCLUSION_CELL, OCCLUSION_COLUMNS);
+    int row_end = bottom <= 0 ? 0 : SDL_min(bottom / OCCLUSION_CELL, OCCLUSION_ROWS);
+
+    for (int row = row_start; row < row_end; row++) {
+        int image_y = row * OCCLUSION_CELL - dst->y + src->y;
+        int ty0 = image_y / TILE_SIZE;
+        int ty1 = (image_y + OCCLUSION_CELL - 1) / TILE_SIZE;
+        if (image_y < 0 || ty1 >= tiles_h) continue;
+
+        for (int col = col_start; col < col_end; col++) {
+            if (grid->covered[row][col]) continue;
+
+            int image_x = col * OCCLUSION_CELL - dst->x + src->x;
+            int tx0 = image_x / TILE_SIZE;
+            int tx1 = (image_x + OCCLUSION_CELL - 1) / TILE_SIZE;
+            if (image_x < 0 || tx1 >= tiles_w) continue;
+
+            bool covered = true;
+            for (int ty = ty0; ty <= ty1 && covered; ty++) {
+                for (int tx = tx0; tx <= tx1; tx++) {
+                    if (!opaque[ty * tiles_w + tx]) {
+                        covered = false;
+                        break;
+                    }
+                }
+            }
+            grid->covered[row][col] = covered;
+        }
+    }
+}
+
+int occlusion_runs(const OcclusionGrid *grid, const SDL_Rect *src, const SDL_Rect *dst, SDL_Rect out_srcs[], SDL_Rect out_dsts[], int capacity) {
+    SDL_Rect screen = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    SDL_Rect visible;
+    if (capacity <= 0 || !SDL_IntersectRect(dst, &screen, &visible)) return 0;
+
+    int col_start = visible.x / OCCLUSION_CELL;
+    int col_end = (visible.x + visible.w - 1) / OCCLUSION_CELL;
+    int row_start = visible.y / OCCLUSION_CELL;
+    int row_end = (visible.y + visible.h - 1) / OCCLUSION_CELL;
+    int count = 0;
+    bool overflow = false;
+
+    for (int row = row_start; row <= row_end && !overflow; row++) {
+        int y0 = SDL_max(visible.y, row * OCCLUSION_CELL);
+        int y1 = SDL_min(visible.y + visible.h, (row + 1) * OCCLUSION_CELL);
+
+        for (int col = col_start; col <= col_end;) {
+            if (grid->covered[row][col]) {
+                col++;
+                continue;
+            }
+
+            int run_start = col;
+            while (col <= col_end && !grid->covered[row][col]) col++;
+            int x0 = SDL_max(visible.x, run_start * OCCLUSION_CELL);
+            int x1 = SDL_min(visible.x + visible.w, col * OCCLUSION_CELL);
+
+            // Faixas iguais em linhas seguidas viram um retângulo só.
+            bool merged = false;
+            for (int k = 0; k < count; k++) {
+                SDL_Rect *open = &out_dsts[k];
+                if (open->x == x0 && open->w == x1 - x0 && open->y + open->h == y0) {
+                    open->h += y1 - y0;
+                    merged = true;
+                    break;
+                }
+            }
+            if (merged) continue;
+
+            if (count == capacity) {
+                overflow = true;
+                break;
+            }
+            out_dsts[count++] = (SDL_Rect){x0, y0, x1 - x0, y1 - y0};
+        }
+    }
+
+    // Recortado demais para caber: desenhar o pedaço visível inteiro continua correto.
+    if (overflow) {
+        out_dsts[0] = visible;
+        count = 1;
+    }
+
+    for (int k = 0; k < count; k++) {
+        out_srcs[k] = (SDL_Rect){src->x + out_dsts[k].x - dst->x, src->y + out_dsts[k].y - dst->y, out_dsts[k].w, out_dsts[k].h};
+    }
+
+    return count;
+}
+
+bool load_tilemap(SDL_Renderer *render, Tilemap *map, const char *dir, const SDL_Rect solids[], int solid_count, const SDL_Rect surfaces[], int surface_count) {
+    memset(map, 0, sizeof(*map));
+
+    SDL_Surface *loaded = IMG_Load(dir);
+    if (!loaded) {
+        fprintf(stderr, "Error loading image '%s': %s\n", dir, IMG_GetError());
+        return false;
+    }
+    SDL_Surface *image = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (!image) {
+        fprintf(stderr, "Error converting map image: %s\n", SDL_GetError());
+        return false;
+    }
+
+    map->width = (image->w + TILE_SIZE - 1) / TILE_SIZE;
+    map->height = (image->h + TILE_SIZE - 1) / TILE_SIZE;
+    map->chunks_w = (map->width + CHUNK_TILES - 1) / CHUNK_TILES;
+    map->chunks_h = (map->height + CHUNK_TILES - 1) / CHUNK_TILES;
+
+    int cell_count = map->width * map->height;
+    int tile_pixels = TILE_SIZE * TILE_SIZE;
+    int table_size = 1;
+    while (table_size < cell_count * 2) table_size <<= 1;
+
+    map->tiles = calloc(cell_count, sizeof(*map->tiles));
+    map->materials = malloc((size_t)cell_count * tile_pixels * sizeof(*map->materials));
+    map->masks = calloc(cell_count, sizeof(*map->masks));
+    map->opaque = calloc(cell_count, sizeof(*map->opaque));
+    map->chunks = calloc(map->chunks_w * map->chunks_h, sizeof(*map->chunks));
+
+    // Tiles únicos em sequência (o 0 é o tile transparente) e uma tabela hash para achá-los.
+    Uint32 *unique = malloc((size_t)(cell_count + 1) * tile_pixels * sizeof(Uint32));
+    Uint32 *unique_hashes = malloc((cell_count + 1) * sizeof(Uint32));
+    int *table = calloc(table_size, sizeof(int));
+
+    if (!map->tiles || !map->materials || !map->masks || !map->opaque || !map->chunks || !unique || !unique_hashes || !table) {
+        fprintf(stderr, "Out of memory building the tile map.\n");
+        free(unique);
+        free(unique_hashes);
+        free(table);
+        SDL_FreeSurface(image);
+        destroy_tilemap(map);
+        return false;
+    }
+
+    int unique_count = 1;
+    Uint32 tile[TILE_SIZE * TILE_SIZE];
+
+    for (int ty = 0; ty < map->height; ty++) {
+        for (int tx = 0; tx < map->width; tx++) {
+            bool empty = true;
+            bool opaque = true;
+            for (int y = 0; y < TILE_SIZE; y++) {
+                for (int x = 0; x < TILE_SIZE; x++) {
+                    int px = tx * TILE_SIZE + x;
+                    int py = ty * TILE_SIZE + y;
+                    Uint32 pixel = 0;
+                    if (px < image->w && py < image->h) {
+                        pixel = ((const Uint32 *)((const Uint8 *)image->pixels + py * image->pitch))[px];
+                    }
+                    if (((const Uint8 *)&pixel)[3] != 0) empty = false;
+                    if (((const Uint8 *)&pixel)[3] != 255) opaque = false;
+                    tile[y * TILE_SIZE + x] = pixel;
+                }
+            }
+            if (empty) continue;
+            map->opaque[ty * map->width + tx] = opaque;
+
+            Uint32 hash = hash_tile(tile, TILE_SIZE);
+            int slot = hash & (table_size - 1);
+            while (table[slot] != 0) {
+                int candidate = table[slot];
+                if (unique_hashes[candidate] == hash && memcmp(&unique[candidate * tile_pixels], tile, sizeof(tile)) == 0) break;
+                slot = (slot + 1) & (table_size - 1);
+            }
+
+            if (table[slot] == 0) {
+                memcpy(&unique[unique_count * tile_pixels], tile, sizeof(tile));
+                unique_hashes[unique_count] = hash;
+                table[slot] = unique_count++;
+            }
+            map->tiles[ty * map->width + tx] = (Uint16)table[slot];
+        }
+    }
+    SDL_FreeSurface(image);
+    free(table);
+    free(unique_hashes);
+
+    // ATLAS: cada tile ganha uma borda de 1px repetida para não sangrar o vizinho ao escalar.
+    int cell = TILE_SIZE + 2;
+    int atlas_rows = (unique_count + TILESET_COLUMNS - 1) / TILESET_COLUMNS;
+    int atlas_w = TILESET_COLUMNS * cell;
+    int atlas_h = atlas_rows * cell;
+
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(render, &info) == 0 && info.max_texture_height > 0 && atlas_h > info.max_texture_height) {
+        fprintf(stderr, "Tileset too large: %d unique tiles.\n", unique_count);
+        free(unique);
+        destroy_tilemap(map);
+        return false;
+    }
+
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, atlas_w, atlas_h, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!atlas) {
+        fprintf(stderr, "Error creating tileset surface: %s\n", SDL_GetError());
+        free(unique);
+        destroy_tilemap(map);
+        return false;
+    }
+    memset(atlas->pixels, 0, atlas->h * atlas->pitch);
+
+    for (int i = 1; i < unique_count; i++) {
+        int ox = (i % TILESET_COLUMNS) * cell;
+        int oy = (i / TILESET_COLUMNS) * cell;
+        for (int y = -1; y <= TILE_SIZE; y++) {
+            Uint32 *row = (Uint32 *)((Uint8 *)atlas->pixels + (oy + 1 + y) * atlas->pitch);
+            int sy = SDL_clamp(y, 0, TILE_SIZE - 1);
+            for (int x = -1; x <= TILE_SIZE; x++) {
+                int sx = SDL_clamp(x, 0, TILE_SIZE - 1);
+                row[ox + 1 + x] = unique[i * tile_pixels + sy * TILE_SIZE + sx];
+            }
+        }
+    }
+    free(unique);
+
+    map->tileset = SDL_CreateTextureFromSurface(render, atlas);
+    SDL_FreeSurface(atlas);
+    if (!map->tileset) {
+        fprintf(stderr, "Error creating tileset texture: %s\n", SDL_GetError());
+        destroy_tilemap(map);
+        return false;
+    }
+    SDL_SetTextureBlendMode(map->tileset, SDL_BLENDMODE_BLEND);
+    track_texture(map->tileset);
+
+    // MATERIAL POR PIXEL: as superfícies são pintadas em ordem, como retângulos sobre o mapa.
+    SDL_Rect map_area = {0, 0, map->width * TILE_SIZE, map->height * TILE_SIZE};
+    memset(map->materials, -1, (size_t)map_area.w * map_area.h);
+    for (int i = 0; i < surface_count; i++) {
+        SDL_Rect overlap;
+        if (!SDL_IntersectRect(&map_area, &surfaces[i], &overlap)) continue;
+
+        for (int y = overlap.y; y < overlap.y + overlap.h; y++) {
+            memset(&map->materials[y * map_area.w + overlap.x], i, overlap.w);
+        }
+    }
+
+    // COLISÃO POR TILE (COM PRECISÃO DE PIXEL):
+    for (int ty = 0; ty < map->height; ty++) {
+        for (int tx = 0; tx < map->width; tx++) {
+            int index = ty * map->width + tx;
+            SDL_Rect area = {tx * TILE_SIZE, ty * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+
+            for (int i = 0; i < solid_count; i++) {
+                SDL_Rect overlap;
+                if (!SDL_IntersectRect(&area, &solids[i], &overlap)) continue;
+
+                Uint16 span = (Uint16)(((1u << overlap.w) - 1u) << (overlap.x - area.x));
+                for (int y = overlap.y - area.y; y < overlap.y - area.y + overlap.h; y++) {
+                    map->masks[index][y] |= span;
+                }
+            }
+        }
+    }
+
+    // CHUNKS: os vértices ficam prontos em coordenadas do mapa, só falta deslocar pela câmera.
+    for (int cy = 0; cy < map->chunks_h; cy++) {
+        for (int cx = 0; cx < map->chunks_w; cx++) {
+            TileChunk *chunk = &map->chunks[cy * map->chunks_w + cx];
+            int tx_end = SDL_min((cx + 1) * CHUNK_TILES, map->width);
+            int ty_end = SDL_min((cy + 1) * CHUNK_TILES, map->height);
+
+            int quads = 0;
+            for (int ty = cy * CHUNK_TILES; ty < ty_end; ty++) {
+                for (int tx = cx * CHUNK_TILES; tx < tx_end; tx++) {
+                    if (map->tiles[ty * map->width + tx] != 0) quads++;
+                }
+            }
+            if (quads == 0) continue;
+
+            chunk->vertices = malloc(quads * 4 * sizeof(SDL_Vertex));
+            if (!chunk->vertices) {
+                fprintf(stderr, "Out of memory building the tile map.\n");
+                destroy_tilemap(map);
+                return false;
+            }
+
+            SDL_Color white = {255, 255, 255, 255};
+            for (int ty = cy * CHUNK_TILES; ty < ty_end; ty++) {
+                for (int tx = cx * CHUNK_TILES; tx < tx_end; tx++) {
+                    int id = map->tiles[ty * map->width + tx];
+                    if (id == 0) continue;
+
+                    float x0 = (float)(tx * TILE_SIZE);
+                    float y0 = (float)(ty * TILE_SIZE);
+                    float x1 = x0 + TILE_SIZE;
+                    float y1 = y0 + TILE_SIZE;
+                    float u0 = (float)((id % TILESET_COLUMNS) * cell + 1) / atlas_w;
+                    float v0 = (float)((id / TILESET_COLUMNS) * cell + 1) / atlas_h;
+                    float u1 = u0 + (float)TILE_SIZE / atlas_w;
+                    float v1 = v0 + (float)TILE_SIZE / atlas_h;
+
+                    SDL_Vertex *v = &chunk->vertices[chunk->quad_count * 4];
+                    v[0] = (SDL_Vertex){{x0, y0}, white, {u0, v0}};
+                    v[1] = (SDL_Vertex){{x1, y0}, white, {u1, v0}};
+                    v[2] = (SDL_Vertex){{x1, y1}, white, {u1, v1}};
+                    v[3] = (SDL_Vertex){{x0, y1}, white, {u0, v1}};
+                    chunk->quad_count++;
+                }
+            }
+        }
+    }
+
+    // Pior caso visível: chunks cortados nas duas bordas da tela.
+    int chunk_px = CHUNK_TILES * TILE_SIZE;
+    map->scratch_quads = (SCREEN_WIDTH / chunk_px + 2) * (SCREEN_HEIGHT / chunk_px + 2) * CHUNK_TILES * CHUNK_TILES;
+    map->scratch = malloc(map->scratch_quads * 4 * sizeof(SDL_Vertex));
+    map->indices = malloc(map->scratch_quads * 6 * sizeof(int));
+    if (!map->scratch || !map->indices) {
+        fprintf(stderr, "Out of memory building the tile map.\n");
+        destroy_tilemap(map);
+        return false;
+    }
+    for (int q = 0; q < map->scratch_quads; q++) {
+        int *idx = &map->indices[q * 6];
+        idx[0] = q * 4 + 0;
+        idx[1] = q * 4 + 1;
+        idx[2] = q * 4 + 2;
+        idx[3] = q * 4 + 0;
+        idx[4] = q * 4 + 2;
+        idx[5] = q * 4 + 3;
+    }
+
+    return true;
+}
+
+void destroy_tilemap(Tilemap *map) {
+    if (map->chunks) {
+        for (int i = 0; i < map->chunks_w * map->chunks_h; i++) {
+            free(map->chunks[i].vertices);
+        }
+    }
+    free(map->chunks);
+    free(map->tiles);
+    free(map->materials);
+    free(map->masks);
+    free(map->opaque);
+    free(map->scratch);
+    free(map->indices);
+
+    // O tileset é liberado junto com as demais texturas registradas.
+    memset(map, 0, sizeof(*map));
+}
+
+void tilemap_queue(Tilemap *map, int origin_x, int origin_y, int layer, int depth) {
+    if (!map->tileset || !map->scratch) return;
+
+    // Só os chunks que cruzam a tela: o custo depende da tela, não do tamanho do mapa.
+    int chunk_px = CHUNK_TILES * TILE_SIZE;
+    int first_cx = SDL_max(0, (int)floorf((float)-origin_x / chunk_px));
+    int first_cy = SDL_max(0, (int)floorf((float)-origin_y / chunk_px));
+    int last_cx = SDL_min(map->chunks_w - 1, (int)floorf((float)(SCREEN_WIDTH - 1 - origin_x) / chunk_px));
+    int last_cy = SDL_min(map->chunks_h - 1, (int)floorf((float)(SCREEN_HEIGHT - 1 - origin_y) / chunk_px));
+
+    int quads = 0;
+    for (int cy = first_cy; cy <= last_cy; cy++) {
+        for (int cx = first_cx; cx <= last_cx; cx++) {
+            const TileChunk *chunk = &map->chunks[cy * map->chunks_w + cx];
+            if (chunk->quad_count == 0 || quads + chunk->quad_count > map->scratch_quads) continue;
+
+            SDL_Vertex *out = &map->scratch[quads * 4];
+            for (int i = 0; i < chunk->quad_count * 4; i++) {
+                out[i] = chunk->vertices[i];
+                out[i].position.x += (float)origin_x;
+                out[i].position.y += (float)origin_y;
+            }
+            quads += chunk->quad_count;
+        }
+    }
+
+    queue_geometry(map->tileset, map->scratch, quads * 4, map->indices, quads * 6, layer, depth);
+}
+
+bool tilemap_collides(const Tilemap *map, const SDL_Rect *rect, int origin_x, int origin_y) {
+    if (!map->masks) return false;
+
+    int x0 = SDL_max(rect->x - origin_x, 0);
+    int y0 = SDL_max(rect->y - origin_y, 0);
+    int x1 = SDL_min(rect->x - origin_x + rect->w, map->width * TILE_SIZE);
+    int y1 = SDL_min(rect->y - origin_y + rect->h, map->height * TILE_SIZE);
+    if (x0 >= x1 || y0 >= y1) return false;
+
+    for (int ty = y0 / TILE_SIZE; ty <= (y1 - 1) / TILE_SIZE; ty++) {
+        int row_start = SDL_max(y0, ty * TILE_SIZE) - ty * TILE_SIZE;
+        int row_end = SDL_min(y1, (ty + 1) * TILE_SIZE) - ty * TILE_SIZE;
+
+        for (int tx = x0 / TILE_SIZE; tx <= (x1 - 1) / TILE_SIZE; tx++) {
+            int col_start = SDL_max(x0, tx * TILE_SIZE) - tx * TILE_SIZE;
+            int col_end = SDL_min(x1, (tx + 1) * TILE_SIZE) - tx * TILE_SIZE;
+            Uint16 span = (Uint16)(((1u << (col_end - col_start)) - 1u) << col_start);
+
+            const Uint16 *mask = map->masks[ty * map->width + tx];
+            for (int y = row_start; y < row_end; y++) {
+                if (mask[y] & span) return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void tilemap_occlude(const Tilemap *map, OcclusionGrid *grid, int origin_x, int origin_y) {
+    SDL_Rect src = {0, 0, map->width * TILE_SIZE, map->height * TILE_SIZE};
+    SDL_Rect dst = {origin_x, origin_y, src.w, src.h};
+    occlusion_cover(grid, map->opaque, map->width, map->height, &src, &dst);
+}
+
+int tilemap_material(const Tilemap *map, const SDL_Rect *rect, int origin_x, int origin_y) {
+    if (!map->materials) return -1;
+
+    // Amostra os pixels sob o retângulo (os pés): vence o material com mais pixels, como na detecção por retângulos.
+    int areas[SCHAR_MAX + 1] = {0};
+    int best = -1;
+    int map_w = map->width * TILE_SIZE;
+
+    int x0 = SDL_max(rect->x - origin_x, 0);
+    int y0 = SDL_max(rect->y - origin_y, 0);
+    int x1 = SDL_min(rect->x - origin_x + rect->w, map_w);
+    int y1 = SDL_min(rect->y - origin_y + rect->h, map->height * TILE_SIZE);
+    if (x0 >= x1 || y0 >= y1) return -1;
+
+    for (int y = y0; y < y1; y++) {
+        const Sint8 *row = &map->materials[y * map_w];
+        for (int x = x0; x < x1; x++) {
+            int material = row[x];
+            if (material < 0) continue;
+
+            areas[material]++;
+            if (best < 0 || areas[material] > areas[best]) best = material;
+        }
+    }
+
+    return best;
+}
+
+static Uint32 hash_tile(const Uint32 *pixels, int width) {
+    // FNV-1a sobre os pixels do tile.
+    Uint32 hash = 2166136261u;
+    for (int i = 0; i < width * TILE_SIZE; i++) {
+        hash ^= pixels[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void enemy_bob(Enemy *enemy, int base_y, double phase) {
+    for (int i = 0; i < ENEMY_PARTS; i++) {
+        enemy->collision[i].y = (int)(base_y + enemy->bob[i] * sin(phase));
+    }
+}
+
+void bake_enemy_composites(SDL_Renderer *render, Enemy *enemy, int base_y) {
+    // Amostra o balanço ao longo de um ciclo: cada combinação de deslocamentos vira um quadro pronto.
+    for (int state = 0; state < enemy->texture_amount; state++) {
+        bool complete = true;
+        for (int i = 0; i < ENEMY_PARTS; i++) {
+            if (!enemy->textures[state][i]) complete = false;
+        }
+        if (!complete) continue;
+
+        for (int k = 0; k < ENEMY_BOB_SAMPLES; k++) {
+            double phase = 2.0 * M_PI * k / ENEMY_BOB_SAMPLES;
+            int ys[ENEMY_PARTS];
+            int top = INT_MAX;
+            for (int i = 0; i < ENEMY_PARTS; i++) {
+                ys[i] = (int)(base_y + enemy->bob[i] * sin(phase));
+                if (ys[i] < top) top = ys[i];
+            }
+
+            int offsets[ENEMY_PARTS];
+            for (int i = 0; i < ENEMY_PARTS; i++) {
+                offsets[i] = ys[i] - top;
+            }
+            if (!find_enemy_composite(enemy, state, offsets) && !bake_enemy_composite(render, enemy, state, offsets)) return;
+        }
+    }
+}
+
+void redraw_enemy_composites(SDL_Renderer *render, Enemy *enemy) {
+    for (int i = 0; i < enemy->composite_count; i++) {
+        draw_enemy_composite(render, enemy, &enemy->composites[i]);
+    }
+}
+
+void queue_enemy(SDL_Renderer *render, Enemy *enemy, int layer, int depth) {
+    SDL_Texture **parts = enemy->textures[enemy->animation_status];
+    const SDL_Rect *base = &enemy->collision[0];
+
+    // As partes só viram um quadro pronto enquanto andam juntas na horizontal.
+    bool rigid = true;
+    int top = base->y;
+    for (int i = 0; i < ENEMY_PARTS; i++) {
+        const SDL_Rect *part = &enemy->collision[i];
+        if (!parts[i] || part->x != base->x || part->w != base->w || part->h != base->h) rigid = false;
+        if (part->y < top) top = part->y;
+    }
+
+    if (rigid) {
+        int offsets[ENEMY_PARTS];
+        for (int i = 0; i < ENEMY_PARTS; i++) {
+            offsets[i] = enemy->collision[i].y - top;
+        }
+
+        EnemyComposite *composite = find_enemy_composite(enemy, enemy->animation_status, offsets);
+        if (!composite) composite = bake_enemy_composite(render, enemy, enemy->animation_status, offsets);
+        if (composite) {
+            SDL_Rect dst = {base->x, top, composite->w, composite->h};
+            queue_copy(composite->texture, NULL, &dst, layer, depth);
+            return;
+        }
+    }
+
+    for (int i = 0; i < ENEMY_PARTS; i++) {
+        queue_copy(parts[i], NULL, &enemy->collision[i], layer, depth + i);
+    }
+}
+
+static EnemyComposite *find_enemy_composite(Enemy *enemy, int state, const int offsets[ENEMY_PARTS]) {
+    for (int i = 0; i < enemy->composite_count; i++) {
+        EnemyComposite *composite = &enemy->composites[i];
+        if (composite->state == state && composite->w == enemy->collision[0].w && composite->part_h == enemy->collision[0].h &&
+            memcmp(composite->offsets, offsets, sizeof(composite->offsets)) == 0) {
+            return composite;
+        }
+    }
+
+    return NULL;
+}
+
+static EnemyComposite *bake_enemy_composite(SDL_Renderer *render, Enemy *enemy, int state, const int offsets[ENEMY_PARTS]) {
+    if (enemy->composite_count >= MAX_ENEMY_COMPOSITES || !SDL_RenderTargetSupported(render)) return NULL;
+
+    int span = 0;
+    for (int i = 0; i < ENEMY_PARTS; i++) {
+        if (offsets[i] > span) span = offsets[i];
+    }
+
+    EnemyComposite *composite = &enemy->composites[enemy->composite_count];
+    composite->state = state;
+    composite->w = enemy->collision[0].w;
+    composite->part_h = enemy->collision[0].h;
+    composite->h = composite->part_h + span;
+    memcpy(composite->offsets, offsets, sizeof(composite->offsets));
+
+    composite->texture = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, composite->w, composite->h);
+    if (!composite->texture) {
+        fprintf(stderr, "Error creating enemy composite: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    // O quadro é montado sobre transparente, então as cores já saem pré-multiplicadas.
+    SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                                             SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    if (SDL_SetTextureBlendMode(composite->texture, premultiplied) != 0) {
+        SDL_SetTextureBlendMode(composite->texture, SDL_BLENDMODE_BLEND);
+    }
+
+    // Só entra no registro depois de pronto: uma falha libera a textura e o slot fica livre de verdade.
+    if (!draw_enemy_composite(render, enemy, composite)) {
+        SDL_DestroyTexture(composite->texture);
+        composite->texture = NULL;
+        return NULL;
+    }
+    track_texture(composite->texture);
+
+    enemy->composite_count++;
+    return composite;
+}
+
+static bool draw_enemy_composite(SDL_Renderer *render, const Enemy *enemy, const EnemyComposite *composite) {
+    SDL_Texture *previous = SDL_GetRenderTarget(render);
+    if (SDL_SetRenderTarget(render, composite->texture) != 0) {
+        fprintf(stderr, "Error binding enemy composite: %s\n", SDL_GetError());
+        return false;
+    }
+
+    Uint8 old_r, old_g, old_b, old_a;
+    SDL_GetRenderDrawColor(render, &old_r, &old_g, &old_b, &old_a);
+    SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
+    SDL_RenderClear(render);
+
+    // Mesma ordem do desenho por partes: braços, pernas, cabeça e tronco.
+    for (int i = 0; i < ENEMY_PARTS; i++) {
+        SDL_Rect dst = {0, composite->offsets[i], composite->w, composite->part_h};
+        SDL_RenderCopy(render, enemy->textures[composite->state][i], NULL, &dst);
+    }
+
+    SDL_SetRenderDrawColor(render, old_r, old_g, old_b, old_a);
+    SDL_SetRenderTarget(render, previous);
+    return true;
+}
+
+DepthEntry *depth_list_add(DepthList *list, SDL_Texture **texture, const SDL_Rect *rect) {
+    if (list->count >= MAX_DEPTH_ENTRIES) {
+        fprintf(stderr, "Depth list full.\n");
+        return NULL;
+    }
+
+    // As entradas nunca mudam de lugar; só a ordem de desenho é reordenada.
+    int index = list->count++;
+    DepthEntry *entry = &list->entries[index];
+    *entry = (DepthEntry){texture, rect, rect->y + rect->h, true};
+    list->order[index] = index;
+
+    // Força a reordenação com a nova entrada.
+    entry->depth = INT_MIN;
+    depth_list_update(list);
+
+    return entry;
+}
+
+void depth_list_update(DepthList *list) {
+    bool moved = false;
+    for (int i = 0; i < list->count; i++) {
+        DepthEntry *entry = &list->entries[i];
+        int depth = entry->rect->y + entry->rect->h;
+        if (depth != entry->depth) {
+            entry->depth = depth;
+            moved = true;
         }
-        else {
-            anim->counter = 0;
+    }
+    if (!moved) return;
+
+    // Inserção em dados quase ordenados: sem trocas quando a câmera move todos juntos.
+    for (int i = 1; i < list->count; i++) {
+        int index = list->order[i];
+        int depth = list->entries[index].depth;
+        int j = i - 1;
+        while (j >= 0 && list->entries[list->order[j]].depth > depth) {
+            list->order[j + 1] = list->order[j];
+            j--;
         }
+        list->order[j + 1] = index;
     }
-
-    anim->counter %= anim->count;
-    return anim->frames[anim->counter];
 }
 
-bool rects_intersect(SDL_Rect *a, SDL_Rect *b, SDL_FRect *c) {
-    if (b) {
-        int leftX_A, leftX_B;
-        int topY_A, topY_B;
-        int rightX_A, rightX_B;
-        int bottomY_A, bottomY_B;
+void depth_list_queue(const DepthList *list, int layer) {
+    for (int i = 0; i < list->count; i++) {
+        const DepthEntry *entry = &list->entries[list->order[i]];
+        if (!entry->visible) continue;
+        queue_copy(*entry->texture, NULL, entry->rect, layer, entry->depth);
+    }
+}
 
-        leftX_A = a->x;
-        topY_A = a->y;
-        rightX_A = a->x + a->w;
-        bottomY_A = a->y + a->h;
+static bool clip_to_view(SDL_Texture *texture, SDL_Rect *src, bool *has_src, SDL_FRect *dst, SDL_RendererFlip flip) {
+    if (dst->w <= 0 || dst->h <= 0) return false;
+    if (dst->x >= SCREEN_WIDTH || dst->y >= SCREEN_HEIGHT || dst->x + dst->w <= 0 || dst->y + dst->h <= 0) return false;
+    if (dst->x >= 0 && dst->y >= 0 && dst->x + dst->w <= SCREEN_WIDTH && dst->y + dst->h <= SCREEN_HEIGHT) return true;
 
-        leftX_B = b->x;
-        topY_B = b->y;
-        rightX_B = b->x + b->w;
-        bottomY_B = b->y + b->h;
+    // Camadas maiores que a tela só enviam a região de textura que aparece.
+    if (!*has_src) {
+        *src = (SDL_Rect){0, 0, 0, 0};
+        if (SDL_QueryTexture(texture, NULL, NULL, &src->w, &src->h) != 0 || src->w <= 0 || src->h <= 0) return true;
+        *has_src = true;
+    }
 
-        if (leftX_A >= rightX_B)
-            return false;
+    clip_span(SCREEN_WIDTH, &dst->x, &dst->w, &src->x, &src->w, (flip & SDL_FLIP_HORIZONTAL) != 0);
+    clip_span(SCREEN_HEIGHT, &dst->y, &dst->h, &src->y, &src->h, (flip & SDL_FLIP_VERTICAL) != 0);
 
-        if (topY_A >= bottomY_B)
-            return false;
+    return src->w > 0 && src->h > 0;
+}
 
-        if (rightX_A <= leftX_B)
-            return false;
+static void clip_span(float view_size, float *pos, float *size, int *src_pos, int *src_size, bool flipped) {
+    float scale = *size / *src_size;
 
-        if (bottomY_A <= topY_B)
-            return false;
+    // Trecho visível em coordenadas locais do destino, convertido para texels.
+    float local_start = SDL_max(0.0f, -*pos);
+    float local_end = SDL_min(*size, view_size - *pos);
+    float texel_start = (flipped ? *size - local_end : local_start) / scale;
+    float texel_end = (flipped ? *size - local_start : local_end) / scale;
 
-        return true;
+    // Arredonda para texels inteiros e recalcula o destino a partir deles: a escala fica idêntica.
+    int first = SDL_max(0, (int)floorf(texel_start));
+    int last = SDL_min(*src_size, (int)ceilf(texel_end));
+    if (last <= first) {
+        *src_size = 0;
+        return;
     }
-    else if (c) {
-        int leftX_A, leftX_C;
-        int topY_A, topY_C;
-        int rightX_A, rightX_C;
-        int bottomY_A, bottomY_C;
 
-        leftX_A = a->x;
-        topY_A = a->y;
-        rightX_A = a->x + a->w;
-        bottomY_A = a->y + a->h;
+    float new_pos = flipped ? *pos + *size - last * scale : *pos + first * scale;
+    *pos = new_pos;
+    *size = (last - first) * scale;
+    *src_pos += first;
+    *src_size = last - first;
+}
 
-        leftX_C = c->x;
-        topY_C = c->y;
-        rightX_C = c->x + c->w;
-        bottomY_C = c->y + c->h;
+void queue_geometry(SDL_Texture *texture, const SDL_Vertex *vertices, int vertex_count, const int *indices, int index_count, int layer, int depth) {
+    if (!vertices || !indices || vertex_count <= 0 || index_count <= 0) return;
 
-        if (leftX_A >= rightX_C)
-            return false;
+    if (render_commands_count >= MAX_RENDER_COMMANDS) {
+        render_commands_dropped++;
+        return;
+    }
 
-        if (topY_A >= bottomY_C)
-            return false;
+    // Os vértices não são copiados: precisam continuar válidos até o flush do quadro.
+    RenderCommand *cmd = &render_commands[render_commands_count++];
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->type = RENDER_CMD_GEOMETRY;
+    cmd->layer = layer;
+    cmd->depth = depth;
+    cmd->sequence = render_commands_sequence++;
+    cmd->texture = texture;
+    cmd->vertices = vertices;
+    cmd->indices = indices;
+    cmd->vertex_count = vertex_count;
+    cmd->index_count = index_count;
+}
 
-        if (rightX_A <= leftX_C)
-            return false;
+static int render_command_cmp(const void *pa, const void *pb) {
+    const RenderCommand *a = *(const RenderCommand * const *)pa;
+    const RenderCommand *b = *(const RenderCommand * const *)pb;
 
-        if (bottomY_A <= topY_C)
-            return false;
+    if (a->layer != b->layer) return a->layer < b->layer ? -1 : 1;
+    if (a->depth != b->depth) return a->depth < b->depth ? -1 : 1;
+    if (a->type != b->type) return a->type < b->type ? -1 : 1;
+    if (a->texture != b->texture) return (uintptr_t)a->texture < (uintptr_t)b->texture ? -1 : 1;
+    if (a->blend != b->blend) return a->blend < b->blend ? -1 : 1;
+    if (a->sequence != b->sequence) return a->sequence < b->sequence ? -1 : 1;
 
-        return true;
-    }
+    return 0;
+}
 
-    return false;
+static bool same_render_state(const RenderCommand *a, const RenderCommand *b) {
+    // Geometria pronta já é um lote; nunca se junta a outros comandos.
+    if (a->type == RENDER_CMD_GEOMETRY || b->type == RENDER_CMD_GEOMETRY) return false;
+
+    return a->type == b->type && a->texture == b->texture && a->blend == b->blend &&
+           a->color.r == b->color.r && a->color.g == b->color.g && a->color.b == b->color.b && a->color.a == b->color.a;
 }
 
-bool check_collision(SDL_Rect *player, SDL_Rect boxes[], int box_count) {
-    for (int i = 0; i < box_count; i++) {
-        if (rects_intersect(player, &boxes[i], NULL)) return true;
+static void append_command_quad(const RenderCommand *cmd, int tex_w, int tex_h, SDL_Vertex *vertices, int *indices, int *vertex_count, int *index_count) {
+    SDL_Rect src = cmd->has_src ? cmd->src : (SDL_Rect){0, 0, tex_w, tex_h};
+    float u0 = (float)src.x / tex_w;
+    float v0 = (float)src.y / tex_h;
+    float u1 = (float)(src.x + src.w) / tex_w;
+    float v1 = (float)(src.y + src.h) / tex_h;
+
+    if (cmd->flip & SDL_FLIP_HORIZONTAL) { float t = u0; u0 = u1; u1 = t; }
+    if (cmd->flip & SDL_FLIP_VERTICAL) { float t = v0; v0 = v1; v1 = t; }
+
+    // Cantos relativos ao centro, girados na CPU como o SDL_RenderCopyEx faria.
+    float hw = cmd->dst.w * 0.5f;
+    float hh = cmd->dst.h * 0.5f;
+    float cx = cmd->dst.x + hw;
+    float cy = cmd->dst.y + hh;
+    SDL_FPoint corners[4] = {{-hw, -hh}, {hw, -hh}, {hw, hh}, {-hw, hh}};
+    SDL_FPoint uvs[4] = {{u0, v0}, {u1, v0}, {u1, v1}, {u0, v1}};
+
+    float c = 1.0f, s = 0.0f;
+    if (cmd->angle != 0.0) {
+        c = (float)cos(cmd->angle * M_PI / 180.0);
+        s = (float)sin(cmd->angle * M_PI / 180.0);
     }
 
-    return false;
+    int base = *vertex_count;
+    for (int k = 0; k < 4; k++) {
+        SDL_FPoint p = {cx + corners[k].x * c - corners[k].y * s, cy + corners[k].x * s + corners[k].y * c};
+        vertices[base + k] = (SDL_Vertex){p, cmd->color, uvs[k]};
+    }
+
+    indices[(*index_count)++] = base + 0;
+    indices[(*index_count)++] = base + 1;
+    indices[(*index_count)++] = base + 2;
+    indices[(*index_count)++] = base + 0;
+    indices[(*index_count)++] = base + 2;
+    indices[(*index_count)++] = base + 3;
+    *vertex_count += 4;
 }
 
-static int surface_to_sound_index(int surface_index) {
-    if (surface_index < 0 || surface_index > 12) return -1;
-    if (surface_index == 0 || surface_index == 1 || surface_index == 2) return 0;
-    if (surface_index == 3  || surface_index == 4 || surface_index == 5) return 1;
-    if (surface_index == 6) return 2;
-    if (surface_index == 7) return 3;
-    if (surface_index == 8) return 4;
-    if (surface_index == 9 || surface_index == 10 || surface_index == 11 || surface_index == 12) return 5;
+static void draw_render_range(SDL_Renderer *render, RenderCommand **sorted, int first, int last) {
+    static SDL_Vertex vertices[MAX_RENDER_COMMANDS * 4];
+    static int indices[MAX_RENDER_COMMANDS * 6];
+    static SDL_Rect rects[MAX_RENDER_COMMANDS];
 
-    return -1;
-}
+    int i = first;
+    while (i < last) {
+        int j = i + 1;
+        while (j < last && same_render_state(sorted[i], sorted[j])) j++;
 
-static int detect_surface(SDL_Rect *player, SDL_Rect surfaces[], int surface_count) {
-    SDL_Rect feet = {player->x, player->y + 29, player->w, 3};
+        const RenderCommand *first_cmd = sorted[i];
 
-    int best_index = -1;
-    int best_overlap = 0;
+        if (first_cmd->type == RENDER_CMD_FILL) {
+            for (int k = i; k < j; k++) {
+                rects[k - i] = (SDL_Rect){(int)sorted[k]->dst.x, (int)sorted[k]->dst.y, (int)sorted[k]->dst.w, (int)sorted[k]->dst.h};
+            }
 
-    for (int i = 0; i < surface_count; i++) {
-        SDL_Rect s = surfaces[i];
-
-        int ix = SDL_max(feet.x, s.x);
-        int iy = SDL_max(feet.y, s.y);
-        int ax = SDL_min(feet.x + feet.w, s.x + s.w);
-        int ay = SDL_min(feet.y + feet.h, s.y + s.h);
-
-        int overlap_w = ax - ix;
-        int overlap_h = ay - iy;
-        if (overlap_w > 0 && overlap_h > 0) {
-            int area = overlap_w * overlap_h;
-            if (area > best_overlap) {
-                best_overlap = area;
-                best_index = i;
+            SDL_SetRenderDrawBlendMode(render, first_cmd->blend);
+            SDL_SetRenderDrawColor(render, first_cmd->color.r, first_cmd->color.g, first_cmd->color.b, first_cmd->color.a);
+            SDL_RenderFillRects(render, rects, j - i);
+        }
+        else if (first_cmd->type == RENDER_CMD_GEOMETRY) {
+            SDL_RenderGeometry(render, first_cmd->texture, first_cmd->vertices, first_cmd->vertex_count, first_cmd->indices, first_cmd->index_count);
+        }
+        else {
+            Uint8 mod_r, mod_g, mod_b, mod_a;
+            SDL_GetTextureColorMod(first_cmd->texture, &mod_r, &mod_g, &mod_b);
+            SDL_GetTextureAlphaMod(first_cmd->texture, &mod_a);
+
+            if (j - i == 1) {
+                SDL_SetTextureColorMod(first_cmd->texture, first_cmd->color.r, first_cmd->color.g, first_cmd->color.b);
+                SDL_SetTextureAlphaMod(first_cmd->texture, first_cmd->color.a);
+                SDL_RenderCopyExF(render, first_cmd->texture, first_cmd->has_src ? &first_cmd->src : NULL, &first_cmd->dst, first_cmd->angle, NULL, first_cmd->flip);
+            }
+            else {
+                // Lote de quads da mesma textura: os modificadores vão para a cor dos vértices.
+                int tex_w, tex_h;
+                SDL_QueryTexture(first_cmd->texture, NULL, NULL, &tex_w, &tex_h);
+
+                int vertex_count = 0;
+                int index_count = 0;
+                for (int k = i; k < j; k++) {
+                    append_command_quad(sorted[k], tex_w, tex_h, vertices, indices, &vertex_count, &index_count);
+                }
+
+                SDL_SetTextureColorMod(first_cmd->texture, 255, 255, 255);
+                SDL_SetTextureAlphaMod(first_cmd->texture, 255);
+                SDL_RenderGeometry(render, first_cmd->texture, vertices, vertex_count, indices, index_count);
             }
+
+            SDL_SetTextureColorMod(first_cmd->texture, mod_r, mod_g, mod_b);
+            SDL_SetTextureAlphaMod(first_cmd->texture, mod_a);
         }
-    }
 
-    return best_index;
+        i = j;
+    }
 }
 
-void update_reflection(Player *original, Player* reflection, Animation *animation) {
-    reflection->facing = original->facing;
+static void draw_scaled_background(SDL_Renderer *render, RenderCommand **sorted, int count) {
+    SDL_Texture *scene = SDL_GetRenderTarget(render);
+    float scale = (float)render_pipeline.scale;
 
-    int current_frame = original->counters[original->facing];
+    if (SDL_SetRenderTarget(render, render_pipeline.background) != 0) {
+        draw_render_range(render, sorted, 0, count);
+        return;
+    }
 
-    reflection->texture = animation[reflection->facing].frames[current_frame];
+    // Mesmas coordenadas lógicas, só que ocupando o canto de scale x scale do alvo.
+    SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
+    SDL_RenderClear(render);
+    SDL_RenderSetScale(render, scale, scale);
+    draw_render_range(render, sorted, 0, count);
+    SDL_RenderSetScale(render, 1.0f, 1.0f);
+    SDL_SetRenderTarget(render, scene);
 
-    reflection->collision.x = original->collision.x;
-    reflection->collision.y = original->collision.y + original->collision.h;
-    reflection->collision.w = original->collision.w;
-    reflection->collision.h = original->collision.h;
+    SDL_Rect src = {0, 0, (int)SDL_ceil(SCREEN_WIDTH * scale), (int)SDL_ceil(SCREEN_HEIGHT * scale)};
+    SDL_RenderCopy(render, render_pipeline.background, &src, NULL);
 }
 
-static void track_texture(SDL_Texture *texture) {
-    if (!texture || already_tracked_texture(texture)) {
-        return;
+void flush_render_queue(SDL_Renderer *render) {
+    static RenderCommand *sorted[MAX_RENDER_COMMANDS];
+
+    // Estouro do buffer: um aviso por flush, não um por comando descartado.
+    if (render_commands_dropped > 0) {
+        fprintf(stderr, "Render command buffer full: %d commands dropped this frame.\n", render_commands_dropped);
+        render_commands_dropped = 0;
     }
 
-    if (guarded_textures_count >= guarded_textures_capacity) {
-        guarded_textures_capacity = guarded_textures_capacity ? guarded_textures_capacity * 2 : 64;
-        guarded_textures = realloc(guarded_textures, guarded_textures_capacity * sizeof(*guarded_textures));
+    if (render_commands_count == 0) return;
+
+    bool in_order = true;
+    for (int i = 0; i < render_commands_count; i++) {
+        sorted[i] = &render_commands[i];
+        if (i > 0 && in_order && render_command_cmp(&sorted[i - 1], &sorted[i]) > 0) in_order = false;
     }
 
-    guarded_textures[guarded_textures_count++] = texture;
-}
+    // Quem enfileira já em ordem (como a lista de profundidade) não paga a ordenação.
+    if (!in_order) {
+        qsort(sorted, render_commands_count, sizeof(sorted[0]), render_command_cmp);
+    }
 
-static bool already_tracked_texture(SDL_Texture *texture) {
-    for (int i = 0; i < guarded_textures_count; i++) {
-        if (guarded_textures[i] == texture) {
-            return true;
-        }
+    Uint8 old_r, old_g, old_b, old_a;
+    SDL_BlendMode old_blend;
+    SDL_GetRenderDrawColor(render, &old_r, &old_g, &old_b, &old_a);
+    SDL_GetRenderDrawBlendMode(render, &old_blend);
+
+    // O passe de fundo vem primeiro na ordenação; só ele desce de resolução sob carga.
+    int background_count = 0;
+    while (background_count < render_commands_count && sorted[background_count]->layer == LAYER_BACKGROUND) background_count++;
+
+    int first = 0;
+    if (background_count > 0 && render_pipeline.background && render_pipeline.scale < 1.0 && SDL_GetRenderTarget(render) == render_pipeline.scene) {
+        draw_scaled_background(render, sorted, background_count);
+        first = background_count;
     }
+    draw_render_range(render, sorted, first, render_commands_count);
 
-    return false;
+    SDL_SetRenderDrawColor(render, old_r, old_g, old_b, old_a);
+    SDL_SetRenderDrawBlendMode(render, old_blend);
+
+    render_commands_count = 0;
+    render_commands_sequence = 0;
 }
 
-static void track_chunk(Mix_Chunk *chunk) {
-    if (!chunk || already_tracked_chunk(chunk)) {
-        return;
+
+bool compile_dialogue(Dialogue *dialogue) {
+    int line_count = 0;
+    while (line_count < MAX_DIALOGUE_STR && dialogue->writings[line_count]) line_count++;
+
+    if (text_scripts_used + line_count > MAX_TEXT_SCRIPTS) {
+        fprintf(stderr, "Compiled dialogue line limit reached.\n");
+        return false;
     }
 
-    if (guarded_chunks_count >= guarded_chunks_capacity) {
-        guarded_chunks_capacity = guarded_chunks_capacity ? guarded_chunks_capacity * 2 : 64;
-        guarded_chunks = realloc(guarded_chunks, guarded_chunks_capacity * sizeof(*guarded_chunks));
+    TextScript *scripts = &text_scripts_pool[text_scripts_used];
+    for (int i = 0; i < line_count; i++) {
+        if (!compile_text_script(dialogue->writings[i], &scripts[i])) {
+            return false;
+        }
     }
 
-    guarded_chunks[guarded_chunks_count++] = chunk;
+    text_scripts_used += line_count;
+    dialogue->scripts = scripts;
+    return true;
 }
 
-static bool already_tracked_chunk(Mix_Chunk *chunk) {
-    for (int i = 0; i < guarded_chunks_count; i++) {
-        if (guarded_chunks[i] == chunk) {
-            return true;
+void escape_markup(const char *source, char *dest, size_t size) {
+    if (size == 0) return;
+
+    size_t len = 0;
+    for (const char *c = source; *c != '\0'; c++) {
+        bool special = (*c == '{' || *c == '}' || *c == '\\');
+        if (len + (special ? 2 : 1) >= size) break;
+
+        if (special) dest[len++] = '\\';
+        dest[len++] = *c;
+    }
+    dest[len] = '\0';
+}
+
+static bool compile_text_script(const char *source, TextScript *script) {
+    int start = text_ops_used;
+
+    for (const char *c = source; *c != '\0';) {
+        if (text_ops_used >= MAX_TEXT_OPS) {
+            fprintf(stderr, "Text op limit reached in: %s\n", source);
+            return false;
+        }
+
+        TextOp *op = &text_ops_pool[text_ops_used];
+        memset(op, 0, sizeof(*op));
+
+        // MARCAÇÃO: {p=0.5} pausa, {s=2} velocidade, {c=RRGGBB} / {c} cor, {f=python} falante.
+        // Uma chave sem fechamento é tratada como texto comum; \{, \} e \\ são literais.
+        if (*c == '\\' && (c[1] == '{' || c[1] == '}' || c[1] == '\\')) c++;
+        else if (*c == '{') {
+            const char *end = strchr(c, '}');
+            if (end && (size_t)(end - c - 1) < 32) {
+                char tag[32];
+                size_t len = (size_t)(end - c - 1);
+
+                memcpy(tag, c + 1, len);
+                tag[len] = '\0';
+                c = end + 1;
+
+                if (parse_text_tag(tag, op)) {
+                    text_ops_used++;
+                }
+                else {
+                    fprintf(stderr, "Unknown markup tag {%s} ignored in: %s\n", tag, source);
+                }
+                continue;
+            }
         }
+
+        int n = utf8_copy_char(c, op->utf8);
+        op->codepoint = utf8_decode(c);
+        if (op->codepoint == '|') op->type = TEXT_OP_NEWLINE;
+        else if (op->codepoint == ' ') op->type = TEXT_OP_SPACE;
+        else op->type = TEXT_OP_CHAR;
+
+        text_ops_used++;
+        c += n;
     }
 
-    return false;
+    script->ops = &text_ops_pool[start];
+    script->count = text_ops_used - start;
+    return true;
 }
 
-static void track_font(TTF_Font *font) {
-    if (!font || already_tracked_font(font)) {
-        return;
-    }
+static bool parse_text_tag(const char *tag, TextOp *op) {
+    const char *value = (tag[0] != '\0' && tag[1] == '=') ? tag + 2 : NULL;
+
+    switch (tag[0]) {
+        case 'p':
+            if (!value) return false;
+            op->type = TEXT_OP_PAUSE;
+            op->value = strtof(value, NULL);
+            return op->value > 0.0f;
+        case 's':
+            if (!value) return false;
+            op->type = TEXT_OP_SPEED;
+            op->value = strtof(value, NULL);
+            return op->value > 0.0f;
+        case 'c':
+            if (!value) {
+                op->type = TEXT_OP_COLOR_RESET;
+                return tag[1] == '\0';
+            }
+            else {
+                char *end;
+                unsigned long rgb = strtoul(value, &end, 16);
+                if (*end != '\0' || end - value != 6) return false;
 
-    if (guarded_fonts_count >= guarded_fonts_capacity) {
-        guarded_fonts_capacity = guarded_fonts_capacity ? guarded_fonts_capacity * 2 : 32;
-        guarded_fonts = realloc(guarded_fonts, guarded_fonts_capacity * sizeof(*guarded_fonts));
-    }
+                op->type = TEXT_OP_COLOR;
+                op->color = (SDL_Color){(rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF, 255};
+                return true;
+            }
+        case 'f': {
+            static const struct { const char *name; int face; } speakers[] = {
+                {"meneghetti", FACE_MENEGHETTI}, {"angry", FACE_MENEGHETTI_ANGRY}, {"sad", FACE_MENEGHETTI_SAD},
+                {"python", FACE_PYTHON}, {"chatgpt", FACE_CHATGPT}, {"none", FACE_NONE}, {"bubble", FACE_BUBBLE}
+            };
 
-    guarded_fonts[guarded_fonts_count++] = font;
+            if (!value) return false;
+            for (size_t i = 0; i < sizeof(speakers) / sizeof(speakers[0]); i++) {
+                if (strcmp(value, speakers[i].name) == 0) {
+                    op->type = TEXT_OP_SPEAKER;
+                    op->value = (float)speakers[i].face;
+                    return true;
+                }
+            }
+            return false;
+        }
+        default:
+            return false;
+    }
 }
 
-static bool already_tracked_font(TTF_Font *font) {
-    for (int i = 0; i < guarded_fonts_count; i++) {
-        if (guarded_fonts[i] == font) {
-            return true;
+static GlyphCache *get_glyph_cache(TTF_Font *font) {
+    if (!font) return NULL;
+
+    for (int i = 0; i < glyph_caches_count; i++) {
+        if (glyph_caches[i].font == font) {
+            return &glyph_caches[i];
         }
     }
 
-    return false;
+    if (glyph_caches_count >= MAX_GLYPH_CACHES) {
+        fprintf(stderr, "Glyph cache limit reached.\n");
+        return NULL;
+    }
+
+    GlyphCache *cache = &glyph_caches[glyph_caches_count++];
+    memset(cache, 0, sizeof(*cache));
+    cache->font = font;
+    return cache;
 }
 
-void game_cleanup(Game *game, int exit_status) {
-    Mix_HaltMusic();
-    
-    for (int i = -1; i <= MIX_CHANNELS; i++) {
-        Mix_HaltChannel(i);
+static Glyph *find_glyph(GlyphCache *cache, Uint32 codepoint, bool create) {
+    if (codepoint < GLYPH_CACHE_SIZE) {
+        return &cache->glyphs[codepoint];
     }
 
-    Mix_CloseAudio();
-
-    clean_tracked_resources();
-    SDL_DestroyRenderer(game->renderer);
-    SDL_DestroyWindow(game->window);
+    for (int i = 0; i < cache->extra_count; i++) {
+        if (cache->extra_codepoints[i] == codepoint) {
+            return &cache->extra_glyphs[i];
+        }
+    }
 
-    TTF_Quit();
-    Mix_Quit();
-    IMG_Quit();
-    SDL_Quit();
+    if (!create || cache->extra_count >= GLYPH_CACHE_EXTRA) return NULL;
 
-    exit(exit_status);
+    cache->extra_codepoints[cache->extra_count] = codepoint;
+    Glyph *glyph = &cache->extra_glyphs[cache->extra_count++];
+    memset(glyph, 0, sizeof(*glyph));
+    return glyph;
 }
 
-void clean_tracked_resources(void) {
-    for (int i = 0; i < guarded_textures_count; i++) {
-        if (guarded_textures[i]) {
-            SDL_DestroyTexture(guarded_textures[i]);
-        }
+static const Glyph *cache_glyph(SDL_Renderer *render, GlyphCache *cache, Uint32 codepoint, const char *utf8_char) {
+    Glyph *glyph = find_glyph(cache, codepoint, true);
+    if (!glyph) {
+        fprintf(stderr, "Glyph cache full for U+%04X.\n", (unsigned)codepoint);
+        return NULL;
     }
-    free(guarded_textures);
-    guarded_textures = NULL;
-    guarded_textures_count = guarded_textures_capacity = 0;
 
-    for (int i = 0; i < guarded_chunks_count; i++) {
-        if (guarded_chunks[i]) {
-            Mix_FreeChunk(guarded_chunks[i]);
+    if (glyph->loaded) return glyph;
+    glyph->loaded = true;
+
+    if (!cache->atlas) {
+        cache->atlas = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE);
+        if (!cache->atlas) {
+            fprintf(stderr, "Error creating glyph atlas: %s\n", SDL_GetError());
+            return glyph;
         }
+        SDL_SetTextureBlendMode(cache->atlas, SDL_BLENDMODE_BLEND);
+        track_texture(cache->atlas);
     }
-    free(guarded_chunks);
-    guarded_chunks = NULL;
-    guarded_chunks_count = guarded_chunks_capacity = 0;
 
-    for (int i = 0; i < guarded_fonts_count; i++) {
-        if (guarded_fonts[i]) {
-            TTF_CloseFont(guarded_fonts[i]);
-        }
+    // Glifo branco: a cor vem do vértice na hora de desenhar.
+    SDL_Surface *surface = TTF_RenderUTF8_Solid(cache->font, utf8_char, (SDL_Color){255, 255, 255, 255});
+    if (!surface) {
+        fprintf(stderr, "Error loading glyph surface (text '%s'): %s\n", utf8_char, TTF_GetError());
+        return glyph;
     }
-    free(guarded_fonts);
-    guarded_fonts = NULL;
-    guarded_fonts_count = guarded_fonts_capacity = 0;
+
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(surface);
+    if (!converted) {
+        fprintf(stderr, "Error converting glyph surface: %s\n", SDL_GetError());
+        return glyph;
+    }
+
+    if (cache->pen_x + converted->w > GLYPH_ATLAS_SIZE) {
+        cache->pen_x = 0;
+        cache->pen_y += cache->row_h + 1;
+        cache->row_h = 0;
+    }
+    if (cache->pen_y + converted->h > GLYPH_ATLAS_SIZE) {
+        fprintf(stderr, "Glyph atlas full for U+%04X.\n", (unsigned)codepoint);
+        SDL_FreeSurface(converted);
+        return glyph;
+    }
+
+    glyph->src = (SDL_Rect){cache->pen_x, cache->pen_y, converted->w, converted->h};
+    glyph->w = converted->w;
+    glyph->h = converted->h;
+    SDL_UpdateTexture(cache->atlas, &glyph->src, converted->pixels, converted->pitch);
+
+    cache->pen_x += converted->w + 1;
+    if (converted->h > cache->row_h) cache->row_h = converted->h;
+
+    SDL_FreeSurface(converted);
+    return glyph;
 }
 
 static int utf8_charlen(const char *s) {
     unsigned char c = (unsigned char)s[0];
-    if ((c & 0x80) == 0x00) return 1;
-    if ((c & 0xE0) == 0xC0) return 2;
-    if ((c & 0xF0) == 0xE0) return 3;
-    if ((c & 0xF8) == 0xF0) return 4;
-
-    return 1;
+    int n = 1;
+    if ((c & 0xE0) == 0xC0) n = 2;
+    else if ((c & 0xF0) == 0xE0) n = 3;
+    else if ((c & 0xF8) == 0xF0) n = 4;
+
+    // Sequência cortada ou malformada (ex.: nome truncado pelo snprintf) vale um byte só, sem passar do '\0'.
+    for (int i = 1; i < n; i++) {
+        if (((unsigned char)s[i] & 0xC0) != 0x80) return 1;
+    }
+    return n;
 }
 
 static int utf8_copy_char(const char *s, char *out) {
@@ -4340,6 +8188,18 @@ static int utf8_copy_char(const char *s, char *out) {
     return n;
 }
 
+static Uint32 utf8_decode(const char *s) {
+    const unsigned char *u = (const unsigned char *)s;
+    int n = utf8_charlen(s);
+
+    switch (n) {
+        case 2: return ((Uint32)(u[0] & 0x1F) << 6) | (u[1] & 0x3F);
+        case 3: return ((Uint32)(u[0] & 0x0F) << 12) | ((Uint32)(u[1] & 0x3F) << 6) | (u[2] & 0x3F);
+        case 4: return ((Uint32)(u[0] & 0x07) << 18) | ((Uint32)(u[1] & 0x3F) << 12) | ((Uint32)(u[2] & 0x3F) << 6) | (u[3] & 0x3F);
+        default: return u[0];
+    }
+}
+
 char *utf8_to_upper(const char *s) {
     if (!s) return NULL;
     setlocale(LC_CTYPE, ""); /* usa a localidade do sistema */
@@ -4366,18 +8226,6 @@ char *utf8_to_upper(const char *s) {
     return out;
 }
 
-int renderitem_cmp(const void *pa, const void *pb) {
-    const RenderItem *a = (const RenderItem *)pa;
-    const RenderItem *b = (const RenderItem *)pb;
-
-    int da = a->collisions->y + a->collisions->h;
-    int db = b->collisions->y + b->collisions->h;
-    if (da < db) return -1;
-    if (da > db) return 1;
-    
-    return 0;
-}
-
 int randint(int min, int max) {
     return min + rand() % (max - min + 1);
 }
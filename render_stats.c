@@ -0,0 +1,256 @@
+#define RENDER_STATS_IMPLEMENTATION
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "render_stats.h"
+
+#define HEATMAP_CELL 8
+#define HEATMAP_LEVELS 5
+
+typedef struct {
+    bool recording;
+    int scene;
+    RenderStats frame;
+    RenderStats scenes[RENDER_STATS_SCENES];
+
+    // Estado do último desenho, para contar só as trocas de fato.
+    SDL_Texture *last_texture;
+    SDL_BlendMode last_blend;
+    bool has_last;
+
+    // Alvo atual e seu tamanho, usados para recortar os pixels cobertos.
+    SDL_Texture *target;
+    int target_w;
+    int target_h;
+
+    // Mapa de overdraw: só desenhos no alvo do quadro entram, em células de HEATMAP_CELL pixels.
+    SDL_Texture *frame_target;
+    int frame_w;
+    int frame_h;
+    bool heatmap;
+    int columns;
+    int rows;
+    float *coverage;
+    SDL_Rect *cells;
+} StatsState;
+
+static StatsState stats = {.scene = 0};
+
+// CONTAGEM:
+static void refresh_target_size(SDL_Renderer *render) {
+    stats.target_w = stats.target_h = 0;
+    if (stats.target) {
+        SDL_QueryTexture(stats.target, NULL, NULL, &stats.target_w, &stats.target_h);
+        return;
+    }
+
+    // Na tela, com tamanho lógico ativo, as coordenadas dos desenhos são lógicas.
+    SDL_RenderGetLogicalSize(render, &stats.target_w, &stats.target_h);
+    if (stats.target_w == 0 || stats.target_h == 0) {
+        SDL_GetRendererOutputSize(render, &stats.target_w, &stats.target_h);
+    }
+}
+
+static void count_state(SDL_Renderer *render, SDL_Texture *texture) {
+    SDL_BlendMode blend = SDL_BLENDMODE_NONE;
+    if (texture) SDL_GetTextureBlendMode(texture, &blend);
+    else SDL_GetRenderDrawBlendMode(render, &blend);
+
+    stats.frame.draw_calls++;
+    if (stats.has_last && texture != stats.last_texture) stats.frame.texture_switches++;
+    if (stats.has_last && blend != stats.last_blend) stats.frame.blend_changes++;
+    stats.last_texture = texture;
+    stats.last_blend = blend;
+    stats.has_last = true;
+}
+
+// Soma uma área (com peso 0..1 de preenchimento) nas células que ela toca.
+static void add_coverage(float x0, float y0, float x1, float y1, float weight) {
+    if (x0 < 0.0f) x0 = 0.0f;
+    if (y0 < 0.0f) y0 = 0.0f;
+    if (x1 > (float)stats.target_w) x1 = (float)stats.target_w;
+    if (y1 > (float)stats.target_h) y1 = (float)stats.target_h;
+    if (x1 <= x0 || y1 <= y0) return;
+
+    stats.frame.pixels += (Uint64)((x1 - x0) * (y1 - y0) * weight);
+
+    if (!stats.heatmap || !stats.coverage || stats.target != stats.frame_target) return;
+
+    int cx0 = (int)x0 / HEATMAP_CELL, cx1 = SDL_min(((int)x1 - 1) / HEATMAP_CELL, stats.columns - 1);
+    int cy0 = (int)y0 / HEATMAP_CELL, cy1 = SDL_min(((int)y1 - 1) / HEATMAP_CELL, stats.rows - 1);
+    const float cell_area = (float)(HEATMAP_CELL * HEATMAP_CELL);
+    for (int cy = cy0; cy <= cy1; cy++) {
+        float top = SDL_max(y0, (float)(cy * HEATMAP_CELL));
+        float bottom = SDL_min(y1, (float)((cy + 1) * HEATMAP_CELL));
+        for (int cx = cx0; cx <= cx1; cx++) {
+            float left = SDL_max(x0, (float)(cx * HEATMAP_CELL));
+            float right = SDL_min(x1, (float)((cx + 1) * HEATMAP_CELL));
+            stats.coverage[cy * stats.columns + cx] += (right - left) * (bottom - top) * weight / cell_area;
+        }
+    }
+}
+
+static void add_rect(SDL_Renderer *render, SDL_Texture *texture, float x, float y, float w, float h) {
+    if (!stats.recording) return;
+    count_state(render, texture);
+    add_coverage(x, y, x + w, y + h, 1.0f);
+}
+
+// INTERFACE:
+void render_stats_begin_frame(int scene) {
+    stats.recording = true;
+    stats.scene = SDL_clamp(scene, 0, RENDER_STATS_SCENES - 1);
+    memset(&stats.frame, 0, sizeof(stats.frame));
+    stats.has_last = false;
+    // O alvo é seguido mesmo fora da gravação; só falta o tamanho se ninguém o trocou ainda.
+    if (stats.target_w == 0 || stats.target_h == 0) {
+        stats.target_w = stats.frame_w;
+        stats.target_h = stats.frame_h;
+    }
+    if (stats.coverage) memset(stats.coverage, 0, (size_t)stats.columns * stats.rows * sizeof(float));
+}
+
+void render_stats_end_frame(void) {
+    if (!stats.recording) return;
+    stats.scenes[stats.scene] = stats.frame;
+    stats.recording = false;
+}
+
+const RenderStats *render_stats_scene(int scene) {
+    return &stats.scenes[SDL_clamp(scene, 0, RENDER_STATS_SCENES - 1)];
+}
+
+bool render_stats_set_frame_target(SDL_Texture *target, int width, int height) {
+    render_stats_quit();
+    stats.frame_target = target;
+    stats.frame_w = width;
+    stats.frame_h = height;
+    stats.columns = (width + HEATMAP_CELL - 1) / HEATMAP_CELL;
+    stats.rows = (height + HEATMAP_CELL - 1) / HEATMAP_CELL;
+    stats.coverage = calloc((size_t)stats.columns * stats.rows, sizeof(float));
+    stats.cells = malloc((size_t)stats.columns * stats.rows * sizeof(SDL_Rect));
+    if (!stats.coverage || !stats.cells) {
+        fprintf(stderr, "Error allocating overdraw heatmap.\n");
+        render_stats_quit();
+        return false;
+    }
+    return true;
+}
+
+void render_stats_toggle_heatmap(void) {
+    stats.heatmap = !stats.heatmap;
+}
+
+void render_stats_draw_heatmap(SDL_Renderer *render) {
+    if (!stats.heatmap || !stats.coverage) return;
+
+    // Azul = 1 camada, verde = 2, amarelo = 3, laranja = 4, vermelho = 5 ou mais.
+    static const SDL_Color ramp[HEATMAP_LEVELS] = {
+        {0, 64, 255, 150}, {0, 200, 64, 150}, {255, 230, 0, 160}, {255, 128, 0, 170}, {255, 0, 0, 180}
+    };
+
+    // Um lote por cor, desenhado com as funções reais do SDL: o próprio mapa não entra nos contadores.
+    SDL_SetRenderDrawBlendMode(render, SDL_BLENDMODE_BLEND);
+    for (int level = 0; level < HEATMAP_LEVELS; level++) {
+        int count = 0;
+        for (int cy = 0; cy < stats.rows; cy++) {
+            for (int cx = 0; cx < stats.columns; cx++) {
+                float layers = stats.coverage[cy * stats.columns + cx];
+                if (layers < 0.5f || SDL_min((int)(layers + 0.5f), HEATMAP_LEVELS) - 1 != level) continue;
+                stats.cells[count++] = (SDL_Rect){cx * HEATMAP_CELL, cy * HEATMAP_CELL, HEATMAP_CELL, HEATMAP_CELL};
+            }
+        }
+        if (count == 0) continue;
+        SDL_SetRenderDrawColor(render, ramp[level].r, ramp[level].g, ramp[level].b, ramp[level].a);
+        SDL_RenderFillRects(render, stats.cells, count);
+    }
+}
+
+void render_stats_quit(void) {
+    free(stats.coverage);
+    free(stats.cells);
+    stats.coverage = NULL;
+    stats.cells = NULL;
+}
+
+// FUNÇÕES INTERPOSTAS:
+int stats_render_clear(SDL_Renderer *render) {
+    if (stats.recording) {
+        count_state(render, NULL);
+        add_coverage(0.0f, 0.0f, (float)stats.target_w, (float)stats.target_h, 1.0f);
+    }
+    return SDL_RenderClear(render);
+}
+
+int stats_render_copy(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst) {
+    if (dst) add_rect(render, texture, (float)dst->x, (float)dst->y, (float)dst->w, (float)dst->h);
+    else add_rect(render, texture, 0.0f, 0.0f, (float)stats.target_w, (float)stats.target_h);
+    return SDL_RenderCopy(render, texture, src, dst);
+}
+
+int stats_render_copy_f(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst) {
+    if (dst) add_rect(render, texture, dst->x, dst->y, dst->w, dst->h);
+    else add_rect(render, texture, 0.0f, 0.0f, (float)stats.target_w, (float)stats.target_h);
+    return SDL_RenderCopyF(render, texture, src, dst);
+}
+
+// A rotação é ignorada na área: os sprites girados do jogo são pequenos.
+int stats_render_copy_ex(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst, double angle, const SDL_Point *center, SDL_RendererFlip flip) {
+    if (dst) add_rect(render, texture, (float)dst->x, (float)dst->y, (float)dst->w, (float)dst->h);
+    else add_rect(render, texture, 0.0f, 0.0f, (float)stats.target_w, (float)stats.target_h);
+    return SDL_RenderCopyEx(render, texture, src, dst, angle, center, flip);
+}
+
+int stats_render_copy_ex_f(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst, double angle, const SDL_FPoint *center, SDL_RendererFlip flip) {
+    if (dst) add_rect(render, texture, dst->x, dst->y, dst->w, dst->h);
+    else add_rect(render, texture, 0.0f, 0.0f, (float)stats.target_w, (float)stats.target_h);
+    return SDL_RenderCopyExF(render, texture, src, dst, angle, center, flip);
+}
+
+int stats_render_fill_rect(SDL_Renderer *render, const SDL_Rect *rect) {
+    if (rect) add_rect(render, NULL, (float)rect->x, (float)rect->y, (float)rect->w, (float)rect->h);
+    else add_rect(render, NULL, 0.0f, 0.0f, (float)stats.target_w, (float)stats.target_h);
+    return SDL_RenderFillRect(render, rect);
+}
+
+int stats_render_fill_rects(SDL_Renderer *render, const SDL_Rect *rects, int count) {
+    if (stats.recording && count > 0) {
+        count_state(render, NULL);
+        for (int i = 0; i < count; i++) {
+            add_coverage((float)rects[i].x, (float)rects[i].y, (float)(rects[i].x + rects[i].w), (float)(rects[i].y + rects[i].h), 1.0f);
+        }
+    }
+    return SDL_RenderFillRects(render, rects, count);
+}
+
+int stats_render_geometry(SDL_Renderer *render, SDL_Texture *texture, const SDL_Vertex *vertices, int vertex_count, const int *indices, int index_count) {
+    if (stats.recording && vertices) {
+        count_state(render, texture);
+
+        // Cada triângulo cobre a própria área, espalhada pela caixa que o contém.
+        int count = indices ? index_count : vertex_count;
+        for (int i = 0; i + 2 < count; i += 3) {
+            const SDL_FPoint *a = &vertices[indices ? indices[i] : i].position;
+            const SDL_FPoint *b = &vertices[indices ? indices[i + 1] : i + 1].position;
+            const SDL_FPoint *c = &vertices[indices ? indices[i + 2] : i + 2].position;
+
+            float area = fabsf((b->x - a->x) * (c->y - a->y) - (c->x - a->x) * (b->y - a->y)) * 0.5f;
+            float x0 = SDL_min(a->x, SDL_min(b->x, c->x)), x1 = SDL_max(a->x, SDL_max(b->x, c->x));
+            float y0 = SDL_min(a->y, SDL_min(b->y, c->y)), y1 = SDL_max(a->y, SDL_max(b->y, c->y));
+            float box = (x1 - x0) * (y1 - y0);
+            if (box > 0.0f) add_coverage(x0, y0, x1, y1, area / box);
+        }
+    }
+    return SDL_RenderGeometry(render, texture, vertices, vertex_count, indices, index_count);
+}
+
+int stats_set_render_target(SDL_Renderer *render, SDL_Texture *texture) {
+    int result = SDL_SetRenderTarget(render, texture);
+    if (result == 0) {
+        stats.target = texture;
+        refresh_target_size(render);
+    }
+    return result;
+}
@@ -0,0 +1,48 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+#define RENDER_STATS_SCENES 16
+
+typedef struct {
+    Uint32 draw_calls;
+    Uint32 texture_switches;
+    Uint32 blend_changes;
+    Uint64 pixels;
+} RenderStats;
+
+void render_stats_begin_frame(int scene);
+void render_stats_end_frame(void);
+const RenderStats *render_stats_scene(int scene);
+bool render_stats_set_frame_target(SDL_Texture *target, int width, int height);
+void render_stats_toggle_heatmap(void);
+void render_stats_draw_heatmap(SDL_Renderer *render);
+void render_stats_quit(void);
+
+int stats_render_clear(SDL_Renderer *render);
+int stats_render_copy(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst);
+int stats_render_copy_f(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst);
+int stats_render_copy_ex(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst, double angle, const SDL_Point *center, SDL_RendererFlip flip);
+int stats_render_copy_ex_f(SDL_Renderer *render, SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst, double angle, const SDL_FPoint *center, SDL_RendererFlip flip);
+int stats_render_fill_rect(SDL_Renderer *render, const SDL_Rect *rect);
+int stats_render_fill_rects(SDL_Renderer *render, const SDL_Rect *rects, int count);
+int stats_render_geometry(SDL_Renderer *render, SDL_Texture *texture, const SDL_Vertex *vertices, int vertex_count, const int *indices, int index_count);
+int stats_set_render_target(SDL_Renderer *render, SDL_Texture *texture);
+
+// Quem inclui este cabeçalho passa a desenhar pelos contadores; render_stats.c chama o SDL direto.
+// Macros variádicas porque os argumentos podem ser compound literals com vírgulas.
+#ifndef RENDER_STATS_IMPLEMENTATION
+    #define SDL_RenderClear(...) stats_render_clear(__VA_ARGS__)
+    #define SDL_RenderCopy(...) stats_render_copy(__VA_ARGS__)
+    #define SDL_RenderCopyF(...) stats_render_copy_f(__VA_ARGS__)
+    #define SDL_RenderCopyEx(...) stats_render_copy_ex(__VA_ARGS__)
+    #define SDL_RenderCopyExF(...) stats_render_copy_ex_f(__VA_ARGS__)
+    #define SDL_RenderFillRect(...) stats_render_fill_rect(__VA_ARGS__)
+    #define SDL_RenderFillRects(...) stats_render_fill_rects(__VA_ARGS__)
+    #define SDL_RenderGeometry(...) stats_render_geometry(__VA_ARGS__)
+    #define SDL_SetRenderTarget(...) stats_set_render_target(__VA_ARGS__)
+#endif
+
+#endif